@@ -0,0 +1,172 @@
+#include "AdvPolicy.h"
+#include "app_util.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define ADV_POLICY_RATE_ONE 65536UL     /**< Change rate of every sample changing. */
+#define ADV_POLICY_EWMA_SHIFT 5         /**< Smoothing factor of 1/32, about the last 32 samples. */
+#define ADV_POLICY_PERCENT_TO_RATE(p) ((uint32_t)(p) * ADV_POLICY_RATE_ONE / 100)
+#define ADV_POLICY_SECONDS_PER_DAY 86400UL
+
+STATIC_ASSERT(ADV_POLICY_FAST_INTERVAL_MS >= 100);     // Minimum for non-connectable legacy advertising.
+STATIC_ASSERT(ADV_POLICY_SLOW_INTERVAL_MS <= 10240);   // Maximum for legacy advertising.
+STATIC_ASSERT(ADV_POLICY_FAST_INTERVAL_MS <= ADV_POLICY_NORMAL_INTERVAL_MS);
+STATIC_ASSERT(ADV_POLICY_NORMAL_INTERVAL_MS <= ADV_POLICY_SLOW_INTERVAL_MS);
+STATIC_ASSERT(ADV_POLICY_SLOW_THRESHOLD * 2 < ADV_POLICY_FAST_THRESHOLD);  // The hysteresis bands must not overlap.
+
+typedef struct
+{
+    ADV_POLICY_CLASS mClass;
+    ADV_POLICY_CLASS mCandidate;   // Class the readings call for, applied once it has held long enough.
+    uint16_t mCandidateSamples;
+    bool mHasReadings;
+    int16_t mTemperature;          // Readings at the last change.
+    int16_t mHumidity;
+    uint32_t mRate;                // Smoothed fraction of samples that changed, ADV_POLICY_RATE_ONE being all of them.
+    uint8_t mBatteryPercent;
+    uint32_t mSampleCount[ADV_POLICY_CLASS_COUNT];
+    uint32_t mChangeCount;
+} AdvPolicy;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static ADV_POLICY_CLASS AdvPolicy_Evaluate(AdvPolicy *this);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static AdvPolicy advPolicy;
+
+static uint32_t const m_interval_ms[ADV_POLICY_CLASS_COUNT] =
+{
+    ADV_POLICY_FAST_INTERVAL_MS,
+    ADV_POLICY_NORMAL_INTERVAL_MS,
+    ADV_POLICY_SLOW_INTERVAL_MS,
+};
+
+/**@brief Starts in the fast class with a full battery, until readings and battery level say otherwise. */
+void AdvPolicy_Init(void) {
+    memset(&advPolicy, 0, sizeof(advPolicy));
+    advPolicy.mClass = ADV_POLICY_CLASS_FAST;
+    advPolicy.mCandidate = ADV_POLICY_CLASS_FAST;
+    advPolicy.mBatteryPercent = 100;
+}
+
+/**@brief Feeds one sample. Values are in 0.01 units.
+ *
+ * @details A sample changes when it leaves the advertising deadband around the last change, so sensor noise
+ *          does not count and the rate is the smoothed fraction of samples that changed. A move to a faster class applies at once, so that an excursion is advertised quickly.
+ *          A move to a slower class applies once it has been called for during ADV_POLICY_HOLD_SAMPLES
+ *          samples in a row, so that a short pause does not make the interval flap.
+ *
+ * @retval true  The class changed, the advertising interval has to follow.
+ * @retval false The class did not change.
+ */
+bool AdvPolicy_Update(int16_t temperature, int16_t humidity) {
+    AdvPolicy *this = &advPolicy;
+
+    bool changed = !this->mHasReadings ||
+                   abs(temperature - this->mTemperature) > ADVERTISING_DEADBAND_TEMPERATURE ||
+                   abs(humidity - this->mHumidity) > ADVERTISING_DEADBAND_HUMIDITY;
+    if (changed) {
+        this->mHasReadings = true;
+        this->mTemperature = temperature;
+        this->mHumidity = humidity;
+    }
+    int32_t delta = (int32_t)(changed ? ADV_POLICY_RATE_ONE : 0) - (int32_t)this->mRate;
+    this->mRate = (uint32_t)((int32_t)this->mRate + (delta / (1 << ADV_POLICY_EWMA_SHIFT)));
+    this->mSampleCount[this->mClass]++;
+
+    ADV_POLICY_CLASS candidate = AdvPolicy_Evaluate(this);
+    if (candidate != this->mCandidate) {
+        this->mCandidate = candidate;
+        this->mCandidateSamples = 0;
+    }
+    if (this->mCandidateSamples < UINT16_MAX) {
+        this->mCandidateSamples++;
+    }
+
+    if (candidate == this->mClass || (candidate > this->mClass && this->mCandidateSamples < ADV_POLICY_HOLD_SAMPLES)) {
+        return false;
+    }
+
+    this->mClass = candidate;
+    this->mChangeCount++;
+    return true;
+}
+
+/**@brief Battery level in percent, taken into account from the next sample. */
+void AdvPolicy_SetBatteryLevel(uint8_t percent) {
+    advPolicy.mBatteryPercent = percent;
+}
+
+ADV_POLICY_CLASS AdvPolicy_GetClass(void) {
+    return advPolicy.mClass;
+}
+
+uint32_t AdvPolicy_GetIntervalMs(ADV_POLICY_CLASS cls) {
+    return (cls < ADV_POLICY_CLASS_COUNT) ? m_interval_ms[cls] : ADV_POLICY_SLOW_INTERVAL_MS;
+}
+
+void AdvPolicy_GetStats(ADV_POLICY_STATS *pStats) {
+    memcpy(pStats->mSampleCount, advPolicy.mSampleCount, sizeof(pStats->mSampleCount));
+    pStats->mChangeCount = advPolicy.mChangeCount;
+    pStats->mChangeRate = (uint32_t)((uint64_t)advPolicy.mRate * 100 / ADV_POLICY_RATE_ONE);
+}
+
+/**@brief Estimated average charge per day in uAh, for the time spent in each class so far.
+ *
+ * @details Advertising events cost ADV_POLICY_ADV_EVENT_CHARGE_NC each, on top of the sleep current.
+ *          Sampling and logging are not included.
+ */
+uint32_t AdvPolicy_EstimateMicroAhPerDay(void) {
+    uint64_t totalSamples = 0;
+    uint64_t eventsPerDay = 0;   // Weighted by the samples taken in each class.
+
+    for (size_t i = 0; i < ADV_POLICY_CLASS_COUNT; i++) {
+        totalSamples += advPolicy.mSampleCount[i];
+        eventsPerDay += (uint64_t)advPolicy.mSampleCount[i] * ADV_POLICY_SECONDS_PER_DAY * 1000 / m_interval_ms[i];
+    }
+    if (totalSamples == 0) {
+        return 0;
+    }
+
+    uint64_t chargeNc = eventsPerDay / totalSamples * ADV_POLICY_ADV_EVENT_CHARGE_NC +
+                        (uint64_t)ADV_POLICY_SLEEP_CURRENT_NA * ADV_POLICY_SECONDS_PER_DAY;
+    return (uint32_t)(chargeNc / 3600 / 1000);
+}
+
+static ADV_POLICY_CLASS AdvPolicy_Evaluate(AdvPolicy *this) {
+    if (this->mBatteryPercent <= ADV_POLICY_CRITICAL_BATTERY_PERCENT) {
+        return ADV_POLICY_CLASS_SLOW;
+    }
+
+    // Leaving the fast or the slow class takes a clear crossing of its threshold,
+    // so that sensor noise around a threshold does not make the interval flap.
+    uint32_t fastThreshold = ADV_POLICY_PERCENT_TO_RATE(ADV_POLICY_FAST_THRESHOLD);
+    uint32_t slowThreshold = ADV_POLICY_PERCENT_TO_RATE(ADV_POLICY_SLOW_THRESHOLD);
+    if (this->mClass == ADV_POLICY_CLASS_FAST) {
+        fastThreshold /= 2;
+    } else if (this->mClass == ADV_POLICY_CLASS_SLOW) {
+        slowThreshold *= 2;
+    }
+
+    ADV_POLICY_CLASS candidate;
+    if (this->mRate >= fastThreshold) {
+        candidate = ADV_POLICY_CLASS_FAST;
+    } else if (this->mRate <= slowThreshold) {
+        candidate = ADV_POLICY_CLASS_SLOW;
+    } else {
+        candidate = ADV_POLICY_CLASS_NORMAL;
+    }
+
+    // Below the low battery level, excursions are advertised at the normal interval.
+    if (this->mBatteryPercent <= ADV_POLICY_LOW_BATTERY_PERCENT && candidate == ADV_POLICY_CLASS_FAST) {
+        candidate = ADV_POLICY_CLASS_NORMAL;
+    }
+    return candidate;
+}
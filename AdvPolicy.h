@@ -0,0 +1,26 @@
+#pragma once
+
+#include "sdk_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    ADV_POLICY_CLASS_FAST,    /**< Readings are moving, advertise at ADV_POLICY_FAST_INTERVAL_MS. */
+    ADV_POLICY_CLASS_NORMAL,  /**< Readings drift slowly, advertise at ADV_POLICY_NORMAL_INTERVAL_MS. */
+    ADV_POLICY_CLASS_SLOW,    /**< Readings are stable or the battery is low, advertise at ADV_POLICY_SLOW_INTERVAL_MS. */
+    ADV_POLICY_CLASS_COUNT,
+} ADV_POLICY_CLASS;
+
+typedef struct {
+    uint32_t mSampleCount[ADV_POLICY_CLASS_COUNT];  /**< Number of samples taken in each class. */
+    uint32_t mChangeCount;                          /**< Number of class changes. */
+    uint32_t mChangeRate;                           /**< Smoothed percentage of samples leaving the deadband. */
+} ADV_POLICY_STATS;
+
+void AdvPolicy_Init(void);
+bool AdvPolicy_Update(int16_t temperature, int16_t humidity);
+void AdvPolicy_SetBatteryLevel(uint8_t percent);
+ADV_POLICY_CLASS AdvPolicy_GetClass(void);
+uint32_t AdvPolicy_GetIntervalMs(ADV_POLICY_CLASS cls);
+void AdvPolicy_GetStats(ADV_POLICY_STATS *pStats);
+uint32_t AdvPolicy_EstimateMicroAhPerDay(void);
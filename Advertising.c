@@ -0,0 +1,920 @@
+#include "Advertising.h"
+#include "ble_advdata.h"
+#include "ble_gap.h"
+#include "app_error.h"
+#include "app_util.h"
+#include "nrf_soc.h"
+#include "nordic_common.h"
+#include "CycleCounter.h"
+#include "TimerManager.h"
+#include "SampleHistory.h"
+#include "SampleCodec.h"
+#include "BeaconCrypto.h"
+#include "BeaconSchema.h"
+#include "FrameRotation.h"
+#include "RadioProfile.h"
+#include <string.h>
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define ADVERTISING_INTERVAL            MSEC_TO_UNITS(ADVERTISING_INTERVAL_MS, UNIT_0_625_MS)  /**< Advertising interval until Advertising_SetInterval changes it. */
+#define DEVICE_IDENTIFIER_PLACEHOLDER   0x11223344                         /**< Default of DEVICE_IDENTIFIER, the same on every device. */
+#define DEVICE_IDENTIFIER_BYTES         ((DEVICE_IDENTIFIER >> 24) & 0xFF), ((DEVICE_IDENTIFIER >> 16) & 0xFF), DEVICE_SHORT_IDENTIFIER  /**< DEVICE_IDENTIFIER as sent, big-endian. */
+#define DEVICE_SHORT_IDENTIFIER         ((DEVICE_IDENTIFIER >> 8) & 0xFF), (DEVICE_IDENTIFIER & 0xFF)  /**< Last 2 bytes of DEVICE_IDENTIFIER. */
+#define OPEN_SENSOR_SERVICE_UUID        0xFCBE                             /**< Assigned number by Musen connect. */
+
+#if ADVERTISING_EXTENDED_ENABLED
+#if ENV_SENSING_ENABLED
+#define ADVERTISING_ADV_TYPE            BLE_GAP_ADV_TYPE_EXTENDED_CONNECTABLE_NONSCANNABLE_UNDIRECTED
+#define ADVERTISING_EXTENDED_MAX_SIZE   BLE_GAP_ADV_SET_DATA_SIZE_EXTENDED_CONNECTABLE_MAX_SUPPORTED  /**< Connectable sets take less data. */
+#else
+#define ADVERTISING_ADV_TYPE            BLE_GAP_ADV_TYPE_EXTENDED_NONCONNECTABLE_NONSCANNABLE_UNDIRECTED
+#define ADVERTISING_EXTENDED_MAX_SIZE   BLE_GAP_ADV_SET_DATA_SIZE_EXTENDED_MAX_SUPPORTED
+#endif
+#define ADVERTISING_DATA_SIZE           ADVERTISING_EXTENDED_DATA_SIZE
+
+// Advertising indications on the primary channels are sent on 1 Mbps or Coded only.
+#if ADVERTISING_PRIMARY_PHY != BLE_GAP_PHY_1MBPS && ADVERTISING_PRIMARY_PHY != BLE_GAP_PHY_CODED
+#error "ADVERTISING_PRIMARY_PHY must be 1 Mbps or Coded"
+#endif
+#if ADVERTISING_SECONDARY_PHY != BLE_GAP_PHY_1MBPS && ADVERTISING_SECONDARY_PHY != BLE_GAP_PHY_2MBPS && ADVERTISING_SECONDARY_PHY != BLE_GAP_PHY_CODED
+#error "ADVERTISING_SECONDARY_PHY must be 1 Mbps, 2 Mbps or Coded"
+#endif
+STATIC_ASSERT(ADVERTISING_EXTENDED_DATA_SIZE <= ADVERTISING_EXTENDED_MAX_SIZE);
+#elif ENV_SENSING_ENABLED
+// Legacy connectable advertising is always scannable, the scan response stays empty without ADVERTISING_SCANNABLE_ENABLED.
+#define ADVERTISING_ADV_TYPE            BLE_GAP_ADV_TYPE_CONNECTABLE_SCANNABLE_UNDIRECTED
+#define ADVERTISING_DATA_SIZE           BLE_GAP_ADV_SET_DATA_SIZE_MAX
+#elif ADVERTISING_SCANNABLE_ENABLED
+#define ADVERTISING_ADV_TYPE            BLE_GAP_ADV_TYPE_NONCONNECTABLE_SCANNABLE_UNDIRECTED
+#define ADVERTISING_DATA_SIZE           BLE_GAP_ADV_SET_DATA_SIZE_MAX
+#else
+#define ADVERTISING_ADV_TYPE            BLE_GAP_ADV_TYPE_NONCONNECTABLE_NONSCANNABLE_UNDIRECTED
+#define ADVERTISING_DATA_SIZE           BLE_GAP_ADV_SET_DATA_SIZE_MAX
+#endif
+
+// Extended scannable sets carry no advertising data, only the scan response.
+#if ADVERTISING_SCANNABLE_ENABLED && ADVERTISING_EXTENDED_ENABLED
+#error "ADVERTISING_SCANNABLE_ENABLED requires legacy advertising"
+#endif
+
+// The key and the nonces are derived from the identifier, a placeholder shared by devices would share them too.
+#if BEACON_CRYPTO_ENABLED && DEVICE_IDENTIFIER == DEVICE_IDENTIFIER_PLACEHOLDER
+#error "BEACON_CRYPTO_ENABLED requires a DEVICE_IDENTIFIER of its own for each device"
+#endif
+#if BEACON_CRYPTO_ENABLED && !defined(BEACON_CRYPTO_MASTER_KEY)
+#error "BEACON_CRYPTO_ENABLED requires the fleet BEACON_CRYPTO_MASTER_KEY, there is no default"
+#endif
+
+// The rotation runs on the radio notification of every advertising event.
+#if ADVERTISING_ROTATION_ENABLED && !RADIO_SYNC_ENABLED
+#error "ADVERTISING_ROTATION_ENABLED requires RADIO_SYNC_ENABLED"
+#endif
+
+// The charge of each profile is estimated from the advertising events the radio notification counts.
+#if RADIO_PROFILE_ENABLED && !RADIO_SYNC_ENABLED
+#error "RADIO_PROFILE_ENABLED requires RADIO_SYNC_ENABLED"
+#endif
+
+#if ENV_SENSING_ENABLED
+#define ADVERTISING_FLAGS               BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE  /**< Centrals only list discoverable devices. */
+#define ADVERTISING_FLAGS_SIZE          3
+#else
+#define ADVERTISING_FLAGS               0
+#define ADVERTISING_FLAGS_SIZE          0
+#endif
+
+#if BEACON_CRYPTO_ENABLED
+#define BEACON_INFO_SEALED              DATA_SCHEMA_SEALED
+/**@brief The frame counter and the MIC at the end of the service data. */
+#define BEACON_INFO_TRAILER_SIZE        (BEACON_CRYPTO_COUNTER_SIZE + BEACON_CRYPTO_MIC_SIZE)
+#else
+#define BEACON_INFO_SEALED              0
+#define BEACON_INFO_TRAILER_SIZE        0
+#endif
+#if ADVERTISING_SCANNABLE_ENABLED
+#define BEACON_INFO_VERSION             (DATA_SCHEMA_VERSION_COMPACT | BEACON_INFO_SEALED)
+#define BEACON_INFO_IDENTIFIER          DEVICE_SHORT_IDENTIFIER
+#define BEACON_INFO_IDENTIFIER_SIZE     2
+#else
+#define BEACON_INFO_VERSION             (DATA_SCHEMA_VERSION | BEACON_INFO_SEALED)
+#define BEACON_INFO_IDENTIFIER          DEVICE_IDENTIFIER_BYTES
+#define BEACON_INFO_IDENTIFIER_SIZE     4
+#endif
+/**@brief Position of the readings in the service data, after the version, the identifier and the data type. */
+#define BEACON_INFO_DATA_INDEX          (1 + BEACON_INFO_IDENTIFIER_SIZE + 1)
+#define BEACON_INFO_FIELDS_INDEX        (BEACON_INFO_DATA_INDEX - 1)  /**< Position of the fields of BeaconSchema.h in the service data. */
+#define SCAN_RSP_INFO_SIZE              15
+
+#define AD_HEADER_SIZE                  2   /**< Length and AD type bytes in front of every AD structure. */
+#define AD_UUID16_SIZE                  2
+#define BEACON_INFO_MAX_SIZE            (ADVERTISING_DATA_SIZE - ADVERTISING_FLAGS_SIZE - AD_HEADER_SIZE - AD_UUID16_SIZE)
+#if ADVERTISING_HISTORY_ENABLED
+#define BEACON_INFO_INDEX_INDEX         (BEACON_INFO_DATA_INDEX)      /**< Position of the index of the newest sample in the service data. */
+#define BEACON_INFO_SAMPLES_INDEX       (BEACON_INFO_DATA_INDEX + 1)  /**< Position of the newest sample in the service data. */
+#if ADVERTISING_HISTORY_COMPRESSED
+#define BEACON_INFO_SIZE                BEACON_INFO_MAX_SIZE
+/**@brief Most samples in a frame, reached when every older sample takes a single byte. Large frames are
+ *        limited by the samples kept in RAM instead. */
+#define ADVERTISING_HISTORY_DEPTH       MIN(1 + BEACON_INFO_SIZE - BEACON_INFO_TRAILER_SIZE - BEACON_INFO_SAMPLES_INDEX - SAMPLE_CODEC_HEADER_SIZE, SAMPLE_HISTORY_SIZE)
+#else
+#define BEACON_INFO_SAMPLE_SIZE         4
+#define BEACON_INFO_NO_SAMPLE           INT16_MIN  /**< Written in place of samples not taken yet. */
+/**@brief Number of samples in a frame, as many as fit the advertising data and are kept in RAM. */
+#define ADVERTISING_HISTORY_DEPTH       MIN((BEACON_INFO_MAX_SIZE - BEACON_INFO_TRAILER_SIZE - BEACON_INFO_SAMPLES_INDEX) / BEACON_INFO_SAMPLE_SIZE, SAMPLE_HISTORY_SIZE)
+#define BEACON_INFO_SIZE                (BEACON_INFO_SAMPLES_INDEX + ADVERTISING_HISTORY_DEPTH * BEACON_INFO_SAMPLE_SIZE + BEACON_INFO_TRAILER_SIZE)
+#endif
+
+STATIC_ASSERT(ADVERTISING_HISTORY_DEPTH <= UINT8_MAX);  // Sample counts are kept in a byte.
+#else
+#define BEACON_INFO_SIZE                (BEACON_INFO_FIELDS_INDEX + BEACON_READINGS_SIZE + BEACON_INFO_TRAILER_SIZE)
+#endif
+#define BEACON_INFO_TRAILER_INDEX       (BEACON_INFO_SIZE - BEACON_INFO_TRAILER_SIZE)  /**< End of the readings. */
+#if ADVERTISING_HISTORY_ENABLED
+#define ADVERTISING_SAMPLES_PER_FRAME   ADVERTISING_HISTORY_DEPTH
+#else
+#define ADVERTISING_SAMPLES_PER_FRAME   1
+#endif
+#define ADVERTISING_BUFFER_COUNT        2
+#if ADVERTISING_ROTATION_ENABLED
+#define ADVERTISING_ROTATED_COUNT       (FRAME_ROTATION_COUNT - 1)  /**< Frames with a buffer of their own, all but the readings. */
+#define BEACON_STATISTICS_INFO_SIZE     (BEACON_INFO_FIELDS_INDEX + BEACON_STATISTICS_SIZE + BEACON_INFO_TRAILER_SIZE)
+#define BEACON_HEALTH_INFO_SIZE         (BEACON_INFO_FIELDS_INDEX + BEACON_HEALTH_SIZE + BEACON_INFO_TRAILER_SIZE)
+// Every frame must fit the advertising data, the compact identifier or extended advertising make room.
+STATIC_ASSERT(BEACON_STATISTICS_INFO_SIZE <= BEACON_INFO_MAX_SIZE);
+STATIC_ASSERT(BEACON_HEALTH_INFO_SIZE <= BEACON_INFO_MAX_SIZE);
+#endif
+#define ADVERTISING_MAX_AGE_TICKS       APP_TIMER_TICKS(ADVERTISING_MAX_AGE_S * 1000)
+
+// Ages are measured on the 24-bit RTC counter, which wraps after 1024 s.
+STATIC_ASSERT(ADVERTISING_MAX_AGE_S < 1024);
+STATIC_ASSERT(ADVERTISING_INTERVAL_MS >= 100);    // Minimum for non-connectable legacy advertising.
+STATIC_ASSERT(ADVERTISING_INTERVAL_MS <= 10240);  // Maximum for legacy advertising.
+#if !ADV_POLICY_ENABLED
+// Published samples replaced in the frame before an advertising event are never on air. The policy slows
+// advertising down on purpose while the readings are stable, so it is not bound by this.
+STATIC_ASSERT(ADVERTISING_INTERVAL_MS <= (uint32_t)PUBLISH_INTERVAL_MS * ADVERTISING_SAMPLES_PER_FRAME);
+#endif
+
+typedef struct
+{
+    ble_gap_adv_params_t mAdvParams;
+    ble_gap_adv_data_t mAdvData[ADVERTISING_BUFFER_COUNT];
+    uint8_t mAdvHandle;
+    uint8_t mConnCfgTag;
+    bool mIsAdvertising;
+    uint8_t mActive;             // Buffer of the readings on air or next on air, the other one is free to write.
+    ble_gap_adv_data_t *mpOnAir; // Data the SoftDevice reads.
+    uint8_t mEncodedData[ADVERTISING_BUFFER_COUNT][ADVERTISING_DATA_SIZE];
+#if ADVERTISING_SCANNABLE_ENABLED
+    uint8_t mScanRspData[ADVERTISING_BUFFER_COUNT][BLE_GAP_ADV_SET_DATA_SIZE_MAX];
+#endif
+    uint8_t mPayloadOffset;      // Byte offset of the service data payload in mEncodedData.
+    bool mHasReadings;           // False until the first readings are on air.
+    int16_t mTemperature;        // Readings on air.
+    int16_t mHumidity;
+    uint32_t mAppliedTicks;
+    uint32_t mSamplesSinceUpdate;
+    uint8_t mSequence;           // Sequence number of the readings on air.
+#if ADVERTISING_ROTATION_ENABLED
+    ble_gap_adv_data_t mRotatedAdvData[ADVERTISING_ROTATED_COUNT];
+    uint8_t mRotatedData[ADVERTISING_ROTATED_COUNT][ADVERTISING_DATA_SIZE];
+    bool mIsReadingsFresh;       // Readings handed over since the last event, no rotated frame displaces them.
+    bool mIsRotationHeld;        // The last event kept the rotated frames back for fresh readings.
+    SAMPLE mWindowMin;           // Extremes of the current window.
+    SAMPLE mWindowMax;
+    uint32_t mWindowCount;
+    bool mHasStatistics;         // A window completed.
+    SAMPLE mStatisticsMin;       // Extremes of the last window completed.
+    SAMPLE mStatisticsMax;
+    bool mHasHealth;
+    ADVERTISING_HEALTH mHealth;
+#endif
+#if BEACON_CRYPTO_ENABLED
+    uint8_t mKey[BEACON_CRYPTO_KEY_SIZE];
+    uint32_t mCounter;           // Counter of the last frame sealed, the nonce of the next one is the next value.
+    uint32_t mSealCount;
+    uint32_t mMaxSealCycles;
+    uint64_t mTotalSealCycles;
+#endif
+    uint32_t mUpdateCount;
+    uint32_t mSkippedCount;
+    uint32_t mFailureCount;
+    uint32_t mRestartCount;
+    uint32_t mMaxCycles;
+    uint64_t mTotalCycles;
+} Advertising;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static void Advertising_Encode(uint8_t const *pInfo, uint16_t size, uint8_t flags, uint8_t *pBuffer, uint16_t *pLength);
+static uint8_t Advertising_FindServiceData(uint8_t const *pData, uint16_t length, uint16_t uuid);
+#if ADVERTISING_HISTORY_ENABLED && !ADVERTISING_HISTORY_COMPRESSED
+static void Advertising_PutInt16(uint8_t *pData, int16_t value);
+#endif
+static uint8_t Advertising_BuildReadings(Advertising *this, uint8_t *pBeaconInfo, int16_t temperature, int16_t humidity);
+static uint8_t Advertising_WriteReadings(uint8_t *pBeaconInfo, int16_t temperature, int16_t humidity, uint8_t sequence);
+#if ADVERTISING_BENCHMARK_ENABLED
+static uint32_t Advertising_Checksum(uint8_t const *pData, uint16_t length);
+#endif
+static bool Advertising_IsWithinDeadband(Advertising *this, int16_t temperature, int16_t humidity, uint8_t sampleCount);
+static ret_code_t Advertising_Configure(Advertising *this, ble_gap_adv_data_t *pAdvData);
+static void Advertising_Reconfigure(Advertising *this);
+#if ADVERTISING_ROTATION_ENABLED
+static void Advertising_AddToWindow(Advertising *this, int16_t temperature, int16_t humidity);
+static uint16_t Advertising_WriteRotated(Advertising *this, FRAME_ROTATION_FRAME frame, uint8_t *pBeaconInfo);
+#endif
+#if BEACON_CRYPTO_ENABLED
+static bool Advertising_BlockEncrypt(uint8_t const *pKey, uint8_t const *pIn, uint8_t *pOut);
+static void Advertising_InitCrypto(Advertising *this);
+static bool Advertising_Seal(Advertising *this, uint8_t *pBeaconInfo, uint16_t size);
+#endif
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static Advertising advertising;
+
+static uint8_t const m_beacon_info[BEACON_INFO_SIZE] =  /**< Information advertised by the Beacon. */
+{
+    BEACON_INFO_VERSION,
+    BEACON_INFO_IDENTIFIER,
+#if ADVERTISING_HISTORY_ENABLED && ADVERTISING_HISTORY_COMPRESSED
+    DATA_TYPE_HISTORY_COMPRESSED,
+    /** The following byte is the index of the newest sample, modulo 256 **/
+    0x00,
+    /** The following bytes are the output of SampleCodec_Encode, no samples yet **/
+#elif ADVERTISING_HISTORY_ENABLED
+    DATA_TYPE_HISTORY,
+    /** The following byte is the index of the newest sample, modulo 256 **/
+    0x00,
+    /** The following ADVERTISING_HISTORY_DEPTH * 4 bytes are temperature and humidity, newest first, set by Advertising_Init **/
+#else
+    /** The fields of BEACON_SCHEMA_READINGS, set by Advertising_WriteReadings **/
+    BEACON_READINGS_BYTES
+#endif
+};
+
+#if ADVERTISING_ROTATION_ENABLED
+static uint8_t const m_statistics_info[BEACON_STATISTICS_INFO_SIZE] =  /**< Statistics frame, set by Advertising_WriteRotated. */
+{
+    BEACON_INFO_VERSION,
+    BEACON_INFO_IDENTIFIER,
+    BEACON_STATISTICS_BYTES
+};
+
+static uint8_t const m_health_info[BEACON_HEALTH_INFO_SIZE] =  /**< Health frame, set by Advertising_WriteRotated. */
+{
+    BEACON_INFO_VERSION,
+    BEACON_INFO_IDENTIFIER,
+    BEACON_HEALTH_BYTES
+};
+
+static uint8_t const * const m_rotated_info[ADVERTISING_ROTATED_COUNT] = { m_statistics_info, m_health_info };
+static uint16_t const m_rotated_info_size[ADVERTISING_ROTATED_COUNT] = { sizeof(m_statistics_info), sizeof(m_health_info) };
+#endif
+
+#if BEACON_CRYPTO_ENABLED
+static uint8_t const m_device_identifier[BEACON_CRYPTO_IDENTIFIER_SIZE] = { DEVICE_IDENTIFIER_BYTES };
+static uint8_t const m_master_key[BEACON_CRYPTO_KEY_SIZE] = { BEACON_CRYPTO_MASTER_KEY };
+#endif
+
+#if ADVERTISING_SCANNABLE_ENABLED
+static uint8_t const m_scan_rsp_info[SCAN_RSP_INFO_SIZE] =  /**< Information sent only to scanners asking for it. */
+{
+    DATA_SCHEMA_VERSION,
+    DEVICE_IDENTIFIER_BYTES,
+    DATA_TYPE_METADATA,
+    /** Firmware version: major, minor, patch **/
+    FIRMWARE_VERSION_MAJOR,
+    FIRMWARE_VERSION_MINOR,
+    FIRMWARE_VERSION_PATCH,
+    /** Interval between published samples in ms, then temperature and humidity calibration offsets in 0.01 units **/
+    (uint8_t)((uint16_t)PUBLISH_INTERVAL_MS >> 8),
+    (uint8_t)((uint16_t)PUBLISH_INTERVAL_MS & 0xFF),
+    (uint8_t)((uint16_t)SENSOR_TEMPERATURE_OFFSET >> 8),
+    (uint8_t)((uint16_t)SENSOR_TEMPERATURE_OFFSET & 0xFF),
+    (uint8_t)((uint16_t)SENSOR_HUMIDITY_OFFSET >> 8),
+    (uint8_t)((uint16_t)SENSOR_HUMIDITY_OFFSET & 0xFF),
+};
+#endif
+
+/**@brief Encodes the advertising data once and records where the readings are.
+ *
+ * @details Only the readings change afterwards, so updates patch those bytes instead of encoding again.
+ *          Both buffers start with the same encoding, so the offsets are valid in either of them.
+ */
+void Advertising_Init(void) {
+    memset(&advertising, 0, sizeof(advertising));
+    advertising.mAdvHandle = BLE_GAP_ADV_SET_HANDLE_NOT_SET;
+
+    advertising.mAdvParams.properties.type = ADVERTISING_ADV_TYPE;
+    advertising.mAdvParams.p_peer_addr     = NULL;    // Undirected advertisement.
+    advertising.mAdvParams.filter_policy   = BLE_GAP_ADV_FP_ANY;
+    advertising.mAdvParams.interval        = ADVERTISING_INTERVAL;
+    advertising.mAdvParams.duration        = 0;       // Never time out.
+#if ADVERTISING_EXTENDED_ENABLED
+    advertising.mAdvParams.primary_phy     = ADVERTISING_PRIMARY_PHY;
+    advertising.mAdvParams.secondary_phy   = ADVERTISING_SECONDARY_PHY;
+#endif
+#if BEACON_CRYPTO_ENABLED
+    Advertising_InitCrypto(&advertising);
+#endif
+
+    uint8_t beaconInfo[BEACON_INFO_SIZE];
+    memcpy(beaconInfo, m_beacon_info, sizeof(beaconInfo));
+#if ADVERTISING_HISTORY_ENABLED && !ADVERTISING_HISTORY_COMPRESSED
+    for (size_t i = 0; i < ADVERTISING_HISTORY_DEPTH; i++) {
+        Advertising_PutInt16(&beaconInfo[BEACON_INFO_SAMPLES_INDEX + i * BEACON_INFO_SAMPLE_SIZE], BEACON_INFO_NO_SAMPLE);
+        Advertising_PutInt16(&beaconInfo[BEACON_INFO_SAMPLES_INDEX + i * BEACON_INFO_SAMPLE_SIZE + 2], BEACON_INFO_NO_SAMPLE);
+    }
+#endif
+
+    uint16_t length = ADVERTISING_DATA_SIZE;
+    Advertising_Encode(beaconInfo, sizeof(beaconInfo), ADVERTISING_FLAGS, advertising.mEncodedData[0], &length);
+    for (size_t i = 0; i < ADVERTISING_BUFFER_COUNT; i++) {
+        memcpy(advertising.mEncodedData[i], advertising.mEncodedData[0], length);
+        advertising.mAdvData[i].adv_data.p_data = advertising.mEncodedData[i];
+        advertising.mAdvData[i].adv_data.len = length;
+    }
+
+#if ADVERTISING_SCANNABLE_ENABLED
+    // The scan response never changes, but the SoftDevice wants new buffers for it too on every update.
+    uint16_t scanRspLength = BLE_GAP_ADV_SET_DATA_SIZE_MAX;
+    Advertising_Encode(m_scan_rsp_info, sizeof(m_scan_rsp_info), 0, advertising.mScanRspData[0], &scanRspLength);
+    for (size_t i = 0; i < ADVERTISING_BUFFER_COUNT; i++) {
+        memcpy(advertising.mScanRspData[i], advertising.mScanRspData[0], scanRspLength);
+        advertising.mAdvData[i].scan_rsp_data.p_data = advertising.mScanRspData[i];
+        advertising.mAdvData[i].scan_rsp_data.len = scanRspLength;
+    }
+#endif
+
+    uint8_t serviceData = Advertising_FindServiceData(advertising.mEncodedData[0], length, OPEN_SENSOR_SERVICE_UUID);
+    if (serviceData == 0) {
+        printf("%s(%d) Service data not found in the encoded advertising data\n", __func__, __LINE__);
+        APP_ERROR_CHECK(NRF_ERROR_INTERNAL);
+    }
+    advertising.mPayloadOffset = serviceData;
+#if BEACON_CRYPTO_ENABLED
+    if (!Advertising_Seal(&advertising, &advertising.mEncodedData[0][serviceData], BEACON_INFO_SIZE)) {
+        printf("%s(%d) Failed to seal the advertising data\n", __func__, __LINE__);
+        APP_ERROR_CHECK(NRF_ERROR_INTERNAL);
+    }
+#endif
+
+#if ADVERTISING_ROTATION_ENABLED
+    // The rotated frames have the same flags and header, so their fields are at the same offset.
+    for (size_t i = 0; i < ADVERTISING_ROTATED_COUNT; i++) {
+        uint16_t rotatedLength = ADVERTISING_DATA_SIZE;
+        Advertising_Encode(m_rotated_info[i], m_rotated_info_size[i], ADVERTISING_FLAGS, advertising.mRotatedData[i], &rotatedLength);
+        advertising.mRotatedAdvData[i].adv_data.p_data = advertising.mRotatedData[i];
+        advertising.mRotatedAdvData[i].adv_data.len = rotatedLength;
+#if ADVERTISING_SCANNABLE_ENABLED
+        advertising.mRotatedAdvData[i].scan_rsp_data.len = scanRspLength;
+#endif
+    }
+    FrameRotation_Init();
+#endif
+
+    advertising.mActive = 0;
+    advertising.mpOnAir = &advertising.mAdvData[advertising.mActive];
+    ret_code_t err_code = sd_ble_gap_adv_set_configure(&advertising.mAdvHandle, advertising.mpOnAir, &advertising.mAdvParams);
+    APP_ERROR_CHECK(err_code);
+}
+
+void Advertising_Start(uint8_t connCfgTag) {
+    ret_code_t err_code = sd_ble_gap_adv_start(advertising.mAdvHandle, connCfgTag);
+    APP_ERROR_CHECK(err_code);
+    advertising.mConnCfgTag = connCfgTag;
+    advertising.mIsAdvertising = true;
+}
+
+/**@brief Changes the advertising interval, in 0.625 ms units.
+ *
+ * @details A running set is restarted by Advertising_Reconfigure. Nothing happens if the interval does not
+ *          change.
+ */
+void Advertising_SetInterval(uint32_t interval) {
+    if (interval == advertising.mAdvParams.interval) {
+        return;
+    }
+
+    advertising.mAdvParams.interval = interval;
+    Advertising_Reconfigure(&advertising);
+}
+
+/**@brief Returns the advertising interval, in 0.625 ms units. */
+uint32_t Advertising_GetInterval(void) {
+    return advertising.mAdvParams.interval;
+}
+
+#if RADIO_PROFILE_ENABLED
+/**@brief Sets the primary channels, RADIO_PROFILE_CHANNEL_* bits, and the transmit power in dBm.
+ *
+ * @details The channels are advertising parameters, a change restarts a running set like
+ *          Advertising_SetInterval does. The power applies from the next event, without a restart.
+ */
+void Advertising_SetRadio(uint8_t channels, int8_t txPower) {
+    channels &= RADIO_PROFILE_CHANNELS_ALL;
+    if (channels == 0) {
+        printf("%s(%d) No primary channel.\n", __func__, __LINE__);
+        return;
+    }
+
+    // The mask lists the channels not to use, 37 to 39 are the top bits of its last byte.
+    uint8_t channelMask = (uint8_t)((~channels & RADIO_PROFILE_CHANNELS_ALL) << 5);
+    if (channelMask != advertising.mAdvParams.channel_mask[4]) {
+        advertising.mAdvParams.channel_mask[4] = channelMask;
+        Advertising_Reconfigure(&advertising);
+    }
+
+    ret_code_t err_code = sd_ble_gap_tx_power_set(BLE_GAP_TX_POWER_ROLE_ADV, advertising.mAdvHandle, txPower);
+    APP_ERROR_CHECK(err_code);
+}
+#endif
+
+/**@brief Writes the readings into the advertising data. Values are in 0.01 units.
+ *
+ * @details Readings within the deadband of the ones on air are skipped, unless those are older than
+ *          ADVERTISING_MAX_AGE_S, before any frame is built. Only a compressed history frame is built first,
+ *          as the number of samples it holds decides whether it must go out. With ADVERTISING_HISTORY_ENABLED, the frame carries the newest samples
+ *          of SampleHistory instead, and is also updated before the samples not on air outnumber the ones
+ *          the frame can hold, so that a gateway hearing every frame gets every sample. The SoftDevice reads the active buffer while advertising, so the readings
+ *          go into the other buffer, which is then handed over with sd_ble_gap_adv_set_configure. If the
+ *          SoftDevice rejects it, the previous frame stays on air and the failure is counted. With
+ *          ADVERTISING_ROTATION_ENABLED, readings that come while a rotated frame is on air are handed over
+ *          by Advertising_OnAdvertisingEvent on the next event.
+ *
+ * @retval true  The readings are on air, or next on air.
+ * @retval false The update was skipped or failed.
+ */
+bool Advertising_SetReadings(int16_t temperature, int16_t humidity) {
+    uint32_t startCycles = CycleCounter_Get();
+    uint8_t next = advertising.mActive ^ 1;
+#if ADVERTISING_ROTATION_ENABLED
+    Advertising_AddToWindow(&advertising, temperature, humidity);
+#endif
+
+    uint8_t *pBeaconInfo = &advertising.mEncodedData[next][advertising.mPayloadOffset];
+#if ADVERTISING_HISTORY_ENABLED && ADVERTISING_HISTORY_COMPRESSED
+    // How many samples fit depends on the data, so the frame is built before deciding whether to send it.
+    // The other buffer is not on air, so it can be written either way.
+    uint8_t sampleCount = Advertising_BuildReadings(&advertising, pBeaconInfo, temperature, humidity);
+#elif ADVERTISING_HISTORY_ENABLED
+    uint8_t sampleCount = (uint8_t)MIN(SampleHistory_GetCount(), ADVERTISING_HISTORY_DEPTH);
+#else
+    uint8_t sampleCount = 1;
+#endif
+    if (Advertising_IsWithinDeadband(&advertising, temperature, humidity, sampleCount)) {
+        advertising.mSkippedCount++;
+        return false;
+    }
+#if !(ADVERTISING_HISTORY_ENABLED && ADVERTISING_HISTORY_COMPRESSED)
+    Advertising_BuildReadings(&advertising, pBeaconInfo, temperature, humidity);
+#endif
+#if BEACON_CRYPTO_ENABLED
+    if (!Advertising_Seal(&advertising, pBeaconInfo, BEACON_INFO_SIZE)) {
+        printf("%s(%d) Failed to seal the advertising data\n", __func__, __LINE__);
+        advertising.mFailureCount++;
+        return false;
+    }
+#endif
+
+    // While a rotated frame has its event, the readings wait for the next one, handed over by the rotation.
+    ret_code_t err_code = NRF_SUCCESS;
+    if (advertising.mpOnAir == &advertising.mAdvData[advertising.mActive]) {
+        err_code = Advertising_Configure(&advertising, &advertising.mAdvData[next]);
+    }
+    uint32_t cycles = CycleCounter_Get() - startCycles;
+    if (err_code != NRF_SUCCESS) {
+        printf("%s(%d) Error updating advertising data: %d\n", __func__, __LINE__, err_code);
+        advertising.mFailureCount++;
+        return false;
+    }
+
+    advertising.mActive = next;
+    advertising.mHasReadings = true;
+#if ADVERTISING_ROTATION_ENABLED
+    advertising.mIsReadingsFresh = true;
+#endif
+    advertising.mTemperature = temperature;
+    advertising.mHumidity = humidity;
+    advertising.mAppliedTicks = TimerManager_GetTicks();
+    advertising.mSamplesSinceUpdate = 0;
+    advertising.mSequence++;
+    advertising.mUpdateCount++;
+    advertising.mTotalCycles += cycles;
+    if (cycles > advertising.mMaxCycles) {
+        advertising.mMaxCycles = cycles;
+    }
+    return true;
+}
+
+void Advertising_GetStats(ADVERTISING_STATS *pStats) {
+    pStats->mUpdateCount = advertising.mUpdateCount;
+    pStats->mSkippedCount = advertising.mSkippedCount;
+    pStats->mFailureCount = advertising.mFailureCount;
+    pStats->mRestartCount = advertising.mRestartCount;
+    pStats->mMaxCycles = advertising.mMaxCycles;
+    pStats->mMeanCycles = (advertising.mUpdateCount > 0) ? (uint32_t)(advertising.mTotalCycles / advertising.mUpdateCount) : 0;
+#if BEACON_CRYPTO_ENABLED
+    pStats->mMaxSealCycles = advertising.mMaxSealCycles;
+    pStats->mMeanSealCycles = (advertising.mSealCount > 0) ? (uint32_t)(advertising.mTotalSealCycles / advertising.mSealCount) : 0;
+#else
+    pStats->mMaxSealCycles = 0;
+    pStats->mMeanSealCycles = 0;
+#endif
+}
+
+#if ADVERTISING_ROTATION_ENABLED
+/**@brief Sets the device health sent in the health frame, from its next event on. */
+void Advertising_SetHealth(ADVERTISING_HEALTH const *pHealth) {
+    advertising.mHealth = *pHealth;
+    advertising.mHasHealth = true;
+}
+
+/**@brief Hands over the frame FrameRotation chooses for the next advertising event. Called on every radio
+ *        notification of an advertising event.
+ *
+ * @details A rotated frame is written from its template and sealed only when it is due, and stays on air
+ *          for a single event. Readings handed over since the last event are not displaced, the rotated
+ *          frame waits for the next event; it waits a single event, so that readings as frequent as the
+ *          events do not keep it off the air.
+ */
+void Advertising_OnAdvertisingEvent(void) {
+    Advertising *this = &advertising;
+    uint32_t readyMask = 0;
+    this->mIsRotationHeld = this->mIsReadingsFresh && !this->mIsRotationHeld;
+    if (!this->mIsRotationHeld) {
+        readyMask |= this->mHasStatistics ? FRAME_ROTATION_MASK(FRAME_ROTATION_STATISTICS) : 0;
+        readyMask |= this->mHasHealth ? FRAME_ROTATION_MASK(FRAME_ROTATION_HEALTH) : 0;
+    }
+    this->mIsReadingsFresh = false;
+
+    FRAME_ROTATION_FRAME frame = FrameRotation_Next(readyMask);
+    ble_gap_adv_data_t *pAdvData = &this->mAdvData[this->mActive];
+    if (frame != FRAME_ROTATION_READINGS) {
+        pAdvData = &this->mRotatedAdvData[frame - 1];
+    }
+    if (pAdvData == this->mpOnAir) {
+        return;
+    }
+
+    if (frame != FRAME_ROTATION_READINGS) {
+        uint8_t *pBeaconInfo = &this->mRotatedData[frame - 1][this->mPayloadOffset];
+        uint16_t size = Advertising_WriteRotated(this, frame, pBeaconInfo);
+#if BEACON_CRYPTO_ENABLED
+        if (!Advertising_Seal(this, pBeaconInfo, size)) {
+            printf("%s(%d) Failed to seal the advertising data\n", __func__, __LINE__);
+            this->mFailureCount++;
+            return;
+        }
+#else
+        (void)size;
+#endif
+    }
+
+    ret_code_t err_code = Advertising_Configure(this, pAdvData);
+    if (err_code != NRF_SUCCESS) {
+        printf("%s(%d) Error updating advertising data: %d\n", __func__, __LINE__, err_code);
+        this->mFailureCount++;
+        return;
+    }
+    // Readings handed over again, after a rotated frame, go out before the next rotated frame.
+    this->mIsReadingsFresh = (frame == FRAME_ROTATION_READINGS);
+}
+#endif
+
+#if ADVERTISING_BENCHMARK_ENABLED
+/**@brief Compares the cost of encoding the whole advertising data with patching the readings in place.
+ *
+ * @details Both run on a scratch buffer, the advertising data in use is not touched. The readings of every update
+ *          are read back into a checksum, so that the compiler keeps the stores of each one; the cost of the
+ *          checksum is timed on its own and taken out of both. The totals are printed, for a resolution finer
+ *          than one cycle per update.
+ */
+void Advertising_Benchmark(uint32_t iterations) {
+    uint8_t beaconInfo[BEACON_INFO_SIZE];
+    uint8_t buffer[ADVERTISING_DATA_SIZE];
+    uint16_t length = sizeof(buffer);
+    uint8_t *pReadings = &buffer[advertising.mPayloadOffset + BEACON_INFO_FIELDS_INDEX];
+    uint16_t readingsSize = BEACON_INFO_TRAILER_INDEX - BEACON_INFO_FIELDS_INDEX;
+    uint32_t checksum = 0;
+    memcpy(beaconInfo, m_beacon_info, sizeof(beaconInfo));
+    Advertising_Encode(beaconInfo, sizeof(beaconInfo), ADVERTISING_FLAGS, buffer, &length);
+
+    uint32_t startCycles = CycleCounter_Get();
+    for (uint32_t i = 0; i < iterations; i++) {
+        checksum += Advertising_Checksum(pReadings, readingsSize);
+    }
+    uint32_t checksumCycles = CycleCounter_Get() - startCycles;
+
+    startCycles = CycleCounter_Get();
+    for (uint32_t i = 0; i < iterations; i++) {
+        Advertising_WriteReadings(beaconInfo, (int16_t)i, (int16_t)i, (uint8_t)i);
+        length = sizeof(buffer);
+        Advertising_Encode(beaconInfo, sizeof(beaconInfo), ADVERTISING_FLAGS, buffer, &length);
+        checksum += Advertising_Checksum(pReadings, readingsSize);
+    }
+    uint32_t encodeCycles = CycleCounter_Get() - startCycles;
+
+    startCycles = CycleCounter_Get();
+    for (uint32_t i = 0; i < iterations; i++) {
+        Advertising_WriteReadings(&buffer[advertising.mPayloadOffset], (int16_t)i, (int16_t)i, (uint8_t)i);
+        checksum += Advertising_Checksum(pReadings, readingsSize);
+    }
+    uint32_t patchCycles = CycleCounter_Get() - startCycles;
+
+    encodeCycles = (encodeCycles > checksumCycles) ? encodeCycles - checksumCycles : 0;
+    patchCycles = (patchCycles > checksumCycles) ? patchCycles - checksumCycles : 0;
+    printf("%s(%d) cycles for %d updates: encode=%d patch=%d checksum=%d (0x%08x)\n", __func__, __LINE__,
+           iterations, encodeCycles, patchCycles, checksumCycles, checksum);
+}
+
+/**@brief Adds up the bytes of pData, read through a volatile pointer so that the reads are not optimised away. */
+static uint32_t Advertising_Checksum(uint8_t const *pData, uint16_t length) {
+    uint8_t const volatile *pBytes = pData;
+    uint32_t checksum = 0;
+    for (uint16_t i = 0; i < length; i++) {
+        checksum = (checksum << 1 | checksum >> 31) + pBytes[i];
+    }
+    return checksum;
+}
+#endif
+
+/**@brief Encodes pInfo as the service data of the Open Sensor service, behind the flags if they are not 0. */
+static void Advertising_Encode(uint8_t const *pInfo, uint16_t size, uint8_t flags, uint8_t *pBuffer, uint16_t *pLength) {
+    ble_advdata_t advdata;
+    ble_advdata_service_data_t service_data;
+
+    service_data.service_uuid = OPEN_SENSOR_SERVICE_UUID;
+    service_data.data.p_data = (uint8_t*)pInfo;
+    service_data.data.size = size;
+
+    memset(&advdata, 0, sizeof(advdata));
+    advdata.flags                = flags;
+    advdata.p_service_data_array = &service_data;
+    advdata.service_data_count   = 1;
+
+    ret_code_t err_code = ble_advdata_encode(&advdata, pBuffer, pLength);
+    APP_ERROR_CHECK(err_code);
+}
+
+/**@brief Returns the offset of the payload of the service data with the given UUID, 0 if it is not present. */
+static uint8_t Advertising_FindServiceData(uint8_t const *pData, uint16_t length, uint16_t uuid) {
+    uint16_t offset = 0;
+
+    while (offset + AD_HEADER_SIZE <= length && pData[offset] != 0) {
+        uint8_t fieldLength = pData[offset];
+        if (pData[offset + 1] == BLE_GAP_AD_TYPE_SERVICE_DATA && fieldLength > AD_UUID16_SIZE &&
+            uint16_decode(&pData[offset + AD_HEADER_SIZE]) == uuid) {
+            return (uint8_t)(offset + AD_HEADER_SIZE + AD_UUID16_SIZE);
+        }
+        offset += fieldLength + 1;
+    }
+    return 0;
+}
+
+#if ADVERTISING_HISTORY_ENABLED && !ADVERTISING_HISTORY_COMPRESSED
+static void Advertising_PutInt16(uint8_t *pData, int16_t value) {
+    pData[0] = (uint8_t)(((uint16_t)value >> 8) & 0x00FF);
+    pData[1] = (uint8_t)(((uint16_t)value >> 0) & 0x00FF);
+}
+#endif
+
+/**@brief Builds the readings frame in the buffer that is not on air.
+ *
+ * @return Number of samples in the frame.
+ */
+static uint8_t Advertising_BuildReadings(Advertising *this, uint8_t *pBeaconInfo, int16_t temperature, int16_t humidity) {
+#if BEACON_CRYPTO_ENABLED
+    // The buffer holds an earlier frame in cipher text, the fields that are not patched are restored.
+    memcpy(&pBeaconInfo[BEACON_INFO_DATA_INDEX], &m_beacon_info[BEACON_INFO_DATA_INDEX], BEACON_INFO_TRAILER_INDEX - BEACON_INFO_DATA_INDEX);
+#endif
+    return Advertising_WriteReadings(pBeaconInfo, temperature, humidity, (uint8_t)(this->mSequence + 1));
+}
+
+/**@brief Writes the readings into the service data payload of a frame.
+ *
+ * @details Gateways tell new frames from repeated ones by the sequence number. History frames use the index
+ *          of the newest sample instead, which also goes up once per sample.
+ *
+ * @return Number of samples in the frame.
+ */
+static uint8_t Advertising_WriteReadings(uint8_t *pBeaconInfo, int16_t temperature, int16_t humidity, uint8_t sequence) {
+#if ADVERTISING_HISTORY_ENABLED
+    // The readings are the newest sample of the history, which the caller has added already.
+    (void)temperature;
+    (void)humidity;
+    (void)sequence;
+    pBeaconInfo[BEACON_INFO_INDEX_INDEX] = (uint8_t)(SampleHistory_GetTotal() - 1);
+#if ADVERTISING_HISTORY_COMPRESSED
+    SAMPLE samples[ADVERTISING_HISTORY_DEPTH];
+    uint32_t count = 0;
+    while (count < ADVERTISING_HISTORY_DEPTH && SampleHistory_Get(count, &samples[count])) {
+        count++;
+    }
+    return (uint8_t)SampleCodec_Encode(samples, count, &pBeaconInfo[BEACON_INFO_SAMPLES_INDEX], BEACON_INFO_TRAILER_INDEX - BEACON_INFO_SAMPLES_INDEX);
+#else
+    uint8_t count = 0;
+    for (uint32_t age = 0; age < ADVERTISING_HISTORY_DEPTH; age++) {
+        SAMPLE sample = { BEACON_INFO_NO_SAMPLE, BEACON_INFO_NO_SAMPLE };
+        if (SampleHistory_Get(age, &sample)) {
+            count++;
+        }
+        uint8_t *pSample = &pBeaconInfo[BEACON_INFO_SAMPLES_INDEX + age * BEACON_INFO_SAMPLE_SIZE];
+        Advertising_PutInt16(&pSample[0], sample.mTemperature);
+        Advertising_PutInt16(&pSample[2], sample.mHumidity);
+    }
+    return count;
+#endif
+#else
+    uint8_t *pReadings = &pBeaconInfo[BEACON_INFO_FIELDS_INDEX];
+    BEACON_SCHEMA_PUT(pReadings, READINGS, TEMPERATURE, temperature);
+    BEACON_SCHEMA_PUT(pReadings, READINGS, HUMIDITY, humidity);
+    BEACON_SCHEMA_PUT(pReadings, READINGS, SEQUENCE, sequence);
+    return 1;
+#endif
+}
+
+static bool Advertising_IsWithinDeadband(Advertising *this, int16_t temperature, int16_t humidity, uint8_t sampleCount) {
+    if (!this->mHasReadings || TimerManager_GetTicksSince(this->mAppliedTicks) >= ADVERTISING_MAX_AGE_TICKS) {
+        return false;
+    }
+#if ADVERTISING_HISTORY_ENABLED
+    // Once the frame only just holds the samples not on air yet, it must go out. A compressed frame
+    // may hold fewer samples next time, so it goes out one sample early.
+    if (++this->mSamplesSinceUpdate + ADVERTISING_HISTORY_COMPRESSED >= sampleCount) {
+        return false;
+    }
+#else
+    (void)sampleCount;
+#endif
+
+    // Compare with the readings on air rather than the previous sample, so that slow drifts are not lost.
+    int32_t temperatureChange = (int32_t)temperature - this->mTemperature;
+    int32_t humidityChange = (int32_t)humidity - this->mHumidity;
+    return (temperatureChange <= ADVERTISING_DEADBAND_TEMPERATURE && temperatureChange >= -ADVERTISING_DEADBAND_TEMPERATURE &&
+            humidityChange <= ADVERTISING_DEADBAND_HUMIDITY && humidityChange >= -ADVERTISING_DEADBAND_HUMIDITY);
+}
+
+/**@brief Hands the data over to the SoftDevice, with the scan response buffer it is not reading. */
+static ret_code_t Advertising_Configure(Advertising *this, ble_gap_adv_data_t *pAdvData) {
+#if ADVERTISING_SCANNABLE_ENABLED
+    uint8_t *pScanRsp = this->mScanRspData[0];
+    if (this->mpOnAir->scan_rsp_data.p_data == pScanRsp) {
+        pScanRsp = this->mScanRspData[1];
+    }
+    pAdvData->scan_rsp_data.p_data = pScanRsp;
+#endif
+
+    ret_code_t err_code = sd_ble_gap_adv_set_configure(&this->mAdvHandle, pAdvData, NULL);
+    if (err_code == NRF_SUCCESS) {
+        this->mpOnAir = pAdvData;
+    }
+    return err_code;
+}
+
+/**@brief Hands the advertising parameters over to the SoftDevice.
+ *
+ * @details The SoftDevice only accepts new parameters while the set is stopped, so a running set is
+ *          stopped and started again. A set stopped by a connection is only reconfigured, it is started
+ *          again on disconnection.
+ */
+static void Advertising_Reconfigure(Advertising *this) {
+    ret_code_t err_code;
+    if (this->mIsAdvertising) {
+        err_code = sd_ble_gap_adv_stop(this->mAdvHandle);
+#if ENV_SENSING_ENABLED
+        if (err_code == NRF_ERROR_INVALID_STATE) {
+            this->mIsAdvertising = false;
+            err_code = NRF_SUCCESS;
+        }
+#endif
+        APP_ERROR_CHECK(err_code);
+    }
+
+    err_code = sd_ble_gap_adv_set_configure(&this->mAdvHandle, this->mpOnAir, &this->mAdvParams);
+    APP_ERROR_CHECK(err_code);
+
+    if (this->mIsAdvertising) {
+        err_code = sd_ble_gap_adv_start(this->mAdvHandle, this->mConnCfgTag);
+        APP_ERROR_CHECK(err_code);
+        this->mRestartCount++;
+    }
+}
+
+#if ADVERTISING_ROTATION_ENABLED
+/**@brief Takes a published sample into the window of the statistics frame. */
+static void Advertising_AddToWindow(Advertising *this, int16_t temperature, int16_t humidity) {
+    if (this->mWindowCount == 0 || temperature < this->mWindowMin.mTemperature) {
+        this->mWindowMin.mTemperature = temperature;
+    }
+    if (this->mWindowCount == 0 || temperature > this->mWindowMax.mTemperature) {
+        this->mWindowMax.mTemperature = temperature;
+    }
+    if (this->mWindowCount == 0 || humidity < this->mWindowMin.mHumidity) {
+        this->mWindowMin.mHumidity = humidity;
+    }
+    if (this->mWindowCount == 0 || humidity > this->mWindowMax.mHumidity) {
+        this->mWindowMax.mHumidity = humidity;
+    }
+    if (++this->mWindowCount < ADVERTISING_STATISTICS_WINDOW) {
+        return;
+    }
+
+    this->mStatisticsMin = this->mWindowMin;
+    this->mStatisticsMax = this->mWindowMax;
+    this->mHasStatistics = true;
+    this->mWindowCount = 0;
+}
+
+/**@brief Writes a rotated frame from its template, the fields in clear.
+ *
+ * @return Size of the frame, trailer included.
+ */
+static uint16_t Advertising_WriteRotated(Advertising *this, FRAME_ROTATION_FRAME frame, uint8_t *pBeaconInfo) {
+    uint16_t size = m_rotated_info_size[frame - 1];
+    memcpy(pBeaconInfo, m_rotated_info[frame - 1], size);
+    uint8_t *pFields = &pBeaconInfo[BEACON_INFO_FIELDS_INDEX];
+
+    if (frame == FRAME_ROTATION_STATISTICS) {
+        BEACON_SCHEMA_PUT(pFields, STATISTICS, TEMPERATURE_MIN, this->mStatisticsMin.mTemperature);
+        BEACON_SCHEMA_PUT(pFields, STATISTICS, TEMPERATURE_MAX, this->mStatisticsMax.mTemperature);
+        BEACON_SCHEMA_PUT(pFields, STATISTICS, HUMIDITY_MIN, this->mStatisticsMin.mHumidity);
+        BEACON_SCHEMA_PUT(pFields, STATISTICS, HUMIDITY_MAX, this->mStatisticsMax.mHumidity);
+    } else {
+        uint32_t errorCount = this->mFailureCount + this->mHealth.mMissedCount;
+        BEACON_SCHEMA_PUT(pFields, HEALTH, UPTIME, (int32_t)this->mHealth.mUptimeS);
+        BEACON_SCHEMA_PUT(pFields, HEALTH, DIE_TEMPERATURE, this->mHealth.mDieTemperature);
+        BEACON_SCHEMA_PUT(pFields, HEALTH, ERROR_COUNT, (int32_t)MIN(errorCount, UINT16_MAX));
+    }
+    return size;
+}
+#endif
+
+#if BEACON_CRYPTO_ENABLED
+/**@brief Block cipher of BeaconCrypto, on the ECB peripheral through the SoftDevice. */
+static bool Advertising_BlockEncrypt(uint8_t const *pKey, uint8_t const *pIn, uint8_t *pOut) {
+    nrf_ecb_hal_data_t ecbData;
+    memcpy(ecbData.key, pKey, sizeof(ecbData.key));
+    memcpy(ecbData.cleartext, pIn, sizeof(ecbData.cleartext));
+    if (sd_ecb_block_encrypt(&ecbData) != NRF_SUCCESS) {
+        return false;
+    }
+    memcpy(pOut, ecbData.ciphertext, sizeof(ecbData.ciphertext));
+    return true;
+}
+
+/**@brief Derives the device key and starts the frame counter at a random value.
+ *
+ * @details The counter is not kept across resets. Starting at a random value makes it unlikely that a
+ *          nonce used before the reset is used again.
+ */
+static void Advertising_InitCrypto(Advertising *this) {
+    BeaconCrypto_Init(Advertising_BlockEncrypt);
+    if (!BeaconCrypto_DeriveKey(m_master_key, m_device_identifier, this->mKey)) {
+        printf("%s(%d) Failed to derive the device key\n", __func__, __LINE__);
+        APP_ERROR_CHECK(NRF_ERROR_INTERNAL);
+    }
+
+    uint8_t available = 0;
+    while (available < sizeof(this->mCounter)) {
+        ret_code_t err_code = sd_rand_application_bytes_available_get(&available);
+        APP_ERROR_CHECK(err_code);
+    }
+    uint8_t random[sizeof(this->mCounter)];
+    ret_code_t err_code = sd_rand_application_vector_get(random, sizeof(random));
+    APP_ERROR_CHECK(err_code);
+    this->mCounter = uint32_big_decode(random);
+}
+
+/**@brief Encrypts the fields of a frame of the given size and writes the counter and the MIC behind them.
+ *
+ * @details The header is authenticated but stays in clear, so gateways know which key to use. A counter
+ *          value is used once even if the update fails afterwards.
+ */
+static bool Advertising_Seal(Advertising *this, uint8_t *pBeaconInfo, uint16_t size) {
+    uint32_t startCycles = CycleCounter_Get();
+    uint32_t counter = ++this->mCounter;
+    uint8_t nonce[BEACON_CRYPTO_NONCE_SIZE];
+    uint16_t trailerIndex = size - BEACON_INFO_TRAILER_SIZE;
+    uint8_t *pTrailer = &pBeaconInfo[trailerIndex];
+
+    uint32_big_encode(counter, pTrailer);
+    BeaconCrypto_MakeNonce(m_device_identifier, counter, nonce);
+    bool sealed = BeaconCrypto_Seal(this->mKey, nonce, pBeaconInfo, BEACON_INFO_DATA_INDEX,
+                                    &pBeaconInfo[BEACON_INFO_DATA_INDEX], trailerIndex - BEACON_INFO_DATA_INDEX,
+                                    &pTrailer[BEACON_CRYPTO_COUNTER_SIZE]);
+
+    uint32_t cycles = CycleCounter_Get() - startCycles;
+    this->mSealCount++;
+    this->mTotalSealCycles += cycles;
+    if (cycles > this->mMaxSealCycles) {
+        this->mMaxSealCycles = cycles;
+    }
+    return sealed;
+}
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "sdk_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t mUpdateCount;     /**< Number of readings handed over to the SoftDevice. */
+    uint32_t mSkippedCount;    /**< Number of readings within the deadband of the ones on air. */
+    uint32_t mFailureCount;    /**< Number of updates rejected by the SoftDevice. */
+    uint32_t mRestartCount;    /**< Number of restarts to change the interval or the channels. */
+    uint32_t mMaxCycles;       /**< Longest successful update in CPU cycles. */
+    uint32_t mMeanCycles;      /**< Mean successful update in CPU cycles. */
+    uint32_t mMaxSealCycles;   /**< Longest encryption of a frame in CPU cycles, 0 without BEACON_CRYPTO_ENABLED. */
+    uint32_t mMeanSealCycles;  /**< Mean encryption of a frame in CPU cycles. */
+} ADVERTISING_STATS;
+
+typedef struct {
+    uint32_t mUptimeS;         /**< Time since the last reset in seconds. */
+    int16_t mDieTemperature;   /**< Temperature of the chip in 0.25 degC, as sd_temp_get gives it. */
+    uint32_t mMissedCount;     /**< Number of sampling deadlines missed. */
+} ADVERTISING_HEALTH;
+
+void Advertising_Init(void);
+void Advertising_Start(uint8_t connCfgTag);
+void Advertising_SetInterval(uint32_t interval);
+uint32_t Advertising_GetInterval(void);
+#if RADIO_PROFILE_ENABLED
+void Advertising_SetRadio(uint8_t channels, int8_t txPower);
+#endif
+bool Advertising_SetReadings(int16_t temperature, int16_t humidity);
+void Advertising_GetStats(ADVERTISING_STATS *pStats);
+#if ADVERTISING_ROTATION_ENABLED
+void Advertising_SetHealth(ADVERTISING_HEALTH const *pHealth);
+void Advertising_OnAdvertisingEvent(void);
+#endif
+#if ADVERTISING_BENCHMARK_ENABLED
+void Advertising_Benchmark(uint32_t iterations);
+#endif
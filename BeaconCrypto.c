@@ -0,0 +1,170 @@
+#include "BeaconCrypto.h"
+#include <string.h>
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define BEACON_CRYPTO_LENGTH_SIZE   2   /**< Size of the message length and of the block counter (L). */
+/** B0 flags: associated data present, (M - 2) / 2 and L - 1. */
+#define BEACON_CRYPTO_FLAGS_B0      (0x40 | (((BEACON_CRYPTO_MIC_SIZE - 2) / 2) << 3) | (BEACON_CRYPTO_LENGTH_SIZE - 1))
+#define BEACON_CRYPTO_FLAGS_A       (BEACON_CRYPTO_LENGTH_SIZE - 1)
+#define BEACON_CRYPTO_KEY_DOMAIN    0x01  /**< Last byte of the key derivation block. */
+
+typedef struct
+{
+    BEACON_CRYPTO_BLOCK_ENCRYPT *mpEncrypt;
+} BeaconCrypto;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static bool BeaconCrypto_Mac(BeaconCrypto *this, uint8_t const *pKey, uint8_t const *pNonce, uint8_t const *pAad,
+                             uint16_t aadLength, uint8_t const *pData, uint16_t length, uint8_t *pTag);
+static bool BeaconCrypto_Ctr(BeaconCrypto *this, uint8_t const *pKey, uint8_t const *pNonce, uint8_t *pData,
+                             uint16_t length, uint8_t *pS0);
+static bool BeaconCrypto_MacUpdate(BeaconCrypto *this, uint8_t const *pKey, uint8_t *pX, uint8_t const *pData,
+                                   uint16_t length);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static BeaconCrypto beaconCrypto;
+
+void BeaconCrypto_Init(BEACON_CRYPTO_BLOCK_ENCRYPT *pEncrypt) {
+    beaconCrypto.mpEncrypt = pEncrypt;
+}
+
+/**@brief Derives the key of a device: the master key encrypts the identifier, padded with zeros and a domain byte. */
+bool BeaconCrypto_DeriveKey(uint8_t const *pMasterKey, uint8_t const *pIdentifier, uint8_t *pKey) {
+    uint8_t block[BEACON_CRYPTO_BLOCK_SIZE] = { 0 };
+    memcpy(block, pIdentifier, BEACON_CRYPTO_IDENTIFIER_SIZE);
+    block[BEACON_CRYPTO_BLOCK_SIZE - 1] = BEACON_CRYPTO_KEY_DOMAIN;
+    return beaconCrypto.mpEncrypt(pMasterKey, block, pKey);
+}
+
+/**@brief Builds the nonce from the device identifier and the frame counter, big-endian, padded with zeros. */
+void BeaconCrypto_MakeNonce(uint8_t const *pIdentifier, uint32_t counter, uint8_t *pNonce) {
+    memset(pNonce, 0, BEACON_CRYPTO_NONCE_SIZE);
+    memcpy(pNonce, pIdentifier, BEACON_CRYPTO_IDENTIFIER_SIZE);
+    pNonce[BEACON_CRYPTO_IDENTIFIER_SIZE + 0] = (uint8_t)(counter >> 24);
+    pNonce[BEACON_CRYPTO_IDENTIFIER_SIZE + 1] = (uint8_t)(counter >> 16);
+    pNonce[BEACON_CRYPTO_IDENTIFIER_SIZE + 2] = (uint8_t)(counter >> 8);
+    pNonce[BEACON_CRYPTO_IDENTIFIER_SIZE + 3] = (uint8_t)counter;
+}
+
+/**@brief Encrypts pData in place and computes the MIC over pAad and pData.
+ *
+ * @details Costs 2 + ceil((aadLength + 2) / 16) + 2 * ceil(length / 16) block encryptions.
+ *
+ * @retval true  pData holds the ciphertext and pMic the MIC.
+ * @retval false The cipher failed, pData is undefined.
+ */
+bool BeaconCrypto_Seal(uint8_t const *pKey, uint8_t const *pNonce, uint8_t const *pAad, uint16_t aadLength,
+                       uint8_t *pData, uint16_t length, uint8_t *pMic) {
+    uint8_t tag[BEACON_CRYPTO_BLOCK_SIZE];
+    uint8_t s0[BEACON_CRYPTO_BLOCK_SIZE];
+
+    if (!BeaconCrypto_Mac(&beaconCrypto, pKey, pNonce, pAad, aadLength, pData, length, tag) ||
+        !BeaconCrypto_Ctr(&beaconCrypto, pKey, pNonce, pData, length, s0)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < BEACON_CRYPTO_MIC_SIZE; i++) {
+        pMic[i] = tag[i] ^ s0[i];
+    }
+    return true;
+}
+
+/**@brief Decrypts pData in place and checks the MIC.
+ *
+ * @retval true  The frame is authentic, pData holds the plaintext.
+ * @retval false The MIC does not match or the cipher failed, pData is undefined.
+ */
+bool BeaconCrypto_Open(uint8_t const *pKey, uint8_t const *pNonce, uint8_t const *pAad, uint16_t aadLength,
+                       uint8_t *pData, uint16_t length, uint8_t const *pMic) {
+    uint8_t tag[BEACON_CRYPTO_BLOCK_SIZE];
+    uint8_t s0[BEACON_CRYPTO_BLOCK_SIZE];
+
+    if (!BeaconCrypto_Ctr(&beaconCrypto, pKey, pNonce, pData, length, s0) ||
+        !BeaconCrypto_Mac(&beaconCrypto, pKey, pNonce, pAad, aadLength, pData, length, tag)) {
+        return false;
+    }
+
+    // Compare every byte, so that the time taken does not tell how much of a forged MIC is right.
+    uint8_t difference = 0;
+    for (uint32_t i = 0; i < BEACON_CRYPTO_MIC_SIZE; i++) {
+        difference |= (uint8_t)(pMic[i] ^ tag[i] ^ s0[i]);
+    }
+    return difference == 0;
+}
+
+/**@brief CBC-MAC over B0, the length-prefixed associated data and the message, each padded to a block. */
+static bool BeaconCrypto_Mac(BeaconCrypto *this, uint8_t const *pKey, uint8_t const *pNonce, uint8_t const *pAad,
+                             uint16_t aadLength, uint8_t const *pData, uint16_t length, uint8_t *pTag) {
+    uint8_t block[BEACON_CRYPTO_BLOCK_SIZE];
+    block[0] = BEACON_CRYPTO_FLAGS_B0;
+    memcpy(&block[1], pNonce, BEACON_CRYPTO_NONCE_SIZE);
+    block[14] = (uint8_t)(length >> 8);
+    block[15] = (uint8_t)length;
+    if (!this->mpEncrypt(pKey, block, pTag)) {
+        return false;
+    }
+
+    // The associated data is short, so it is copied behind its length instead of being streamed.
+    uint8_t aad[BEACON_CRYPTO_BLOCK_SIZE * 4];
+    if (aadLength > sizeof(aad) - BEACON_CRYPTO_LENGTH_SIZE) {
+        return false;
+    }
+    aad[0] = (uint8_t)(aadLength >> 8);
+    aad[1] = (uint8_t)aadLength;
+    memcpy(&aad[BEACON_CRYPTO_LENGTH_SIZE], pAad, aadLength);
+
+    return BeaconCrypto_MacUpdate(this, pKey, pTag, aad, (uint16_t)(aadLength + BEACON_CRYPTO_LENGTH_SIZE)) &&
+           BeaconCrypto_MacUpdate(this, pKey, pTag, pData, length);
+}
+
+/**@brief XORs the data into the CBC-MAC state block by block, the last block padded with zeros. */
+static bool BeaconCrypto_MacUpdate(BeaconCrypto *this, uint8_t const *pKey, uint8_t *pX, uint8_t const *pData,
+                                   uint16_t length) {
+    uint8_t block[BEACON_CRYPTO_BLOCK_SIZE];
+    for (uint16_t offset = 0; offset < length; offset += BEACON_CRYPTO_BLOCK_SIZE) {
+        uint16_t size = (uint16_t)(length - offset);
+        if (size > BEACON_CRYPTO_BLOCK_SIZE) {
+            size = BEACON_CRYPTO_BLOCK_SIZE;
+        }
+        memcpy(block, pX, BEACON_CRYPTO_BLOCK_SIZE);
+        for (uint16_t i = 0; i < size; i++) {
+            block[i] ^= pData[offset + i];
+        }
+        if (!this->mpEncrypt(pKey, block, pX)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**@brief Counter mode from A1 over the data, and S0 = E(A0) to mask the MIC. */
+static bool BeaconCrypto_Ctr(BeaconCrypto *this, uint8_t const *pKey, uint8_t const *pNonce, uint8_t *pData,
+                             uint16_t length, uint8_t *pS0) {
+    uint8_t counter[BEACON_CRYPTO_BLOCK_SIZE];
+    uint8_t stream[BEACON_CRYPTO_BLOCK_SIZE];
+    counter[0] = BEACON_CRYPTO_FLAGS_A;
+    memcpy(&counter[1], pNonce, BEACON_CRYPTO_NONCE_SIZE);
+    counter[14] = 0;
+    counter[15] = 0;
+    if (!this->mpEncrypt(pKey, counter, pS0)) {
+        return false;
+    }
+
+    uint16_t index = 1;
+    for (uint16_t offset = 0; offset < length; offset += BEACON_CRYPTO_BLOCK_SIZE, index++) {
+        counter[14] = (uint8_t)(index >> 8);
+        counter[15] = (uint8_t)index;
+        if (!this->mpEncrypt(pKey, counter, stream)) {
+            return false;
+        }
+        for (uint16_t i = 0; i < BEACON_CRYPTO_BLOCK_SIZE && offset + i < length; i++) {
+            pData[offset + i] ^= stream[i];
+        }
+    }
+    return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**@brief AES-CCM sealing of beacon payloads (RFC 3610, 4-byte MIC, 13-byte nonce).
+ *
+ * @details The block cipher is supplied by the caller: sd_ecb_block_encrypt on the device, a software AES on
+ *          gateways and host tools. Everything else is plain C with no SDK dependency, so that verifiers use
+ *          the same code as the firmware.
+ *
+ *          Each device has its own key, derived from a fleet master key and the device identifier, so a
+ *          gateway holding the master key can verify any device without a key table. The nonce is the device
+ *          identifier followed by a 32-bit frame counter; a key must never see the same counter twice.
+ *
+ *          The identifier is sent in clear, so the master key alone gives every device key. It is the same in
+ *          every image: read out of one device, it forges frames for all of them. Protect the flash with
+ *          APPROTECT and change the master key of the fleet if a device is lost.
+ */
+
+#define BEACON_CRYPTO_KEY_SIZE          16
+#define BEACON_CRYPTO_BLOCK_SIZE        16
+#define BEACON_CRYPTO_NONCE_SIZE        13
+#define BEACON_CRYPTO_IDENTIFIER_SIZE   4
+#define BEACON_CRYPTO_COUNTER_SIZE      4
+#define BEACON_CRYPTO_MIC_SIZE          4
+
+/**@brief Encrypts one block with AES-128.
+ *
+ * @retval true  pOut holds the ciphertext.
+ * @retval false The cipher failed.
+ */
+typedef bool(BEACON_CRYPTO_BLOCK_ENCRYPT)(uint8_t const *pKey, uint8_t const *pIn, uint8_t *pOut);
+
+void BeaconCrypto_Init(BEACON_CRYPTO_BLOCK_ENCRYPT *pEncrypt);
+bool BeaconCrypto_DeriveKey(uint8_t const *pMasterKey, uint8_t const *pIdentifier, uint8_t *pKey);
+void BeaconCrypto_MakeNonce(uint8_t const *pIdentifier, uint32_t counter, uint8_t *pNonce);
+bool BeaconCrypto_Seal(uint8_t const *pKey, uint8_t const *pNonce, uint8_t const *pAad, uint16_t aadLength,
+                       uint8_t *pData, uint16_t length, uint8_t *pMic);
+bool BeaconCrypto_Open(uint8_t const *pKey, uint8_t const *pNonce, uint8_t const *pAad, uint16_t aadLength,
+                       uint8_t *pData, uint16_t length, uint8_t const *pMic);
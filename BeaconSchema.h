@@ -0,0 +1,143 @@
+#pragma once
+
+#include <stdint.h>
+
+/**@brief Layout of the Open Sensor service data, shared by the firmware and the gateway tools.
+ *
+ * @details The service data starts with the schema version and the identifier, then holds fields made of a
+ *          data type byte and a value. The fields of the readings, statistics and health frames are described
+ *          once in the lists below, and the initial bytes, the position of every field and the decoder tables
+ *          are generated from them at compile time. A field is added with a line in a list, and its writer in
+ *          Advertising.c.
+ *
+ *          The module is plain C with no SDK dependency, so that gateways can use the same description.
+ */
+
+#define DATA_SCHEMA_VERSION             0x01  /**< Reserved area. */
+#define DATA_SCHEMA_VERSION_COMPACT     0x02  /**< Short identifier, the other metadata is in the scan response. */
+#define DATA_SCHEMA_SEALED              0x80  /**< Set in the version of frames ending with a counter and a MIC. */
+
+/* Value formats, a signedness and a byte order. */
+#define BEACON_SCHEMA_UNSIGNED          0x00
+#define BEACON_SCHEMA_SIGNED            0x01
+#define BEACON_SCHEMA_BIG_ENDIAN        0x00
+#define BEACON_SCHEMA_LITTLE_ENDIAN     0x02
+
+/**@brief Fields of a frame, in order: X(frame, name, data type, width in bytes, scale, format).
+ *
+ * @details The value is the reading times the scale. Widths of 1, 2 and 4 bytes are supported. Data types
+ *          are unique across the frames, a decoder tells the frames apart by the type of their first field.
+ */
+#define BEACON_SCHEMA_READINGS(X) \
+    X(READINGS, TEMPERATURE, 0x10, 2, 100, BEACON_SCHEMA_SIGNED | BEACON_SCHEMA_BIG_ENDIAN)    /**< temperature (unit:0.01) */ \
+    X(READINGS, HUMIDITY,    0x11, 2, 100, BEACON_SCHEMA_SIGNED | BEACON_SCHEMA_BIG_ENDIAN)    /**< humidity    (unit:0.01) */ \
+    X(READINGS, SEQUENCE,    0x14, 1, 1,   BEACON_SCHEMA_UNSIGNED | BEACON_SCHEMA_BIG_ENDIAN)  /**< sequence number of the readings, modulo 256 */
+
+#define BEACON_SCHEMA_STATISTICS(X) \
+    X(STATISTICS, TEMPERATURE_MIN, 0x15, 2, 100, BEACON_SCHEMA_SIGNED | BEACON_SCHEMA_BIG_ENDIAN)  /**< lowest temperature of the last window (unit:0.01) */ \
+    X(STATISTICS, TEMPERATURE_MAX, 0x16, 2, 100, BEACON_SCHEMA_SIGNED | BEACON_SCHEMA_BIG_ENDIAN)  /**< highest temperature of the last window (unit:0.01) */ \
+    X(STATISTICS, HUMIDITY_MIN,    0x17, 2, 100, BEACON_SCHEMA_SIGNED | BEACON_SCHEMA_BIG_ENDIAN)  /**< lowest humidity of the last window (unit:0.01) */ \
+    X(STATISTICS, HUMIDITY_MAX,    0x18, 2, 100, BEACON_SCHEMA_SIGNED | BEACON_SCHEMA_BIG_ENDIAN)  /**< highest humidity of the last window (unit:0.01) */
+
+#define BEACON_SCHEMA_HEALTH(X) \
+    X(HEALTH, UPTIME,          0x21, 4, 1, BEACON_SCHEMA_UNSIGNED | BEACON_SCHEMA_BIG_ENDIAN)  /**< time since the last reset (unit:1s) */ \
+    X(HEALTH, DIE_TEMPERATURE, 0x22, 2, 4, BEACON_SCHEMA_SIGNED | BEACON_SCHEMA_BIG_ENDIAN)    /**< temperature of the chip (unit:0.25) */ \
+    X(HEALTH, ERROR_COUNT,     0x23, 2, 1, BEACON_SCHEMA_UNSIGNED | BEACON_SCHEMA_BIG_ENDIAN)  /**< updates rejected and sampling deadlines missed, saturating */
+
+/**@brief Data types of the other frames, whose layout is given with them: X(name, data type). */
+#define BEACON_SCHEMA_OTHER_TYPES(X) \
+    X(HISTORY,            0x12)  /**< index of the newest sample, then temperature and humidity of the newest samples */ \
+    X(HISTORY_COMPRESSED, 0x13)  /**< index of the newest sample, then the newest samples encoded by SampleCodec */ \
+    X(METADATA,           0x20)  /**< firmware version, publishing interval and calibration offsets */
+
+#define BEACON_SCHEMA_DATA_TYPE(frame, name, type, width, scale, format)  DATA_TYPE_##name = (type),
+#define BEACON_SCHEMA_OTHER_TYPE(name, type)                              DATA_TYPE_##name = (type),
+#define BEACON_SCHEMA_INDEXES(frame, name, type, width, scale, format) \
+    BEACON_##frame##_##name##_TYPE_INDEX,                              \
+    BEACON_##frame##_##name##_INDEX,                                   \
+    BEACON_##frame##_##name##_LAST_INDEX = BEACON_##frame##_##name##_INDEX + (width) - 1,
+#define BEACON_SCHEMA_ATTRIBUTES(frame, name, type, width, scale, format) \
+    BEACON_##frame##_##name##_WIDTH = (width),                            \
+    BEACON_##frame##_##name##_FORMAT = (format),
+#define BEACON_SCHEMA_VALUE_1                                             0x00
+#define BEACON_SCHEMA_VALUE_2                                             0x00, 0x00
+#define BEACON_SCHEMA_VALUE_4                                             0x00, 0x00, 0x00, 0x00
+#define BEACON_SCHEMA_BYTES(frame, name, type, width, scale, format)     (type), BEACON_SCHEMA_VALUE_##width,
+#define BEACON_SCHEMA_FIELD_ENTRY(frame, name, type, width, scale, format) \
+    { #name, (type), BEACON_##frame##_##name##_TYPE_INDEX, (width), (scale), (format) },
+
+typedef enum {
+    BEACON_SCHEMA_READINGS(BEACON_SCHEMA_DATA_TYPE)
+    BEACON_SCHEMA_STATISTICS(BEACON_SCHEMA_DATA_TYPE)
+    BEACON_SCHEMA_HEALTH(BEACON_SCHEMA_DATA_TYPE)
+    BEACON_SCHEMA_OTHER_TYPES(BEACON_SCHEMA_OTHER_TYPE)
+} DATA_TYPE;
+
+/* Positions in each frame, from the data type of its first field, and the size of its fields. */
+enum {
+    BEACON_SCHEMA_READINGS(BEACON_SCHEMA_INDEXES)
+    BEACON_READINGS_SIZE
+};
+enum {
+    BEACON_SCHEMA_STATISTICS(BEACON_SCHEMA_INDEXES)
+    BEACON_STATISTICS_SIZE
+};
+enum {
+    BEACON_SCHEMA_HEALTH(BEACON_SCHEMA_INDEXES)
+    BEACON_HEALTH_SIZE
+};
+
+enum {
+    BEACON_SCHEMA_READINGS(BEACON_SCHEMA_ATTRIBUTES)
+    BEACON_SCHEMA_STATISTICS(BEACON_SCHEMA_ATTRIBUTES)
+    BEACON_SCHEMA_HEALTH(BEACON_SCHEMA_ATTRIBUTES)
+};
+
+/* Initial bytes of each frame, the data types with zero values. */
+#define BEACON_READINGS_BYTES           BEACON_SCHEMA_READINGS(BEACON_SCHEMA_BYTES)
+#define BEACON_STATISTICS_BYTES         BEACON_SCHEMA_STATISTICS(BEACON_SCHEMA_BYTES)
+#define BEACON_HEALTH_BYTES             BEACON_SCHEMA_HEALTH(BEACON_SCHEMA_BYTES)
+
+/* Initializers of a BEACON_SCHEMA_FIELD table of each frame, for decoders. */
+#define BEACON_READINGS_FIELDS          BEACON_SCHEMA_READINGS(BEACON_SCHEMA_FIELD_ENTRY)
+#define BEACON_STATISTICS_FIELDS        BEACON_SCHEMA_STATISTICS(BEACON_SCHEMA_FIELD_ENTRY)
+#define BEACON_HEALTH_FIELDS            BEACON_SCHEMA_HEALTH(BEACON_SCHEMA_FIELD_ENTRY)
+
+/**@brief Writes the value of a field into a frame, pFields pointing at the data type of its first field. */
+#define BEACON_SCHEMA_PUT(pFields, frame, name, value) \
+    BeaconSchema_Put(&(pFields)[BEACON_##frame##_##name##_INDEX], BEACON_##frame##_##name##_WIDTH, BEACON_##frame##_##name##_FORMAT, (value))
+
+/**@brief Reads the value of a field from a frame, pFields pointing at the data type of its first field. */
+#define BEACON_SCHEMA_GET(pFields, frame, name) \
+    BeaconSchema_Get(&(pFields)[BEACON_##frame##_##name##_INDEX], BEACON_##frame##_##name##_WIDTH, BEACON_##frame##_##name##_FORMAT)
+
+typedef struct {
+    char const *mpName;
+    uint8_t mType;
+    uint8_t mIndex;     /**< Position of the data type in the frame, the value follows it. */
+    uint8_t mWidth;
+    uint16_t mScale;
+    uint8_t mFormat;
+} BEACON_SCHEMA_FIELD;
+
+/**@brief Writes a value of the given width and format. Inlined with constant arguments, it compiles to the
+ *        byte stores of the field. */
+static inline void BeaconSchema_Put(uint8_t *pData, uint8_t width, uint8_t format, int32_t value) {
+    for (uint8_t i = 0; i < width; i++) {
+        uint8_t shift = (format & BEACON_SCHEMA_LITTLE_ENDIAN) ? (uint8_t)(8 * i) : (uint8_t)(8 * (width - 1 - i));
+        pData[i] = (uint8_t)((uint32_t)value >> shift);
+    }
+}
+
+/**@brief Reads a value of the given width and format, sign-extended when it is signed. */
+static inline int32_t BeaconSchema_Get(uint8_t const *pData, uint8_t width, uint8_t format) {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < width; i++) {
+        uint8_t shift = (format & BEACON_SCHEMA_LITTLE_ENDIAN) ? (uint8_t)(8 * i) : (uint8_t)(8 * (width - 1 - i));
+        value |= (uint32_t)pData[i] << shift;
+    }
+    if ((format & BEACON_SCHEMA_SIGNED) && width < 4 && (value & (1UL << (8 * width - 1)))) {
+        value |= ~0UL << (8 * width);
+    }
+    return (int32_t)value;
+}
@@ -0,0 +1,275 @@
+#include "Connection.h"
+#include "ble.h"
+#include "ble_gap.h"
+#include "ble_hci.h"
+#include "app_error.h"
+#include "app_util.h"
+#include "nrf_sdh_ble.h"
+#include <stdio.h>
+#include <string.h>
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define CONNECTION_DEVICE_NAME          "OpenSensor"
+#define CONNECTION_BLE_OBSERVER_PRIO    1                                      /**< Ahead of the services, which look up the handle on connection. */
+#define CONNECTION_MIN_INTERVAL         MSEC_TO_UNITS(7.5, UNIT_1_25_MS)       /**< Shortest interval the SoftDevice supports. */
+/**@brief Longest interval asked for: every sample streamed at ENV_SENSING_SAMPLE_INTERVAL_MS leaves in the next connection event. */
+#define CONNECTION_MAX_INTERVAL         MSEC_TO_UNITS(ENV_SENSING_SAMPLE_INTERVAL_MS, UNIT_1_25_MS)
+#define CONNECTION_SLAVE_LATENCY        0                                      /**< Every connection event is used, the samples leave as soon as they are taken. */
+#define CONNECTION_SUPERVISION_TIMEOUT  MSEC_TO_UNITS(4000, UNIT_10_MS)
+#if HISTORY_TRANSFER_ENABLED
+#define CONNECTION_HVN_TX_QUEUE_SIZE    8                                      /**< Notifications queued per link, refilled by the transfer as they are sent. */
+#define CONNECTION_PREFERRED_PHY        BLE_GAP_PHY_2MBPS                      /**< Halves the air time of the bulk transfer. */
+#else
+#define CONNECTION_HVN_TX_QUEUE_SIZE    4                                      /**< Notifications queued per link, both readings of 2 samples. */
+#define CONNECTION_PREFERRED_PHY        BLE_GAP_PHY_AUTO                       /**< Left to the central. */
+#endif
+
+STATIC_ASSERT(ENV_SENSING_SAMPLE_INTERVAL_MS >= 8);     // The shortest connection interval is 7.5 ms.
+STATIC_ASSERT(ENV_SENSING_SAMPLE_INTERVAL_MS <= 4000);  // The longest connection interval is 4 s.
+
+typedef struct
+{
+    CONNECTION_HANDLER *mpHandler;
+    uint16_t mConnHandle;
+    uint32_t mConnectCount;
+    uint32_t mIntervalUs;
+    uint8_t mLastReason;
+    uint16_t mAttMtu;
+    uint16_t mDataLength;
+    uint8_t mTxPhy;
+} Connection;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static void Connection_OnBleEvt(ble_evt_t const *pBleEvt, void *pContext);
+static void Connection_OnConnected(Connection *this, ble_gap_evt_t const *pGapEvt);
+static void Connection_Negotiate(Connection *this);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static Connection connection;
+
+static ble_gap_conn_params_t const m_conn_params =
+{
+    .min_conn_interval = CONNECTION_MIN_INTERVAL,
+    .max_conn_interval = CONNECTION_MAX_INTERVAL,
+    .slave_latency     = CONNECTION_SLAVE_LATENCY,
+    .conn_sup_timeout  = CONNECTION_SUPERVISION_TIMEOUT,
+};
+
+NRF_SDH_BLE_OBSERVER(m_connection_observer, CONNECTION_BLE_OBSERVER_PRIO, Connection_OnBleEvt, &connection);
+
+/**@brief Sets the SoftDevice configuration of the link, between nrf_sdh_ble_default_cfg_set and nrf_sdh_ble_enable.
+ *
+ * @details The SoftDevice queues a single notification per link by default, which would drop the humidity
+ *          notification sent right after the temperature one.
+ */
+void Connection_ConfigureStack(uint8_t connCfgTag, uint32_t ramStart) {
+    ble_cfg_t bleCfg;
+    memset(&bleCfg, 0, sizeof(bleCfg));
+    bleCfg.conn_cfg.conn_cfg_tag = connCfgTag;
+    bleCfg.conn_cfg.params.gatts_conn_cfg.hvn_tx_queue_size = CONNECTION_HVN_TX_QUEUE_SIZE;
+    ret_code_t err_code = sd_ble_cfg_set(BLE_CONN_CFG_GATTS, &bleCfg, ramStart);
+    APP_ERROR_CHECK(err_code);
+}
+
+/**@brief Sets the device name and the preferred connection parameters. Call after the BLE stack is enabled. */
+void Connection_Init(CONNECTION_HANDLER *pHandler) {
+    memset(&connection, 0, sizeof(connection));
+    connection.mpHandler = pHandler;
+    connection.mConnHandle = BLE_CONN_HANDLE_INVALID;
+    connection.mAttMtu = BLE_GATT_ATT_MTU_DEFAULT;
+
+    ble_gap_conn_sec_mode_t secMode;
+    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&secMode);
+    ret_code_t err_code = sd_ble_gap_device_name_set(&secMode, (uint8_t const *)CONNECTION_DEVICE_NAME, strlen(CONNECTION_DEVICE_NAME));
+    APP_ERROR_CHECK(err_code);
+
+    err_code = sd_ble_gap_ppcp_set(&m_conn_params);
+    APP_ERROR_CHECK(err_code);
+
+#if HISTORY_TRANSFER_ENABLED
+    // Lets a connection event run past its reserved length while notifications are queued.
+    ble_opt_t opt;
+    memset(&opt, 0, sizeof(opt));
+    opt.common_opt.conn_evt_ext.enable = 1;
+    err_code = sd_ble_opt_set(BLE_COMMON_OPT_CONN_EVT_EXT, &opt);
+    APP_ERROR_CHECK(err_code);
+#endif
+}
+
+bool Connection_IsConnected(void) {
+    return connection.mConnHandle != BLE_CONN_HANDLE_INVALID;
+}
+
+uint16_t Connection_GetHandle(void) {
+    return connection.mConnHandle;
+}
+
+/**@brief ATT MTU of the link, the largest notification carries 3 bytes less. */
+uint16_t Connection_GetMtu(void) {
+    return connection.mAttMtu;
+}
+
+void Connection_GetStats(CONNECTION_STATS *pStats) {
+    pStats->mConnectCount = connection.mConnectCount;
+    pStats->mIntervalUs = connection.mIntervalUs;
+    pStats->mLastReason = connection.mLastReason;
+    pStats->mAttMtu = connection.mAttMtu;
+    pStats->mDataLength = connection.mDataLength;
+    pStats->mTxPhy = connection.mTxPhy;
+}
+
+/**@brief Handles the GAP and GATT procedures every link needs, whatever the services. */
+static void Connection_OnBleEvt(ble_evt_t const *pBleEvt, void *pContext) {
+    Connection *this = (Connection*)pContext;
+    ret_code_t err_code = NRF_SUCCESS;
+
+    switch (pBleEvt->header.evt_id)
+    {
+    case BLE_GAP_EVT_CONNECTED:
+        Connection_OnConnected(this, &pBleEvt->evt.gap_evt);
+        break;
+
+    case BLE_GAP_EVT_DISCONNECTED:
+        printf("%s(%d) Disconnected, reason 0x%02X\n", __func__, __LINE__, pBleEvt->evt.gap_evt.params.disconnected.reason);
+        this->mConnHandle = BLE_CONN_HANDLE_INVALID;
+        this->mIntervalUs = 0;
+        this->mLastReason = pBleEvt->evt.gap_evt.params.disconnected.reason;
+        if (this->mpHandler) this->mpHandler(CONNECTION_EVT_DISCONNECTED);
+        break;
+
+    case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+        this->mIntervalUs = (uint32_t)pBleEvt->evt.gap_evt.params.conn_param_update.conn_params.max_conn_interval * 1250;
+        printf("%s(%d) Connection interval %dus\n", __func__, __LINE__, this->mIntervalUs);
+        break;
+
+    case BLE_GAP_EVT_PHY_UPDATE:
+        this->mTxPhy = pBleEvt->evt.gap_evt.params.phy_update.tx_phy;
+        printf("%s(%d) PHY %d\n", __func__, __LINE__, this->mTxPhy);
+        break;
+
+    case BLE_GAP_EVT_PHY_UPDATE_REQUEST: {
+        ble_gap_phys_t const phys = { .tx_phys = BLE_GAP_PHY_AUTO, .rx_phys = BLE_GAP_PHY_AUTO };
+        err_code = sd_ble_gap_phy_update(pBleEvt->evt.gap_evt.conn_handle, &phys);
+        break;
+    }
+
+    case BLE_GAP_EVT_SEC_PARAMS_REQUEST:
+        // The readings are public, pairing is not supported.
+        err_code = sd_ble_gap_sec_params_reply(pBleEvt->evt.gap_evt.conn_handle, BLE_GAP_SEC_STATUS_PAIRING_NOT_SUPP, NULL, NULL);
+        break;
+
+    case BLE_GAP_EVT_DATA_LENGTH_UPDATE_REQUEST:
+        err_code = sd_ble_gap_data_length_update(pBleEvt->evt.gap_evt.conn_handle, NULL, NULL);
+        break;
+
+    case BLE_GAP_EVT_DATA_LENGTH_UPDATE:
+        this->mDataLength = pBleEvt->evt.gap_evt.params.data_length_update.effective_params.max_tx_octets;
+        printf("%s(%d) Data length %d\n", __func__, __LINE__, this->mDataLength);
+        break;
+
+    case BLE_GATTS_EVT_SYS_ATTR_MISSING:
+        // No bonding, so the CCCDs of a new link start cleared.
+        err_code = sd_ble_gatts_sys_attr_set(pBleEvt->evt.gatts_evt.conn_handle, NULL, 0, 0);
+        break;
+
+    case BLE_GATTS_EVT_EXCHANGE_MTU_REQUEST: {
+        uint16_t clientMtu = pBleEvt->evt.gatts_evt.params.exchange_mtu_request.client_rx_mtu;
+        this->mAttMtu = MAX(MIN(clientMtu, NRF_SDH_BLE_GATT_MAX_MTU_SIZE), BLE_GATT_ATT_MTU_DEFAULT);
+        printf("%s(%d) ATT MTU %d\n", __func__, __LINE__, this->mAttMtu);
+        err_code = sd_ble_gatts_exchange_mtu_reply(pBleEvt->evt.gatts_evt.conn_handle, NRF_SDH_BLE_GATT_MAX_MTU_SIZE);
+        break;
+    }
+
+    case BLE_GATTC_EVT_EXCHANGE_MTU_RSP: {
+        uint16_t serverMtu = pBleEvt->evt.gattc_evt.params.exchange_mtu_rsp.server_rx_mtu;
+        this->mAttMtu = MAX(MIN(serverMtu, NRF_SDH_BLE_GATT_MAX_MTU_SIZE), BLE_GATT_ATT_MTU_DEFAULT);
+        printf("%s(%d) ATT MTU %d\n", __func__, __LINE__, this->mAttMtu);
+        break;
+    }
+
+    case BLE_GATTC_EVT_TIMEOUT:
+        err_code = sd_ble_gap_disconnect(pBleEvt->evt.gattc_evt.conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+        break;
+
+    case BLE_GATTS_EVT_TIMEOUT:
+        err_code = sd_ble_gap_disconnect(pBleEvt->evt.gatts_evt.conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+        break;
+
+    default:
+        break;
+    }
+
+    // The link may be gone by the time a reply is made, which is not an error of this device.
+    if (err_code != NRF_SUCCESS && err_code != BLE_ERROR_INVALID_CONN_HANDLE && err_code != NRF_ERROR_INVALID_STATE) {
+        printf("%s(%d) Error handling event 0x%02X: %d\n", __func__, __LINE__, pBleEvt->header.evt_id, err_code);
+        APP_ERROR_CHECK(err_code);
+    }
+}
+
+/**@brief Asks for a shorter interval when the central picked one too long for the streamed samples.
+ *
+ * @details Phones usually connect at 30 to 50 ms. The central may refuse, in which case the samples are
+ *          queued and leave several per connection event.
+ */
+static void Connection_OnConnected(Connection *this, ble_gap_evt_t const *pGapEvt) {
+    ble_gap_conn_params_t const *pParams = &pGapEvt->params.connected.conn_params;
+    this->mConnHandle = pGapEvt->conn_handle;
+    this->mIntervalUs = (uint32_t)pParams->max_conn_interval * 1250;
+    this->mConnectCount++;
+    this->mAttMtu = BLE_GATT_ATT_MTU_DEFAULT;
+    this->mDataLength = BLE_GAP_DATA_LENGTH_DEFAULT;
+    this->mTxPhy = BLE_GAP_PHY_1MBPS;
+    printf("%s(%d) Connected, interval %dus\n", __func__, __LINE__, this->mIntervalUs);
+
+    if (pParams->max_conn_interval > CONNECTION_MAX_INTERVAL) {
+        ret_code_t err_code = sd_ble_gap_conn_param_update(this->mConnHandle, &m_conn_params);
+        if (err_code != NRF_SUCCESS) {
+            printf("%s(%d) Error requesting connection parameters: %d\n", __func__, __LINE__, err_code);
+        }
+    }
+    Connection_Negotiate(this);
+    if (this->mpHandler) this->mpHandler(CONNECTION_EVT_CONNECTED);
+}
+
+/**@brief Starts the procedures enlarging the packets to what the configuration allows, and the preferred PHY.
+ *
+ * @details Without them every notification is cut to 20 bytes and sent in 27-byte packets at 1 Mbps, whatever
+ *          the central supports. The central may have started a procedure itself, in which case the SoftDevice
+ *          refuses the second one and the result comes from the first.
+ */
+static void Connection_Negotiate(Connection *this) {
+    ret_code_t err_code;
+
+    if (NRF_SDH_BLE_GATT_MAX_MTU_SIZE > BLE_GATT_ATT_MTU_DEFAULT) {
+        err_code = sd_ble_gattc_exchange_mtu_request(this->mConnHandle, NRF_SDH_BLE_GATT_MAX_MTU_SIZE);
+        if (err_code != NRF_SUCCESS) {
+            printf("%s(%d) MTU exchange not started: %d\n", __func__, __LINE__, err_code);
+        }
+    }
+    if (NRF_SDH_BLE_GAP_DATA_LENGTH > BLE_GAP_DATA_LENGTH_DEFAULT) {
+        ble_gap_data_length_params_t const params =
+        {
+            .max_tx_octets  = NRF_SDH_BLE_GAP_DATA_LENGTH,
+            .max_rx_octets  = NRF_SDH_BLE_GAP_DATA_LENGTH,
+            .max_tx_time_us = BLE_GAP_DATA_LENGTH_AUTO,
+            .max_rx_time_us = BLE_GAP_DATA_LENGTH_AUTO,
+        };
+        err_code = sd_ble_gap_data_length_update(this->mConnHandle, &params, NULL);
+        if (err_code != NRF_SUCCESS) {
+            printf("%s(%d) Data length update not started: %d\n", __func__, __LINE__, err_code);
+        }
+    }
+    if (CONNECTION_PREFERRED_PHY != BLE_GAP_PHY_AUTO) {
+        ble_gap_phys_t const phys = { .tx_phys = CONNECTION_PREFERRED_PHY, .rx_phys = CONNECTION_PREFERRED_PHY };
+        err_code = sd_ble_gap_phy_update(this->mConnHandle, &phys);
+        if (err_code != NRF_SUCCESS) {
+            printf("%s(%d) PHY update not started: %d\n", __func__, __LINE__, err_code);
+        }
+    }
+}
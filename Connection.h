@@ -0,0 +1,29 @@
+#pragma once
+
+#include "sdk_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    CONNECTION_EVT_CONNECTED,     /**< A central connected, the SoftDevice stopped advertising. */
+    CONNECTION_EVT_DISCONNECTED,  /**< The link is gone, advertising must be started again. */
+} CONNECTION_EVT;
+
+/**@brief Called from the SoftDevice event interrupt. */
+typedef void(CONNECTION_HANDLER)(CONNECTION_EVT event);
+
+typedef struct {
+    uint32_t mConnectCount;      /**< Number of connections accepted. */
+    uint32_t mIntervalUs;        /**< Connection interval in use in us, 0 while disconnected. */
+    uint8_t mLastReason;         /**< HCI reason of the last disconnection. */
+    uint16_t mAttMtu;            /**< ATT MTU negotiated on the link. */
+    uint16_t mDataLength;        /**< Largest link layer payload sent, in bytes. */
+    uint8_t mTxPhy;              /**< PHY used to send, BLE_GAP_PHY_1MBPS or BLE_GAP_PHY_2MBPS. */
+} CONNECTION_STATS;
+
+void Connection_ConfigureStack(uint8_t connCfgTag, uint32_t ramStart);
+void Connection_Init(CONNECTION_HANDLER *pHandler);
+bool Connection_IsConnected(void);
+uint16_t Connection_GetHandle(void);
+uint16_t Connection_GetMtu(void);
+void Connection_GetStats(CONNECTION_STATS *pStats);
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "TaskScheduler.h"
+#include <stdint.h>
+
+/**@brief Stackless coroutine in the style of protothreads.
+ *
+ * @details The only state is the resume point, so a coroutine costs 2 bytes of RAM.
+ *          The body runs inside a task handler: it is re-entered with the task events on every run
+ *          and continues after the await it is blocked on. Local variables are not preserved across
+ *          awaits, keep them in the driver instance. switch statements cannot span an await.
+ */
+typedef struct {
+    uint16_t mLine;
+} COROUTINE;
+
+typedef enum {
+    COROUTINE_WAITING,
+    COROUTINE_DONE,
+} COROUTINE_STATE;
+
+#define COROUTINE_INIT(pCo) ((pCo)->mLine = 0)
+
+#define COROUTINE_BEGIN(pCo) switch ((pCo)->mLine) { case 0:
+
+#define COROUTINE_END(pCo) } (pCo)->mLine = 0; return COROUTINE_DONE
+
+/**@brief Leaves the coroutine. The next run starts from the beginning. */
+#define COROUTINE_EXIT(pCo) do { (pCo)->mLine = 0; return COROUTINE_DONE; } while (0)
+
+/**@brief Yields at least once, then resumes on the first run where cond is true. */
+#define COROUTINE_AWAIT(pCo, cond)                          \
+    do {                                                    \
+        (pCo)->mLine = __LINE__;                            \
+        return COROUTINE_WAITING;                           \
+        case __LINE__:                                      \
+        if (!(cond)) return COROUTINE_WAITING;              \
+    } while (0)
+
+/**@brief Resumes once one of the events in mask has been posted to the task. */
+#define COROUTINE_AWAIT_EVENT(pCo, events, mask) COROUTINE_AWAIT(pCo, ((events) & (mask)) != 0)
+
+/**@brief Resumes after timeoutTicks RTC ticks, using the deadline of the task with the given event. */
+#define COROUTINE_AWAIT_TICKS(pCo, events, taskId, event, timeoutTicks)     \
+    do {                                                                    \
+        TaskScheduler_PostAfter((taskId), (event), (timeoutTicks));         \
+        COROUTINE_AWAIT_EVENT(pCo, events, event);                          \
+    } while (0)
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "nrf.h"
+#include <stdint.h>
+
+/**@brief Enables the DWT cycle counter. Must be called once before CycleCounter_Get is used. */
+static inline void CycleCounter_Init(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**@brief Returns the current CPU cycle count. Differences are valid across a single wrap. */
+static inline uint32_t CycleCounter_Get(void) {
+    return DWT->CYCCNT;
+}
+
+/**@brief Converts a cycle count to microseconds at the current core clock. */
+static inline uint32_t CycleCounter_ToUs(uint32_t cycles) {
+    return cycles / (SystemCoreClock / 1000000);
+}
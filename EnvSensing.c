@@ -0,0 +1,179 @@
+#include "EnvSensing.h"
+#include "Connection.h"
+#include "ble.h"
+#include "ble_srv_common.h"
+#include "app_error.h"
+#include "app_util.h"
+#include "nrf_sdh_ble.h"
+#include <stdio.h>
+#include <string.h>
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define ENV_SENSING_UUID_SERVICE        0x181A  /**< Environmental Sensing Service. */
+#define ENV_SENSING_UUID_TEMPERATURE    0x2A6E  /**< sint16, 0.01 degC. */
+#define ENV_SENSING_UUID_HUMIDITY       0x2A6F  /**< uint16, 0.01 %RH. */
+#define ENV_SENSING_VALUE_SIZE          2
+#define ENV_SENSING_BLE_OBSERVER_PRIO   2       /**< After Connection, which tracks the link. */
+
+typedef enum {
+    ENV_SENSING_CHAR_TEMPERATURE,
+    ENV_SENSING_CHAR_HUMIDITY,
+    ENV_SENSING_CHAR_COUNT,
+} ENV_SENSING_CHAR;
+
+typedef struct
+{
+    uint16_t mServiceHandle;
+    ble_gatts_char_handles_t mHandles[ENV_SENSING_CHAR_COUNT];
+    bool mIsNotifying[ENV_SENSING_CHAR_COUNT];  // CCCD of the characteristic on the current link.
+    uint32_t mNotifiedCount;
+    uint32_t mDroppedCount;
+} EnvSensing;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static void EnvSensing_AddCharacteristic(EnvSensing *this, ENV_SENSING_CHAR index, uint16_t uuid);
+static void EnvSensing_Update(EnvSensing *this, ENV_SENSING_CHAR index, uint16_t value);
+static void EnvSensing_OnBleEvt(ble_evt_t const *pBleEvt, void *pContext);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static EnvSensing envSensing;
+
+static uint16_t const m_char_uuid[ENV_SENSING_CHAR_COUNT] =
+{
+    ENV_SENSING_UUID_TEMPERATURE,
+    ENV_SENSING_UUID_HUMIDITY,
+};
+
+NRF_SDH_BLE_OBSERVER(m_env_sensing_observer, ENV_SENSING_BLE_OBSERVER_PRIO, EnvSensing_OnBleEvt, &envSensing);
+
+/**@brief Adds the service with a readable and notifiable characteristic per reading. */
+void EnvSensing_Init(void) {
+    memset(&envSensing, 0, sizeof(envSensing));
+
+    ble_uuid_t serviceUuid;
+    BLE_UUID_BLE_ASSIGN(serviceUuid, ENV_SENSING_UUID_SERVICE);
+    ret_code_t err_code = sd_ble_gatts_service_add(BLE_GATTS_SRVC_TYPE_PRIMARY, &serviceUuid, &envSensing.mServiceHandle);
+    APP_ERROR_CHECK(err_code);
+
+    for (size_t i = 0; i < ENV_SENSING_CHAR_COUNT; i++) {
+        EnvSensing_AddCharacteristic(&envSensing, (ENV_SENSING_CHAR)i, m_char_uuid[i]);
+    }
+}
+
+/**@brief Updates both characteristics and notifies them to a subscribed central. Values are in 0.01 units.
+ *
+ * @details The ESS humidity is unsigned, the calibration offset cannot make it negative.
+ */
+void EnvSensing_SetReadings(int16_t temperature, int16_t humidity) {
+    EnvSensing_Update(&envSensing, ENV_SENSING_CHAR_TEMPERATURE, (uint16_t)temperature);
+    EnvSensing_Update(&envSensing, ENV_SENSING_CHAR_HUMIDITY, (uint16_t)((humidity < 0) ? 0 : humidity));
+}
+
+bool EnvSensing_IsNotifying(void) {
+    return envSensing.mIsNotifying[ENV_SENSING_CHAR_TEMPERATURE] || envSensing.mIsNotifying[ENV_SENSING_CHAR_HUMIDITY];
+}
+
+void EnvSensing_GetStats(ENV_SENSING_STATS *pStats) {
+    pStats->mNotifiedCount = envSensing.mNotifiedCount;
+    pStats->mDroppedCount = envSensing.mDroppedCount;
+}
+
+static void EnvSensing_AddCharacteristic(EnvSensing *this, ENV_SENSING_CHAR index, uint16_t uuid) {
+    uint8_t initValue[ENV_SENSING_VALUE_SIZE] = { 0 };
+    ble_add_char_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.uuid              = uuid;
+    params.uuid_type         = BLE_UUID_TYPE_BLE;
+    params.max_len           = ENV_SENSING_VALUE_SIZE;
+    params.init_len          = ENV_SENSING_VALUE_SIZE;
+    params.p_init_value      = initValue;
+    params.char_props.read   = 1;
+    params.char_props.notify = 1;
+    params.read_access       = SEC_OPEN;
+    params.cccd_write_access = SEC_OPEN;
+
+    ret_code_t err_code = characteristic_add(this->mServiceHandle, &params, &this->mHandles[index]);
+    APP_ERROR_CHECK(err_code);
+}
+
+/**@brief Writes the value for reads, then queues a notification if the central subscribed to it.
+ *
+ * @details A full queue means the central polls slower than the samples come, the sample is dropped
+ *          rather than delaying the ones behind it.
+ */
+static void EnvSensing_Update(EnvSensing *this, ENV_SENSING_CHAR index, uint16_t value) {
+    uint8_t data[ENV_SENSING_VALUE_SIZE];
+    uint16_t length = uint16_encode(value, data);
+
+    ble_gatts_value_t gattsValue;
+    memset(&gattsValue, 0, sizeof(gattsValue));
+    gattsValue.len     = length;
+    gattsValue.p_value = data;
+    ret_code_t err_code = sd_ble_gatts_value_set(BLE_CONN_HANDLE_INVALID, this->mHandles[index].value_handle, &gattsValue);
+    APP_ERROR_CHECK(err_code);
+
+    uint16_t connHandle = Connection_GetHandle();
+    if (!this->mIsNotifying[index] || connHandle == BLE_CONN_HANDLE_INVALID) {
+        return;
+    }
+
+    ble_gatts_hvx_params_t hvx;
+    memset(&hvx, 0, sizeof(hvx));
+    hvx.handle = this->mHandles[index].value_handle;
+    hvx.type   = BLE_GATT_HVX_NOTIFICATION;
+    hvx.p_len  = &length;
+    hvx.p_data = data;
+    err_code = sd_ble_gatts_hvx(connHandle, &hvx);
+    switch (err_code)
+    {
+    case NRF_SUCCESS:
+        this->mNotifiedCount++;
+        break;
+
+    case NRF_ERROR_RESOURCES:
+        this->mDroppedCount++;
+        break;
+
+    case NRF_ERROR_INVALID_STATE:
+    case BLE_ERROR_INVALID_CONN_HANDLE:
+    case BLE_ERROR_GATTS_SYS_ATTR_MISSING:
+        // The link went down or the central unsubscribed since the checks above.
+        break;
+
+    default:
+        printf("%s(%d) Error sending notification: %d\n", __func__, __LINE__, err_code);
+        break;
+    }
+}
+
+/**@brief Tracks the CCCDs of the current link. They start cleared on every link, as there is no bonding. */
+static void EnvSensing_OnBleEvt(ble_evt_t const *pBleEvt, void *pContext) {
+    EnvSensing *this = (EnvSensing*)pContext;
+
+    switch (pBleEvt->header.evt_id)
+    {
+    case BLE_GAP_EVT_CONNECTED:
+    case BLE_GAP_EVT_DISCONNECTED:
+        memset(this->mIsNotifying, 0, sizeof(this->mIsNotifying));
+        break;
+
+    case BLE_GATTS_EVT_WRITE: {
+        ble_gatts_evt_write_t const *pWrite = &pBleEvt->evt.gatts_evt.params.write;
+        for (size_t i = 0; i < ENV_SENSING_CHAR_COUNT; i++) {
+            if (pWrite->handle == this->mHandles[i].cccd_handle && pWrite->len == BLE_CCCD_VALUE_LEN) {
+                this->mIsNotifying[i] = ble_srv_is_notification_enabled(pWrite->data);
+            }
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
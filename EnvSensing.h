@@ -0,0 +1,15 @@
+#pragma once
+
+#include "sdk_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t mNotifiedCount;   /**< Number of notifications queued in the SoftDevice. */
+    uint32_t mDroppedCount;    /**< Number of notifications dropped because the queue was full. */
+} ENV_SENSING_STATS;
+
+void EnvSensing_Init(void);
+void EnvSensing_SetReadings(int16_t temperature, int16_t humidity);
+bool EnvSensing_IsNotifying(void);
+void EnvSensing_GetStats(ENV_SENSING_STATS *pStats);
@@ -0,0 +1,82 @@
+#include "FrameRotation.h"
+#include "app_util.h"
+#include <stdbool.h>
+#include <string.h>
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+// A rotated frame is never on air on two events in a row, so its buffer can be rewritten when it is due again.
+STATIC_ASSERT(ADVERTISING_ROTATION_STATISTICS_EVERY == 0 || ADVERTISING_ROTATION_STATISTICS_EVERY >= 2);
+STATIC_ASSERT(ADVERTISING_ROTATION_HEALTH_EVERY == 0 || ADVERTISING_ROTATION_HEALTH_EVERY >= 2);
+
+typedef struct
+{
+    uint32_t mCountdown[FRAME_ROTATION_COUNT];  // Events until the frame is due, 0 while it is due.
+    uint32_t mEventCount;
+    uint32_t mFrameCount[FRAME_ROTATION_COUNT];
+    uint32_t mDeferredCount;
+} FrameRotation;
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static FrameRotation frameRotation;
+
+static uint32_t const m_every[FRAME_ROTATION_COUNT] =  /**< Events between two of each frame, 0 for never. */
+{
+    1,
+    ADVERTISING_ROTATION_STATISTICS_EVERY,
+    ADVERTISING_ROTATION_HEALTH_EVERY,
+};
+
+/**@brief Starts with the readings, every rotated frame is first due after its whole period. */
+void FrameRotation_Init(void) {
+    memset(&frameRotation, 0, sizeof(frameRotation));
+    for (size_t i = 0; i < FRAME_ROTATION_COUNT; i++) {
+        frameRotation.mCountdown[i] = m_every[i];
+    }
+}
+
+/**@brief Chooses the frame of the next advertising event, among the frames of readyMask and the readings. */
+FRAME_ROTATION_FRAME FrameRotation_Next(uint32_t readyMask) {
+    FrameRotation *this = &frameRotation;
+    FRAME_ROTATION_FRAME frame = FRAME_ROTATION_READINGS;
+    bool isWaiting = false;
+
+    for (size_t i = FRAME_ROTATION_READINGS + 1; i < FRAME_ROTATION_COUNT; i++) {
+        if (m_every[i] == 0) {
+            continue;
+        }
+        if (this->mCountdown[i] > 0) {
+            this->mCountdown[i]--;
+        }
+        if (this->mCountdown[i] > 0) {
+            continue;
+        }
+        if (!(readyMask & FRAME_ROTATION_MASK(i)) || (frame != FRAME_ROTATION_READINGS && m_every[i] <= m_every[frame])) {
+            isWaiting = true;
+            continue;
+        }
+        if (frame != FRAME_ROTATION_READINGS) {
+            isWaiting = true;
+        }
+        frame = (FRAME_ROTATION_FRAME)i;
+    }
+
+    if (frame != FRAME_ROTATION_READINGS) {
+        this->mCountdown[frame] = m_every[frame];
+    }
+    this->mEventCount++;
+    this->mFrameCount[frame]++;
+    if (isWaiting) {
+        this->mDeferredCount++;
+    }
+    return frame;
+}
+
+void FrameRotation_GetStats(FRAME_ROTATION_STATS *pStats) {
+    pStats->mEventCount = frameRotation.mEventCount;
+    memcpy(pStats->mFrameCount, frameRotation.mFrameCount, sizeof(pStats->mFrameCount));
+    pStats->mDeferredCount = frameRotation.mDeferredCount;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "sdk_config.h"
+#include <stdint.h>
+
+/**@brief Chooses the frame of every advertising event.
+ *
+ * @details Each rotated frame is due once every so many events, and the readings take the events no other
+ *          frame takes. When several frames are due on the same event the rarest one goes first, the others
+ *          stay due and follow on the next events. A frame that is due but not ready, because it has no data
+ *          yet or the readings must not be displaced, waits without losing its turn.
+ */
+
+typedef enum {
+    FRAME_ROTATION_READINGS,    /**< Readings or history, on every event no other frame takes. */
+    FRAME_ROTATION_STATISTICS,  /**< Extremes of the last window, every ADVERTISING_ROTATION_STATISTICS_EVERY events. */
+    FRAME_ROTATION_HEALTH,      /**< Device health, every ADVERTISING_ROTATION_HEALTH_EVERY events. */
+    FRAME_ROTATION_COUNT,
+} FRAME_ROTATION_FRAME;
+
+#define FRAME_ROTATION_MASK(frame)  (1UL << (frame))
+
+typedef struct {
+    uint32_t mEventCount;                        /**< Number of events chosen for. */
+    uint32_t mFrameCount[FRAME_ROTATION_COUNT];  /**< Number of events given to each frame. */
+    uint32_t mDeferredCount;                     /**< Number of events on which a due frame had to wait. */
+} FRAME_ROTATION_STATS;
+
+void FrameRotation_Init(void);
+FRAME_ROTATION_FRAME FrameRotation_Next(uint32_t readyMask);
+void FrameRotation_GetStats(FRAME_ROTATION_STATS *pStats);
@@ -0,0 +1,279 @@
+#include "HistoryTransfer.h"
+#include "Connection.h"
+#include "SampleHistory.h"
+#include "TaskScheduler.h"
+#include "TimerManager.h"
+#include "ble.h"
+#include "ble_srv_common.h"
+#include "app_error.h"
+#include "app_util.h"
+#include "nrf_sdh_ble.h"
+#include <stdio.h>
+#include <string.h>
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#if HISTORY_TRANSFER_ENABLED && !ENV_SENSING_ENABLED
+#error "HISTORY_TRANSFER_ENABLED requires ENV_SENSING_ENABLED"
+#endif
+
+/** 4F70xxxx-656E-5365-6E73-6F7248697374, little-endian. */
+#define HISTORY_TRANSFER_UUID_BASE          { 0x74, 0x73, 0x69, 0x48, 0x72, 0x6F, 0x73, 0x6E, \
+                                              0x65, 0x53, 0x6E, 0x65, 0x00, 0x00, 0x70, 0x4F }
+#define HISTORY_TRANSFER_UUID_SERVICE       0x0001
+#define HISTORY_TRANSFER_UUID_CONTROL       0x0002
+#define HISTORY_TRANSFER_UUID_DATA          0x0003
+#define HISTORY_TRANSFER_BLE_OBSERVER_PRIO  2       /**< After Connection, which tracks the link and the MTU. */
+#define HISTORY_TRANSFER_TASK_PRIORITY      3       /**< Below the application task, the transfer only uses idle time. */
+
+#define HISTORY_TRANSFER_OP_START           0x01
+#define HISTORY_TRANSFER_OP_STOP            0x02
+#define HISTORY_TRANSFER_CONTROL_SIZE       5       /**< Opcode and index. */
+#define HISTORY_TRANSFER_ATT_HEADER_SIZE    3       /**< Opcode and handle of a notification. */
+#define HISTORY_TRANSFER_HEADER_SIZE        4       /**< Index of the first sample. */
+#define HISTORY_TRANSFER_SAMPLE_SIZE        4
+#define HISTORY_TRANSFER_DATA_MAX_SIZE      (NRF_SDH_BLE_GATT_MAX_MTU_SIZE - HISTORY_TRANSFER_ATT_HEADER_SIZE)
+
+/* Task events */
+#define HISTORY_TRANSFER_EVT_START          (1UL << 0)
+#define HISTORY_TRANSFER_EVT_STOP           (1UL << 1)
+#define HISTORY_TRANSFER_EVT_TX_COMPLETE    (1UL << 2)
+
+STATIC_ASSERT(HISTORY_TRANSFER_DATA_MAX_SIZE >= HISTORY_TRANSFER_HEADER_SIZE + HISTORY_TRANSFER_SAMPLE_SIZE);
+
+typedef struct
+{
+    TASK_ID mTaskId;
+    uint8_t mUuidType;
+    uint16_t mServiceHandle;
+    ble_gatts_char_handles_t mControlHandles;
+    ble_gatts_char_handles_t mDataHandles;
+    volatile uint32_t mRequestIndex;  // Written by the SoftDevice event handler before it posts the start event.
+    bool mIsActive;
+    uint32_t mNextIndex;
+    uint32_t mStartTicks;
+    uint32_t mSampleCount;
+    uint32_t mByteCount;
+    HISTORY_TRANSFER_STATS mStats;
+} HistoryTransfer;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static void HistoryTransfer_AddCharacteristic(HistoryTransfer *this, uint16_t uuid, ble_add_char_params_t *pParams,
+                                              ble_gatts_char_handles_t *pHandles);
+static void HistoryTransfer_Task(void *pContext, uint32_t events);
+static void HistoryTransfer_Start(HistoryTransfer *this, uint32_t index);
+static void HistoryTransfer_Stop(HistoryTransfer *this);
+static void HistoryTransfer_Pump(HistoryTransfer *this);
+static void HistoryTransfer_Finish(HistoryTransfer *this);
+#if HISTORY_TRANSFER_ENABLED
+static void HistoryTransfer_OnBleEvt(ble_evt_t const *pBleEvt, void *pContext);
+#endif
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static HistoryTransfer historyTransfer;
+
+#if HISTORY_TRANSFER_ENABLED
+NRF_SDH_BLE_OBSERVER(m_history_transfer_observer, HISTORY_TRANSFER_BLE_OBSERVER_PRIO, HistoryTransfer_OnBleEvt, &historyTransfer);
+#endif
+
+/**@brief Adds the service. Call after the BLE stack is enabled. */
+void HistoryTransfer_Init(void) {
+    memset(&historyTransfer, 0, sizeof(historyTransfer));
+    historyTransfer.mTaskId = TaskScheduler_Create(HistoryTransfer_Task, &historyTransfer, HISTORY_TRANSFER_TASK_PRIORITY);
+
+    ble_uuid128_t base = { HISTORY_TRANSFER_UUID_BASE };
+    ret_code_t err_code = sd_ble_uuid_vs_add(&base, &historyTransfer.mUuidType);
+    APP_ERROR_CHECK(err_code);
+
+    ble_uuid_t serviceUuid = { .uuid = HISTORY_TRANSFER_UUID_SERVICE, .type = historyTransfer.mUuidType };
+    err_code = sd_ble_gatts_service_add(BLE_GATTS_SRVC_TYPE_PRIMARY, &serviceUuid, &historyTransfer.mServiceHandle);
+    APP_ERROR_CHECK(err_code);
+
+    ble_add_char_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.max_len                  = HISTORY_TRANSFER_CONTROL_SIZE;
+    params.is_var_len               = true;
+    params.char_props.write         = 1;
+    params.char_props.write_wo_resp = 1;
+    params.write_access             = SEC_OPEN;
+    HistoryTransfer_AddCharacteristic(&historyTransfer, HISTORY_TRANSFER_UUID_CONTROL, &params, &historyTransfer.mControlHandles);
+
+    memset(&params, 0, sizeof(params));
+    params.max_len           = HISTORY_TRANSFER_DATA_MAX_SIZE;
+    params.is_var_len        = true;
+    params.char_props.notify = 1;
+    params.cccd_write_access = SEC_OPEN;
+    HistoryTransfer_AddCharacteristic(&historyTransfer, HISTORY_TRANSFER_UUID_DATA, &params, &historyTransfer.mDataHandles);
+}
+
+bool HistoryTransfer_IsActive(void) {
+    return historyTransfer.mIsActive;
+}
+
+void HistoryTransfer_GetStats(HISTORY_TRANSFER_STATS *pStats) {
+    *pStats = historyTransfer.mStats;
+}
+
+static void HistoryTransfer_AddCharacteristic(HistoryTransfer *this, uint16_t uuid, ble_add_char_params_t *pParams,
+                                              ble_gatts_char_handles_t *pHandles) {
+    pParams->uuid      = uuid;
+    pParams->uuid_type = this->mUuidType;
+    ret_code_t err_code = characteristic_add(this->mServiceHandle, pParams, pHandles);
+    APP_ERROR_CHECK(err_code);
+}
+
+static void HistoryTransfer_Task(void *pContext, uint32_t events) {
+    HistoryTransfer *this = (HistoryTransfer*)pContext;
+
+    if (events & HISTORY_TRANSFER_EVT_STOP) {
+        HistoryTransfer_Stop(this);
+    }
+    if (events & HISTORY_TRANSFER_EVT_START) {
+        HistoryTransfer_Start(this, this->mRequestIndex);
+    }
+    // A free slot in the notification queue, or a new transfer to fill it with.
+    if (this->mIsActive) {
+        HistoryTransfer_Pump(this);
+    }
+}
+
+/**@brief Starts a transfer from index, restarting the current one if any. */
+static void HistoryTransfer_Start(HistoryTransfer *this, uint32_t index) {
+    if (this->mIsActive) {
+        this->mStats.mAbortedCount++;
+    }
+    this->mIsActive = true;
+    this->mNextIndex = index;
+    this->mStartTicks = TimerManager_GetTicks();
+    this->mSampleCount = 0;
+    this->mByteCount = 0;
+    printf("%s(%d) Transfer from %d, %d samples held up to %d\n", __func__, __LINE__, index, SampleHistory_GetCount(), SampleHistory_GetTotal());
+}
+
+static void HistoryTransfer_Stop(HistoryTransfer *this) {
+    if (!this->mIsActive) {
+        return;
+    }
+    this->mIsActive = false;
+    this->mStats.mAbortedCount++;
+    printf("%s(%d) Transfer stopped at %d after %d samples\n", __func__, __LINE__, this->mNextIndex, this->mSampleCount);
+}
+
+/**@brief Queues notifications until the SoftDevice queue is full or the transfer has caught up with the history.
+ *
+ * @details Each notification takes as many samples as the MTU negotiated on the link allows, 60 with a 247-byte
+ *          MTU. A full queue ends the run, BLE_GATTS_EVT_HVN_TX_COMPLETE resumes it once notifications are sent.
+ *          Samples added during the transfer are sent as well, the end marker goes out once none is left.
+ */
+static void HistoryTransfer_Pump(HistoryTransfer *this) {
+    uint8_t data[HISTORY_TRANSFER_DATA_MAX_SIZE];
+    uint16_t maxCount = (uint16_t)((Connection_GetMtu() - HISTORY_TRANSFER_ATT_HEADER_SIZE - HISTORY_TRANSFER_HEADER_SIZE) /
+                                   HISTORY_TRANSFER_SAMPLE_SIZE);
+
+    while (this->mIsActive) {
+        uint32_t total = SampleHistory_GetTotal();
+        uint32_t oldest = total - SampleHistory_GetCount();
+        if (this->mNextIndex < oldest) {
+            // Overwritten before they could be sent, or asked for after they were.
+            this->mNextIndex = oldest;
+        } else if (this->mNextIndex > total) {
+            this->mNextIndex = total;
+        }
+
+        uint32_t count = total - this->mNextIndex;
+        if (count > maxCount) {
+            count = maxCount;
+        }
+        uint16_t length = uint32_encode(this->mNextIndex, data);
+        for (uint32_t i = 0; i < count; i++) {
+            SAMPLE sample;
+            SampleHistory_Get(total - 1 - (this->mNextIndex + i), &sample);
+            length += uint16_encode((uint16_t)sample.mTemperature, &data[length]);
+            length += uint16_encode((uint16_t)sample.mHumidity, &data[length]);
+        }
+
+        ble_gatts_hvx_params_t hvx;
+        memset(&hvx, 0, sizeof(hvx));
+        hvx.handle = this->mDataHandles.value_handle;
+        hvx.type   = BLE_GATT_HVX_NOTIFICATION;
+        hvx.p_len  = &length;
+        hvx.p_data = data;
+        ret_code_t err_code = sd_ble_gatts_hvx(Connection_GetHandle(), &hvx);
+        switch (err_code)
+        {
+        case NRF_SUCCESS:
+            this->mNextIndex += count;
+            this->mSampleCount += count;
+            this->mByteCount += length;
+            if (count == 0) {
+                HistoryTransfer_Finish(this);
+            }
+            break;
+
+        case NRF_ERROR_RESOURCES:
+            return;
+
+        default:
+            // The link is gone or the central did not enable the notifications.
+            printf("%s(%d) Error sending samples: %d\n", __func__, __LINE__, err_code);
+            HistoryTransfer_Stop(this);
+            break;
+        }
+    }
+}
+
+/**@brief Ends the transfer once the end marker is queued and reports the throughput. */
+static void HistoryTransfer_Finish(HistoryTransfer *this) {
+    uint32_t durationMs = TimerManager_TicksToUs(TimerManager_GetTicksSince(this->mStartTicks)) / 1000;
+
+    this->mIsActive = false;
+    this->mStats.mTransferCount++;
+    this->mStats.mSampleCount = this->mSampleCount;
+    this->mStats.mByteCount = this->mByteCount;
+    this->mStats.mDurationMs = durationMs;
+    this->mStats.mThroughputBps = (durationMs > 0) ? (uint32_t)(((uint64_t)this->mByteCount * 8 * 1000) / durationMs) : 0;
+    printf("%s(%d) Transfer done: %d samples, %d bytes in %dms, %dbps\n", __func__, __LINE__,
+           this->mSampleCount, this->mByteCount, durationMs, this->mStats.mThroughputBps);
+}
+
+#if HISTORY_TRANSFER_ENABLED
+/**@brief Runs in the SoftDevice interrupt, only records the request and wakes up the task. */
+static void HistoryTransfer_OnBleEvt(ble_evt_t const *pBleEvt, void *pContext) {
+    HistoryTransfer *this = (HistoryTransfer*)pContext;
+
+    switch (pBleEvt->header.evt_id)
+    {
+    case BLE_GAP_EVT_DISCONNECTED:
+        TaskScheduler_Post(this->mTaskId, HISTORY_TRANSFER_EVT_STOP);
+        break;
+
+    case BLE_GATTS_EVT_WRITE: {
+        ble_gatts_evt_write_t const *pWrite = &pBleEvt->evt.gatts_evt.params.write;
+        if (pWrite->handle != this->mControlHandles.value_handle || pWrite->len < 1) {
+            break;
+        }
+        if (pWrite->data[0] == HISTORY_TRANSFER_OP_START && pWrite->len == HISTORY_TRANSFER_CONTROL_SIZE) {
+            this->mRequestIndex = uint32_decode(&pWrite->data[1]);
+            TaskScheduler_Post(this->mTaskId, HISTORY_TRANSFER_EVT_START);
+        } else if (pWrite->data[0] == HISTORY_TRANSFER_OP_STOP) {
+            TaskScheduler_Post(this->mTaskId, HISTORY_TRANSFER_EVT_STOP);
+        } else {
+            printf("%s(%d) Invalid request 0x%02X, %d bytes\n", __func__, __LINE__, pWrite->data[0], pWrite->len);
+        }
+        break;
+    }
+
+    case BLE_GATTS_EVT_HVN_TX_COMPLETE:
+        TaskScheduler_Post(this->mTaskId, HISTORY_TRANSFER_EVT_TX_COMPLETE);
+        break;
+
+    default:
+        break;
+    }
+}
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "sdk_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**@brief Bulk download of the sample history over a vendor-specific GATT service.
+ *
+ * @details Service 4F700001-656E-5365-6E73-6F7248697374 has two characteristics:
+ *          - Control point 0x0002, written by the central: opcode 0x01 followed by the index of the first
+ *            sample wanted (uint32) starts a transfer, opcode 0x02 stops it.
+ *          - Data 0x0003, notified: the index of the first sample in the notification (uint32) followed by
+ *            as many samples as the ATT MTU allows, temperature and humidity as int16 in 0.01 units.
+ *            A notification without samples ends the transfer, its index is the one to resume from.
+ *          Indexes count the samples since boot, all fields are little-endian. A transfer starting before the
+ *          oldest sample held starts at the oldest one, so a central resuming after a long disconnection
+ *          sees the gap in the index of the first notification.
+ */
+
+typedef struct {
+    uint32_t mTransferCount;   /**< Number of transfers run to the end marker. */
+    uint32_t mAbortedCount;    /**< Number of transfers stopped by the central or the link. */
+    uint32_t mSampleCount;     /**< Samples sent by the last complete transfer. */
+    uint32_t mByteCount;       /**< Notification bytes sent by the last complete transfer. */
+    uint32_t mDurationMs;      /**< Time from the request to the end marker of the last complete transfer. */
+    uint32_t mThroughputBps;   /**< Notification throughput of the last complete transfer in bit/s. */
+} HISTORY_TRANSFER_STATS;
+
+void HistoryTransfer_Init(void);
+bool HistoryTransfer_IsActive(void);
+void HistoryTransfer_GetStats(HISTORY_TRANSFER_STATS *pStats);
@@ -0,0 +1,132 @@
+#include "RadioProfile.h"
+#include "app_util.h"
+#include <stdio.h>
+#include <string.h>
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define RADIO_PROFILE_CHANNEL_US        400     /**< A legacy frame of 31 bytes on 1M PHY and the radio ramp-up, per channel. */
+#define RADIO_PROFILE_ADV_DELAY_MEAN_MS 5       /**< Mean of the random delay the link layer adds to every event. */
+#define RADIO_PROFILE_SECONDS_PER_DAY   86400UL
+
+STATIC_ASSERT(RADIO_PROFILE_DENSE_CHANNELS > 0 && RADIO_PROFILE_DENSE_CHANNELS <= RADIO_PROFILE_CHANNELS_ALL);  // At least one primary channel.
+STATIC_ASSERT(RADIO_PROFILE_DEFAULT < RADIO_PROFILE_COUNT);
+
+typedef struct
+{
+    RADIO_PROFILE mProfile;
+    uint32_t mChangeCount;
+    uint32_t mEventCount[RADIO_PROFILE_COUNT];
+} RadioProfile;
+
+typedef struct
+{
+    int8_t mTxPower;        // dBm
+    uint16_t mCurrentUa;    // Radio and regulator while transmitting.
+} RadioProfileTxCurrent;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static uint32_t RadioProfile_GetTxCurrentUa(int8_t txPower);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static RadioProfile radioProfile;
+
+static RADIO_PROFILE_CONFIG const m_configs[RADIO_PROFILE_COUNT] =
+{
+    { "dense",    RADIO_PROFILE_DENSE_CHANNELS, RADIO_PROFILE_DENSE_TX_POWER },
+    { "standard", RADIO_PROFILE_CHANNELS_ALL,   0 },
+    { "sparse",   RADIO_PROFILE_CHANNELS_ALL,   RADIO_PROFILE_SPARSE_TX_POWER },
+};
+
+/** Transmit current of the nRF52840 with the DC/DC converter at 3 V, by increasing power, rounded from the
+ *  product specification. The powers are the ones the S140 accepts. */
+static RadioProfileTxCurrent const m_tx_currents[] =
+{
+    { -40, 2300 }, { -20, 3200 }, { -16, 3500 }, { -12, 3900 }, { -8, 4400 }, { -4, 5100 }, { 0, 6400 },
+    { 2, 7800 }, { 3, 8800 }, { 4, 9600 }, { 5, 10400 }, { 6, 11600 }, { 7, 13200 }, { 8, 14800 },
+};
+
+/**@brief Starts in RADIO_PROFILE_DEFAULT with no events counted. */
+void RadioProfile_Init(void) {
+    memset(&radioProfile, 0, sizeof(radioProfile));
+    radioProfile.mProfile = RADIO_PROFILE_DEFAULT;
+}
+
+/**@brief Counts the next events for the profile, once Advertising_SetRadio has applied it. */
+void RadioProfile_Set(RADIO_PROFILE profile) {
+    if (profile >= RADIO_PROFILE_COUNT) {
+        printf("%s(%d) Unknown profile %d.\n", __func__, __LINE__, profile);
+        return;
+    }
+    if (profile != radioProfile.mProfile) {
+        radioProfile.mProfile = profile;
+        radioProfile.mChangeCount++;
+    }
+}
+
+RADIO_PROFILE RadioProfile_Get(void) {
+    return radioProfile.mProfile;
+}
+
+RADIO_PROFILE_CONFIG const *RadioProfile_GetConfig(RADIO_PROFILE profile) {
+    return &m_configs[(profile < RADIO_PROFILE_COUNT) ? profile : RADIO_PROFILE_STANDARD];
+}
+
+/**@brief Called on the radio notification of every advertising event. */
+void RadioProfile_OnAdvertisingEvent(void) {
+    radioProfile.mEventCount[radioProfile.mProfile]++;
+}
+
+void RadioProfile_GetStats(RADIO_PROFILE_STATS *pStats) {
+    pStats->mProfile = radioProfile.mProfile;
+    pStats->mChangeCount = radioProfile.mChangeCount;
+    memcpy(pStats->mEventCount, radioProfile.mEventCount, sizeof(pStats->mEventCount));
+}
+
+/**@brief Estimated charge of one advertising event in nC.
+ *
+ * @details RADIO_PROFILE_EVENT_OVERHEAD_NC for the crystal start-up and the SoftDevice processing, and the
+ *          transmission on every channel. The scan requests of scannable advertising are not included.
+ */
+uint32_t RadioProfile_GetEventChargeNc(RADIO_PROFILE profile) {
+    RADIO_PROFILE_CONFIG const *pConfig = RadioProfile_GetConfig(profile);
+    uint32_t channelCount = 0;
+    for (uint8_t channels = pConfig->mChannels & RADIO_PROFILE_CHANNELS_ALL; channels != 0; channels &= (uint8_t)(channels - 1)) {
+        channelCount++;
+    }
+    return RADIO_PROFILE_EVENT_OVERHEAD_NC + channelCount * RADIO_PROFILE_CHANNEL_US * RadioProfile_GetTxCurrentUa(pConfig->mTxPower) / 1000;
+}
+
+/**@brief Estimated charge in uAh of the advertising events counted in the profile so far. */
+uint32_t RadioProfile_EstimateMicroAh(RADIO_PROFILE profile) {
+    if (profile >= RADIO_PROFILE_COUNT) {
+        return 0;
+    }
+    uint64_t chargeNc = (uint64_t)radioProfile.mEventCount[profile] * RadioProfile_GetEventChargeNc(profile);
+    return (uint32_t)(chargeNc / 3600 / 1000);
+}
+
+/**@brief Estimated charge per day in uAh of advertising in the profile, to compare the profiles. The interval
+ *        is in 0.625 ms units.
+ *
+ * @details Only the advertising events are included, the sleep current is the same in every profile.
+ */
+uint32_t RadioProfile_EstimateMicroAhPerDay(RADIO_PROFILE profile, uint32_t interval) {
+    uint64_t eventsPerDay = (uint64_t)RADIO_PROFILE_SECONDS_PER_DAY * 1000000 / (interval * 625 + RADIO_PROFILE_ADV_DELAY_MEAN_MS * 1000);
+    return (uint32_t)(eventsPerDay * RadioProfile_GetEventChargeNc(profile) / 3600 / 1000);
+}
+
+/**@brief Current at the lowest listed power at or above txPower, the highest one above them all. */
+static uint32_t RadioProfile_GetTxCurrentUa(int8_t txPower) {
+    for (size_t i = 0; i < sizeof(m_tx_currents) / sizeof(m_tx_currents[0]); i++) {
+        if (m_tx_currents[i].mTxPower >= txPower) {
+            return m_tx_currents[i].mCurrentUa;
+        }
+    }
+    return m_tx_currents[sizeof(m_tx_currents) / sizeof(m_tx_currents[0]) - 1].mCurrentUa;
+}
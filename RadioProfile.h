@@ -0,0 +1,47 @@
+#pragma once
+
+#include "sdk_config.h"
+#include <stdint.h>
+
+/**@brief Primary advertising channels and transmit power, by deployment.
+ *
+ * @details Fewer channels and a lower power cost less charge per advertising event, more of them reach
+ *          gateways farther away. The profile in use is applied by the caller with Advertising_SetRadio, and
+ *          the charge of the advertising events is estimated for each profile from the events counted while
+ *          it was in use.
+ */
+
+typedef enum {
+    RADIO_PROFILE_DENSE,     /**< Gateways close by: RADIO_PROFILE_DENSE_CHANNELS at RADIO_PROFILE_DENSE_TX_POWER. */
+    RADIO_PROFILE_STANDARD,  /**< The three primary channels at 0 dBm, the SoftDevice defaults. */
+    RADIO_PROFILE_SPARSE,    /**< Gateways far apart: the three primary channels at RADIO_PROFILE_SPARSE_TX_POWER. */
+    RADIO_PROFILE_COUNT,
+} RADIO_PROFILE;
+
+/* Primary channels, in the channels of RADIO_PROFILE_CONFIG. */
+#define RADIO_PROFILE_CHANNEL_37    (1U << 0)
+#define RADIO_PROFILE_CHANNEL_38    (1U << 1)
+#define RADIO_PROFILE_CHANNEL_39    (1U << 2)
+#define RADIO_PROFILE_CHANNELS_ALL  (RADIO_PROFILE_CHANNEL_37 | RADIO_PROFILE_CHANNEL_38 | RADIO_PROFILE_CHANNEL_39)
+
+typedef struct {
+    char const *mpName;
+    uint8_t mChannels;        /**< Primary channels used, RADIO_PROFILE_CHANNEL_* bits. */
+    int8_t mTxPower;          /**< Transmit power in dBm, one the SoftDevice accepts. */
+} RADIO_PROFILE_CONFIG;
+
+typedef struct {
+    RADIO_PROFILE mProfile;                      /**< Profile in use. */
+    uint32_t mChangeCount;                       /**< Number of profile changes. */
+    uint32_t mEventCount[RADIO_PROFILE_COUNT];   /**< Number of advertising events in each profile. */
+} RADIO_PROFILE_STATS;
+
+void RadioProfile_Init(void);
+void RadioProfile_Set(RADIO_PROFILE profile);
+RADIO_PROFILE RadioProfile_Get(void);
+RADIO_PROFILE_CONFIG const *RadioProfile_GetConfig(RADIO_PROFILE profile);
+void RadioProfile_OnAdvertisingEvent(void);
+void RadioProfile_GetStats(RADIO_PROFILE_STATS *pStats);
+uint32_t RadioProfile_GetEventChargeNc(RADIO_PROFILE profile);
+uint32_t RadioProfile_EstimateMicroAh(RADIO_PROFILE profile);
+uint32_t RadioProfile_EstimateMicroAhPerDay(RADIO_PROFILE profile, uint32_t interval);
@@ -0,0 +1,243 @@
+#include "RadioSync.h"
+#include "TaskScheduler.h"
+#include "TimerManager.h"
+#include "app_error.h"
+#include "app_util_platform.h"
+#include "nrf_nvic.h"
+#include "nrf_soc.h"
+#include <stdio.h>
+#include <string.h>
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define RADIO_SYNC_TASK_PRIORITY        1       /**< With the sensor driver, a late start delays the readings. */
+#define RADIO_SYNC_IRQ_PRIORITY         APP_IRQ_PRIORITY_LOW
+#define RADIO_SYNC_DISTANCE             NRF_RADIO_NOTIFICATION_DISTANCE_800US
+#define RADIO_SYNC_DISTANCE_TICKS       TimerManager_UsToTicks(800)  /**< From the notification to the radio event. */
+#define RADIO_SYNC_ADV_DELAY_MAX_TICKS  APP_TIMER_TICKS(10)  /**< Random delay the link layer adds to every advertising event. */
+#define RADIO_SYNC_GUARD_TICKS          APP_TIMER_TICKS(RADIO_SYNC_GUARD_MS)
+#define RADIO_SYNC_MAX_DELAY_TICKS      APP_TIMER_TICKS(SAMPLE_INTERVAL_MS / 2)  /**< The history keeps its sampling grid. */
+
+/* Task events */
+#define RADIO_SYNC_EVT_RADIO            (1UL << 0)
+#define RADIO_SYNC_EVT_START            (1UL << 1)
+
+typedef struct
+{
+    RADIO_SYNC_CALLBACK *mpCallback;
+    RADIO_SYNC_CALLBACK *mpEventHandler;
+    TASK_ID mTaskId;
+    RADIO_SYNC_MODE mMode;
+    uint32_t mIntervalTicks;
+    volatile uint32_t mRadioTicks;  // Written by the radio notification interrupt before it posts the event.
+    bool mHasEvent;                 // mRadioTicks is an advertising event of the current interval.
+    bool mIsStartPending;
+    uint32_t mStartTicks;
+    uint32_t mMeasureTicks;         // Longest measurement, the lead taken on the predicted event.
+    bool mIsOnAirPending;           // Readings applied, not yet followed by a radio event.
+    uint32_t mAppliedTicks;
+    uint32_t mRadioEventCount;
+    uint32_t mAlignedCount;
+    uint32_t mDeadlineCount;
+    uint32_t mLatencyCount;
+    uint32_t mMaxLatencyTicks;
+    uint64_t mTotalLatencyTicks;
+} RadioSync;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static void RadioSync_Task(void *pContext, uint32_t events);
+static void RadioSync_OnRadioEvent(RadioSync *this);
+static bool RadioSync_GetStartDelay(RadioSync *this, uint32_t *pDelayTicks);
+static void RadioSync_Start(RadioSync *this);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static RadioSync radioSync;
+
+/**@brief Enables the radio notification ahead of every radio event. The interval is in 0.625 ms units.
+ *
+ * @details The SoftDevice only accepts the configuration while the radio is idle, so this runs before
+ *          advertising starts.
+ */
+void RadioSync_Init(RADIO_SYNC_CALLBACK *pCallback, uint32_t interval) {
+    memset(&radioSync, 0, sizeof(radioSync));
+    radioSync.mpCallback = pCallback;
+    radioSync.mMode = RADIO_SYNC_MODE_ALIGNED;
+    radioSync.mMeasureTicks = APP_TIMER_TICKS(RADIO_SYNC_MEASURE_MS);
+    radioSync.mTaskId = TaskScheduler_Create(RadioSync_Task, &radioSync, RADIO_SYNC_TASK_PRIORITY);
+    RadioSync_SetInterval(interval);
+
+    ret_code_t err_code = sd_nvic_ClearPendingIRQ(RADIO_NOTIFICATION_IRQn);
+    APP_ERROR_CHECK(err_code);
+    err_code = sd_nvic_SetPriority(RADIO_NOTIFICATION_IRQn, RADIO_SYNC_IRQ_PRIORITY);
+    APP_ERROR_CHECK(err_code);
+    err_code = sd_nvic_EnableIRQ(RADIO_NOTIFICATION_IRQn);
+    APP_ERROR_CHECK(err_code);
+    err_code = sd_radio_notification_cfg_set(NRF_RADIO_NOTIFICATION_TYPE_INT_ON_ACTIVE, RADIO_SYNC_DISTANCE);
+    APP_ERROR_CHECK(err_code);
+}
+
+/**@brief Sets the advertising interval, in 0.625 ms units. The events before the change do not predict the next ones. */
+void RadioSync_SetInterval(uint32_t interval) {
+    radioSync.mIntervalTicks = TimerManager_UsToTicks((uint64_t)interval * 625);
+    radioSync.mHasEvent = false;
+}
+
+/**@brief Sets the mode. The events before the change do not predict the next ones. */
+void RadioSync_SetMode(RADIO_SYNC_MODE mode) {
+    radioSync.mMode = mode;
+    radioSync.mHasEvent = false;
+    radioSync.mIsOnAirPending = false;
+}
+
+/**@brief Sets the handler run on every advertising event, NULL for none.
+ *
+ * @details It runs after the notification, so the advertising data it hands over goes out from the next event.
+ */
+void RadioSync_SetEventHandler(RADIO_SYNC_CALLBACK *pHandler) {
+    radioSync.mpEventHandler = pHandler;
+}
+
+/**@brief Called at the sampling deadline. Starts the measurement now, or at the time that makes it complete
+ *        just ahead of the next advertising event it can make.
+ */
+void RadioSync_RequestSample(void) {
+    RadioSync *this = &radioSync;
+    if (this->mIsStartPending) {
+        printf("%s(%d) Measurement already scheduled.\n", __func__, __LINE__);
+        return;
+    }
+
+    uint32_t delayTicks;
+    if (this->mMode != RADIO_SYNC_MODE_ALIGNED || !RadioSync_GetStartDelay(this, &delayTicks)) {
+        this->mDeadlineCount++;
+        RadioSync_Start(this);
+        return;
+    }
+
+    this->mAlignedCount++;
+    this->mIsStartPending = true;
+    TaskScheduler_PostAfter(this->mTaskId, RADIO_SYNC_EVT_START, delayTicks);
+}
+
+/**@brief Called with the readings of the measurement, isApplied if they went into the advertising data. */
+void RadioSync_OnSampleDone(bool isApplied) {
+    RadioSync *this = &radioSync;
+    uint32_t measureTicks = TimerManager_GetTicksSince(this->mStartTicks);
+    if (measureTicks > this->mMeasureTicks) {
+        this->mMeasureTicks = measureTicks;
+    }
+
+    if (isApplied && this->mMode != RADIO_SYNC_MODE_OFF) {
+        this->mIsOnAirPending = true;
+        this->mAppliedTicks = TimerManager_GetTicks();
+    }
+}
+
+void RadioSync_GetStats(RADIO_SYNC_STATS *pStats) {
+    pStats->mRadioEventCount = radioSync.mRadioEventCount;
+    pStats->mAlignedCount = radioSync.mAlignedCount;
+    pStats->mDeadlineCount = radioSync.mDeadlineCount;
+    pStats->mMeasureUs = TimerManager_TicksToUs(radioSync.mMeasureTicks);
+    pStats->mLatencyCount = radioSync.mLatencyCount;
+    pStats->mMaxLatencyUs = TimerManager_TicksToUs(radioSync.mMaxLatencyTicks);
+    pStats->mMeanLatencyUs = (radioSync.mLatencyCount > 0) ? TimerManager_TicksToUs(radioSync.mTotalLatencyTicks / radioSync.mLatencyCount) : 0;
+}
+
+#if RADIO_SYNC_ENABLED
+/**@brief Radio notification interrupt, RADIO_SYNC_DISTANCE before every radio event. Only timestamps it. */
+void RADIO_NOTIFICATION_IRQHandler(void) {
+    radioSync.mRadioTicks = TimerManager_GetTicks();
+    TaskScheduler_Post(radioSync.mTaskId, RADIO_SYNC_EVT_RADIO);
+}
+#endif
+
+static void RadioSync_Task(void *pContext, uint32_t events) {
+    RadioSync *this = (RadioSync*)pContext;
+
+    if (events & RADIO_SYNC_EVT_RADIO) {
+        RadioSync_OnRadioEvent(this);
+    }
+    if (events & RADIO_SYNC_EVT_START) {
+        this->mIsStartPending = false;
+        RadioSync_Start(this);
+    }
+}
+
+/**@brief Keeps the event as the reference for the next predictions, and ends the latency of the readings
+ *        applied before it.
+ *
+ * @details Readings applied between the notification and the event are left for the next one, the
+ *          SoftDevice may have prepared the packet already.
+ */
+static void RadioSync_OnRadioEvent(RadioSync *this) {
+    uint32_t radioTicks = this->mRadioTicks;
+    this->mRadioEventCount++;
+    if (this->mMode == RADIO_SYNC_MODE_OFF) {
+        // Connection events, they do not carry the advertising data.
+        return;
+    }
+    this->mHasEvent = true;
+    if (this->mpEventHandler != NULL) {
+        this->mpEventHandler();
+    }
+
+    if (!this->mIsOnAirPending) {
+        return;
+    }
+    uint32_t sinceRadio = TimerManager_GetTicksSince(radioTicks);
+    uint32_t sinceApplied = TimerManager_GetTicksSince(this->mAppliedTicks);
+    if (sinceApplied < sinceRadio) {
+        return;
+    }
+
+    uint32_t latencyTicks = sinceApplied - sinceRadio + RADIO_SYNC_DISTANCE_TICKS;
+    this->mIsOnAirPending = false;
+    this->mLatencyCount++;
+    this->mTotalLatencyTicks += latencyTicks;
+    if (latencyTicks > this->mMaxLatencyTicks) {
+        this->mMaxLatencyTicks = latencyTicks;
+    }
+}
+
+/**@brief Computes when to start the measurement so that it completes RADIO_SYNC_GUARD_MS before an event.
+ *
+ * @details The events are predicted from the last one at multiples of the interval, without the random
+ *          delay of each event, so the prediction is the earliest the event can start.
+ *
+ * @retval true  The measurement is to start after *pDelayTicks.
+ * @retval false There is no recent event to predict from, or the event is too far from the deadline.
+ */
+static bool RadioSync_GetStartDelay(RadioSync *this, uint32_t *pDelayTicks) {
+    if (!this->mHasEvent || this->mIntervalTicks == 0) {
+        return false;
+    }
+
+    uint32_t sinceRadio = TimerManager_GetTicksSince(this->mRadioTicks);
+    if (sinceRadio > this->mIntervalTicks + RADIO_SYNC_ADV_DELAY_MAX_TICKS + RADIO_SYNC_GUARD_TICKS) {
+        // Advertising stopped or restarted since, the next events are not on the same grid.
+        return false;
+    }
+
+    uint32_t leadTicks = this->mMeasureTicks + RADIO_SYNC_GUARD_TICKS;
+    uint32_t eventTicks = RADIO_SYNC_DISTANCE_TICKS;  // Since the notification.
+    while (eventTicks < sinceRadio + leadTicks) {
+        eventTicks += this->mIntervalTicks;
+    }
+
+    uint32_t delayTicks = eventTicks - leadTicks - sinceRadio;
+    if (delayTicks > RADIO_SYNC_MAX_DELAY_TICKS) {
+        return false;
+    }
+    *pDelayTicks = delayTicks;
+    return true;
+}
+
+static void RadioSync_Start(RadioSync *this) {
+    this->mStartTicks = TimerManager_GetTicks();
+    this->mpCallback();
+}
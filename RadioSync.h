@@ -0,0 +1,45 @@
+#pragma once
+
+#include "sdk_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**@brief Starts the measurements so that they complete just ahead of an advertising event.
+ *
+ * @details The SoftDevice radio notification signals every radio event shortly before it starts. The last one
+ *          and the advertising interval predict the following events, and a sample requested at its deadline
+ *          is measured so that its readings are applied RADIO_SYNC_GUARD_MS before the first predicted event
+ *          it can still make. The delay after the deadline is kept below half the sampling interval, and a
+ *          sample is measured at its deadline when there is no recent event to predict from.
+ *
+ *          The sample-to-air latency is measured in every mode, from the readings being applied to the first
+ *          radio event after them.
+ */
+
+typedef enum {
+    RADIO_SYNC_MODE_ALIGNED,   /**< Measurements are timed from the advertising events. */
+    RADIO_SYNC_MODE_DEADLINE,  /**< Measurements start at the deadline, for comparison. */
+    RADIO_SYNC_MODE_OFF,       /**< Not advertising, measurements start at the deadline and the latency is not measured. */
+} RADIO_SYNC_MODE;
+
+/**@brief Starts a measurement, or handles an advertising event. Called from the RadioSync task or from
+ *        RadioSync_RequestSample. */
+typedef void(RADIO_SYNC_CALLBACK)(void);
+
+typedef struct {
+    uint32_t mRadioEventCount;   /**< Number of radio events notified. */
+    uint32_t mAlignedCount;      /**< Number of measurements timed from an advertising event. */
+    uint32_t mDeadlineCount;     /**< Number of measurements started at their deadline. */
+    uint32_t mMeasureUs;         /**< Longest time from the start of a measurement to its readings. */
+    uint32_t mLatencyCount;      /**< Number of readings seen on air. */
+    uint32_t mMaxLatencyUs;      /**< Longest time from readings applied to the first radio event after them. */
+    uint32_t mMeanLatencyUs;     /**< Mean time from readings applied to the first radio event after them. */
+} RADIO_SYNC_STATS;
+
+void RadioSync_Init(RADIO_SYNC_CALLBACK *pCallback, uint32_t interval);
+void RadioSync_SetInterval(uint32_t interval);
+void RadioSync_SetMode(RADIO_SYNC_MODE mode);
+void RadioSync_SetEventHandler(RADIO_SYNC_CALLBACK *pHandler);
+void RadioSync_RequestSample(void);
+void RadioSync_OnSampleDone(bool isApplied);
+void RadioSync_GetStats(RADIO_SYNC_STATS *pStats);
@@ -3,6 +3,9 @@
 #include "TWI.h"
 #include <string.h>
 #include "TimerManager.h"
+#include "TaskScheduler.h"
+#include "Coroutine.h"
+#include "CycleCounter.h"
 
 /*============================================================================*/
 // define
@@ -12,35 +15,58 @@
 
 #define TIMER_WAITING_TIME_AFTER_SOFT_RESET_MS APP_TIMER_TICKS(2)
 #define TIMER_WAITING_TIME_AFTER_MEASUREMENT_START_MS APP_TIMER_TICKS(16)
+#define SHT31_TASK_PRIORITY 1
+
+/* Task events */
+#define SHT31_EVT_MEASURE_REQUEST (1UL << 0)
+#define SHT31_EVT_TWI_DONE        (1UL << 1)
+#define SHT31_EVT_TWI_ERROR       (1UL << 2)
+#define SHT31_EVT_WAIT_ELAPSED    (1UL << 3)
+#define SHT31_EVT_INIT            (1UL << 4)
+
+/* Awaits the end of the current TWI transfer and leaves the sequence if it failed. */
+#define SHT31_AWAIT_TWI(pCo, events)                                                            \
+    do {                                                                                        \
+        COROUTINE_AWAIT_EVENT(pCo, events, SHT31_EVT_TWI_DONE | SHT31_EVT_TWI_ERROR);           \
+        if ((events) & SHT31_EVT_TWI_ERROR) {                                                   \
+            printf("%s(%d) TWI transfer failed\n", __func__, __LINE__);                         \
+            COROUTINE_EXIT(pCo);                                                                \
+        }                                                                                       \
+    } while (0)
+
+#define SHT31_AWAIT_TICKS(pCo, this, events, timeoutTicks) \
+    COROUTINE_AWAIT_TICKS(pCo, events, (this)->mTaskId, SHT31_EVT_WAIT_ELAPSED, timeoutTicks)
 
 typedef enum {
-    SHT31_CMD_NONE = 0,
     SHT31_CMD_SOFT_RESET = 0x30A2,
     SHT31_CMD_CLEAR_STATUS = 0x3041,
     SHT31_CMD_HEATER_ON = 0x306D,
     SHT31_CMD_HEATER_OFF = 0x3066,
     SHT31_CMD_MEASURE_START = 0x2400,
-    SHT31_CMD_MEASURE_RESULT_GET = 0xFFFF,
 } SHT31_COMMAND;
 
 typedef struct {
-    SHT31_COMMAND mCurrentCommand;
+    COROUTINE mInitCo;
+    COROUTINE mMeasureCo;
     bool mIsMeasuring;
-    bool mWaitFlag;
     bool mInitCompete;
+    uint8_t mTxData[2];
     uint8_t mRxData[6];
-    app_timer_id_t *mpTimerId;
     SHT31_CALLBACK *mpCallback;
+    SHT31_CALLBACK *mpRequestCallback;
+    TASK_ID mTaskId;
+    uint32_t mMaxIsrCycles;
 } SHT31;
 
 /*============================================================================*/
 // Local function
 /*============================================================================*/
-static bool SHT31_SendCmd(SHT31 *this, SHT31_COMMAND cmd);
-static void SHT31_InitSequence(SHT31 *this);
-static void SHT31_ResponseProcess(SHT31 *this);
+static void SHT31_SendCmd(SHT31 *this, SHT31_COMMAND cmd);
+static COROUTINE_STATE SHT31_InitSequence(SHT31 *this, uint32_t events);
+static COROUTINE_STATE SHT31_MeasureSequence(SHT31 *this, uint32_t events);
+static void SHT31_ReportResult(SHT31 *this);
 static void SHT31_TwiEvtHandler(nrf_drv_twi_evt_t const *p_event, void *p_context);
-static void SHT31_TimerCallback(void *pContext);
+static void SHT31_Task(void *pContext, uint32_t events);
 
 /*============================================================================*/
 // Local variable
@@ -49,143 +75,119 @@ static SHT31 sht31;
 
 void SHT31_Init(void) {
     memset(&sht31, 0, sizeof(sht31));
-    sht31.mpTimerId = &TIMER_ID_SHT31;
-    TimerManager_Register(sht31.mpTimerId, SHT31_TimerCallback, APP_TIMER_MODE_SINGLE_SHOT);
+    sht31.mTaskId = TaskScheduler_Create(SHT31_Task, &sht31, SHT31_TASK_PRIORITY);
     TWI_Init(SHT31_TwiEvtHandler, (void*)&sht31);
-    SHT31_InitSequence(&sht31);
+    TaskScheduler_Post(sht31.mTaskId, SHT31_EVT_INIT);
 }
 
+/**@brief Requests a measurement. The callback runs from the SHT31 task once the result is read. */
 void SHT31_GetValue(SHT31_CALLBACK *pCallback){
-    if (!sht31.mInitCompete) {
-        printf("%s(%d) initialization not yet completed.\n", __func__, __LINE__);
-        return;
-    }
-
-    if (sht31.mIsMeasuring) {
-        printf("%s(%d) Measurement already in progress.\n", __func__, __LINE__);
-        return;
-    }
-
-    sht31.mIsMeasuring = true;
-    sht31.mpCallback = pCallback;
-    SHT31_SendCmd(&sht31, SHT31_CMD_MEASURE_START);
+    sht31.mpRequestCallback = pCallback;
+    TaskScheduler_Post(sht31.mTaskId, SHT31_EVT_MEASURE_REQUEST);
 }
 
-static bool SHT31_SendCmd(SHT31 *this, SHT31_COMMAND cmd) {
-
-    if (this->mCurrentCommand != SHT31_CMD_NONE) {
-        printf("%s(%d) Command already in progress.\n", __func__, __LINE__);
-        return false;
-    }
-
-    this->mCurrentCommand = cmd;
-
-    uint8_t command[2] = { (uint8_t)(cmd >> 8) , (uint8_t)(cmd & 0xFF) };
-    if (cmd == SHT31_CMD_MEASURE_RESULT_GET) {
-        TWI_Rx(SHT31_TWI_ADDRESS, this->mRxData, sizeof(this->mRxData));
-        return;
-    }
+uint32_t SHT31_GetMaxIsrCycles(void) {
+    return sht31.mMaxIsrCycles;
+}
 
-    TWI_Tx(SHT31_TWI_ADDRESS, command, sizeof(command), false);
+static void SHT31_SendCmd(SHT31 *this, SHT31_COMMAND cmd) {
+    // The transfer runs from EasyDMA after this returns, so the buffer must outlive the call.
+    this->mTxData[0] = (uint8_t)(cmd >> 8);
+    this->mTxData[1] = (uint8_t)(cmd & 0xFF);
+    TWI_Tx(SHT31_TWI_ADDRESS, this->mTxData, sizeof(this->mTxData), false);
 }
 
-static void SHT31_InitSequence(SHT31 *this) {
+static COROUTINE_STATE SHT31_InitSequence(SHT31 *this, uint32_t events) {
+    COROUTINE_BEGIN(&this->mInitCo);
 
-    printf("%s(%d) %04x\n", __func__, __LINE__, this->mCurrentCommand);
+    SHT31_SendCmd(this, SHT31_CMD_SOFT_RESET);
+    SHT31_AWAIT_TWI(&this->mInitCo, events);
+    SHT31_AWAIT_TICKS(&this->mInitCo, this, events, TIMER_WAITING_TIME_AFTER_SOFT_RESET_MS);
 
-    switch (this->mCurrentCommand)
-    {
-    case SHT31_CMD_NONE:
-        this->mCurrentCommand = SHT31_CMD_NONE;
-        SHT31_SendCmd(this, SHT31_CMD_SOFT_RESET);
-        break;
-    
-    case SHT31_CMD_SOFT_RESET:
-        if (!this->mWaitFlag) {
-            TimerManager_Start(this->mpTimerId, TIMER_WAITING_TIME_AFTER_SOFT_RESET_MS, this);
-        } else {
-            this->mWaitFlag = false;
-            this->mCurrentCommand = SHT31_CMD_NONE;
-            SHT31_SendCmd(this, SHT31_CMD_CLEAR_STATUS);
-        }
-        break;
-    
-    case SHT31_CMD_CLEAR_STATUS:
-        this->mCurrentCommand = SHT31_CMD_NONE;
-        SHT31_SendCmd(this, SHT31_HEATER ? SHT31_CMD_HEATER_OFF : SHT31_CMD_HEATER_ON);
-        break;
+    SHT31_SendCmd(this, SHT31_CMD_CLEAR_STATUS);
+    SHT31_AWAIT_TWI(&this->mInitCo, events);
 
-    case SHT31_CMD_HEATER_OFF:
-    case SHT31_CMD_HEATER_ON:
-        this->mCurrentCommand = SHT31_CMD_NONE;
-        this->mInitCompete = true;
-        break;
+    SHT31_SendCmd(this, SHT31_HEATER ? SHT31_CMD_HEATER_ON : SHT31_CMD_HEATER_OFF);
+    SHT31_AWAIT_TWI(&this->mInitCo, events);
 
-    default:
-        printf("%s(%d) Invalid command\n", __func__, __LINE__);
-        break;
-    }
+    this->mInitCompete = true;
+    printf("%s(%d) initialization completed.\n", __func__, __LINE__);
 
+    COROUTINE_END(&this->mInitCo);
 }
-static void SHT31_ResponseProcess(SHT31 *this) {
 
-    printf("%s(%d) %04x\n", __func__, __LINE__, this->mCurrentCommand);
+static COROUTINE_STATE SHT31_MeasureSequence(SHT31 *this, uint32_t events) {
+    COROUTINE_BEGIN(&this->mMeasureCo);
 
-    if (!this->mInitCompete) {
-        SHT31_InitSequence(this);
-    }
+    SHT31_SendCmd(this, SHT31_CMD_MEASURE_START);
+    SHT31_AWAIT_TWI(&this->mMeasureCo, events);
+    SHT31_AWAIT_TICKS(&this->mMeasureCo, this, events, TIMER_WAITING_TIME_AFTER_MEASUREMENT_START_MS);
 
-    switch (this->mCurrentCommand)
-    {
+    TWI_Rx(SHT31_TWI_ADDRESS, this->mRxData, sizeof(this->mRxData));
+    SHT31_AWAIT_TWI(&this->mMeasureCo, events);
 
-    case SHT31_CMD_MEASURE_START:
-        if (!this->mWaitFlag) {
-            TimerManager_Start(this->mpTimerId, TIMER_WAITING_TIME_AFTER_MEASUREMENT_START_MS, this);
-        } else {
-            this->mWaitFlag = false;
-            this->mCurrentCommand = SHT31_CMD_NONE;
-            SHT31_SendCmd(this, SHT31_CMD_MEASURE_RESULT_GET);
-        }
-        break;
+    SHT31_ReportResult(this);
 
-    case SHT31_CMD_MEASURE_RESULT_GET: {
-        uint16_t rawTemperature = (this->mRxData[0] << 8) | this->mRxData[1];
-        uint16_t rawHumidity = (this->mRxData[3] << 8) | this->mRxData[4];
+    COROUTINE_END(&this->mMeasureCo);
+}
 
-        int16_t temperature = (-45.0f + (175.0f * ((float)rawTemperature / 65534.0f))) * 100;
-        int16_t humidity = (100.0f * ((float)rawHumidity / 65534.0f)) * 100;
-        printf("%s(%d): Temperature: %d, Humidity: %d\n", __func__, __LINE__, temperature, humidity);
-        if(sht31.mpCallback) sht31.mpCallback(temperature, humidity);
-        this->mIsMeasuring = false;
-        this->mCurrentCommand = SHT31_CMD_NONE;
-    }
-        break;
+static void SHT31_ReportResult(SHT31 *this) {
+    uint16_t rawTemperature = (this->mRxData[0] << 8) | this->mRxData[1];
+    uint16_t rawHumidity = (this->mRxData[3] << 8) | this->mRxData[4];
 
-    default:
-        printf("%s(%d) Invalid command %d" , __func__, __LINE__, this->mCurrentCommand);
-        break;
-    }
+    int16_t temperature = (-45.0f + (175.0f * ((float)rawTemperature / 65534.0f))) * 100;
+    int16_t humidity = (100.0f * ((float)rawHumidity / 65534.0f)) * 100;
+    printf("%s(%d): Temperature: %d, Humidity: %d\n", __func__, __LINE__, temperature, humidity);
+    if(this->mpCallback) this->mpCallback(temperature, humidity);
 }
 
-void SHT31_TwiEvtHandler(nrf_drv_twi_evt_t const *p_event, void *p_context) {
+/**@brief TWI interrupt handler. Only posts the event, the response is processed by the SHT31 task. */
+static void SHT31_TwiEvtHandler(nrf_drv_twi_evt_t const *p_event, void *p_context) {
 
+    uint32_t startCycles = CycleCounter_Get();
     SHT31 *this = (SHT31*)p_context;
 
     switch (p_event->type)
     {
     case NRF_DRV_TWI_EVT_DONE :
-        SHT31_ResponseProcess(this);
+        TaskScheduler_Post(this->mTaskId, SHT31_EVT_TWI_DONE);
         break;
 
     default:
-        printf("%s(%d) Invalid type %d" , __func__, __LINE__, p_event->type);
+        TaskScheduler_Post(this->mTaskId, SHT31_EVT_TWI_ERROR);
         break;
     }
 
+    uint32_t cycles = CycleCounter_Get() - startCycles;
+    if (cycles > this->mMaxIsrCycles) {
+        this->mMaxIsrCycles = cycles;
+    }
 }
 
-static void SHT31_TimerCallback(void *pContext) {
+static void SHT31_Task(void *pContext, uint32_t events) {
     SHT31 *this = (SHT31*)pContext;
-    this->mWaitFlag = true;
-    SHT31_ResponseProcess(this);
+
+    if (!this->mInitCompete) {
+        if ((events & SHT31_EVT_MEASURE_REQUEST)) {
+            printf("%s(%d) initialization not yet completed.\n", __func__, __LINE__);
+        }
+        if (SHT31_InitSequence(this, events) == COROUTINE_DONE && !this->mInitCompete) {
+            printf("%s(%d) initialization failed.\n", __func__, __LINE__);
+        }
+        return;
+    }
+
+    if (events & SHT31_EVT_MEASURE_REQUEST) {
+        if (this->mIsMeasuring) {
+            printf("%s(%d) Measurement already in progress.\n", __func__, __LINE__);
+        } else {
+            this->mIsMeasuring = true;
+            this->mpCallback = this->mpRequestCallback;
+            COROUTINE_INIT(&this->mMeasureCo);
+        }
+    }
+
+    if (this->mIsMeasuring && SHT31_MeasureSequence(this, events) == COROUTINE_DONE) {
+        this->mIsMeasuring = false;
+    }
 }
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    int16_t mTemperature;  /**< Temperature in 0.01 degC. */
+    int16_t mHumidity;     /**< Humidity in 0.01 %RH. */
+} SAMPLE;
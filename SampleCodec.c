@@ -0,0 +1,162 @@
+#include "SampleCodec.h"
+#include <stdbool.h>
+#include <string.h>
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define SAMPLE_CODEC_GROUP_BITS 3
+#define SAMPLE_CODEC_GROUP_MASK ((1U << SAMPLE_CODEC_GROUP_BITS) - 1)
+#define SAMPLE_CODEC_CONTINUE   (1U << SAMPLE_CODEC_GROUP_BITS)
+#define SAMPLE_CODEC_MAX_COUNT  UINT8_MAX
+
+typedef struct
+{
+    uint8_t *mpBuffer;
+    uint32_t mNibbleCount;
+    uint32_t mNibbleLimit;
+} SampleCodecWriter;
+
+typedef struct
+{
+    uint8_t const *mpBuffer;
+    uint32_t mNibbleCount;
+    uint32_t mNibbleLimit;
+} SampleCodecReader;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static uint32_t SampleCodec_ZigZag(int32_t value);
+static int32_t SampleCodec_UnZigZag(uint32_t value);
+static uint32_t SampleCodec_VarintNibbles(uint32_t value);
+static void SampleCodec_WriteVarint(SampleCodecWriter *this, uint32_t value);
+static bool SampleCodec_ReadVarint(SampleCodecReader *this, uint32_t *pValue);
+
+/**@brief Encodes as many of the samples as fit the buffer.
+ *
+ * @param[in]  pSamples  Samples, newest first.
+ * @param[in]  count     Number of samples.
+ * @param[out] pBuffer   Encoded data. Unused bytes at the end are set to 0.
+ * @param[in]  size      Size of pBuffer in bytes.
+ *
+ * @return Number of samples encoded.
+ */
+uint32_t SampleCodec_Encode(SAMPLE const *pSamples, uint32_t count, uint8_t *pBuffer, uint16_t size) {
+    if (size < SAMPLE_CODEC_HEADER_SIZE) {
+        return 0;
+    }
+    memset(pBuffer, 0, size);
+    if (count == 0) {
+        return 0;
+    }
+    if (count > SAMPLE_CODEC_MAX_COUNT) {
+        count = SAMPLE_CODEC_MAX_COUNT;
+    }
+
+    pBuffer[1] = (uint8_t)((uint16_t)pSamples[0].mTemperature >> 8);
+    pBuffer[2] = (uint8_t)((uint16_t)pSamples[0].mTemperature & 0xFF);
+    pBuffer[3] = (uint8_t)((uint16_t)pSamples[0].mHumidity >> 8);
+    pBuffer[4] = (uint8_t)((uint16_t)pSamples[0].mHumidity & 0xFF);
+
+    SampleCodecWriter writer = { &pBuffer[SAMPLE_CODEC_HEADER_SIZE], 0, (uint32_t)(size - SAMPLE_CODEC_HEADER_SIZE) * 2 };
+    uint32_t encoded = 1;
+    while (encoded < count) {
+        uint32_t temperature = SampleCodec_ZigZag((int32_t)pSamples[encoded].mTemperature - pSamples[encoded - 1].mTemperature);
+        uint32_t humidity = SampleCodec_ZigZag((int32_t)pSamples[encoded].mHumidity - pSamples[encoded - 1].mHumidity);
+        uint32_t nibbles = SampleCodec_VarintNibbles(temperature) + SampleCodec_VarintNibbles(humidity);
+        if (writer.mNibbleCount + nibbles > writer.mNibbleLimit) {
+            break;
+        }
+        SampleCodec_WriteVarint(&writer, temperature);
+        SampleCodec_WriteVarint(&writer, humidity);
+        encoded++;
+    }
+
+    pBuffer[0] = (uint8_t)encoded;
+    return encoded;
+}
+
+/**@brief Decodes samples, newest first.
+ *
+ * @return Number of samples decoded. 0 if the data is malformed or maxCount is smaller than the sample count.
+ */
+uint32_t SampleCodec_Decode(uint8_t const *pBuffer, uint16_t length, SAMPLE *pSamples, uint32_t maxCount) {
+    if (length < SAMPLE_CODEC_HEADER_SIZE || pBuffer[0] == 0 || pBuffer[0] > maxCount) {
+        return 0;
+    }
+
+    uint32_t count = pBuffer[0];
+    pSamples[0].mTemperature = (int16_t)((pBuffer[1] << 8) | pBuffer[2]);
+    pSamples[0].mHumidity = (int16_t)((pBuffer[3] << 8) | pBuffer[4]);
+
+    SampleCodecReader reader = { &pBuffer[SAMPLE_CODEC_HEADER_SIZE], 0, (uint32_t)(length - SAMPLE_CODEC_HEADER_SIZE) * 2 };
+    for (uint32_t i = 1; i < count; i++) {
+        uint32_t temperature;
+        uint32_t humidity;
+        if (!SampleCodec_ReadVarint(&reader, &temperature) || !SampleCodec_ReadVarint(&reader, &humidity)) {
+            return 0;
+        }
+        int32_t nextTemperature = pSamples[i - 1].mTemperature + SampleCodec_UnZigZag(temperature);
+        int32_t nextHumidity = pSamples[i - 1].mHumidity + SampleCodec_UnZigZag(humidity);
+        if (nextTemperature < INT16_MIN || nextTemperature > INT16_MAX || nextHumidity < INT16_MIN || nextHumidity > INT16_MAX) {
+            return 0;
+        }
+        pSamples[i].mTemperature = (int16_t)nextTemperature;
+        pSamples[i].mHumidity = (int16_t)nextHumidity;
+    }
+    return count;
+}
+
+static uint32_t SampleCodec_ZigZag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t SampleCodec_UnZigZag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static uint32_t SampleCodec_VarintNibbles(uint32_t value) {
+    uint32_t nibbles = 1;
+    while (value > SAMPLE_CODEC_GROUP_MASK) {
+        value >>= SAMPLE_CODEC_GROUP_BITS;
+        nibbles++;
+    }
+    return nibbles;
+}
+
+static void SampleCodec_WriteVarint(SampleCodecWriter *this, uint32_t value) {
+    do {
+        uint8_t nibble = (uint8_t)(value & SAMPLE_CODEC_GROUP_MASK);
+        value >>= SAMPLE_CODEC_GROUP_BITS;
+        if (value != 0) {
+            nibble |= SAMPLE_CODEC_CONTINUE;
+        }
+        uint8_t *pByte = &this->mpBuffer[this->mNibbleCount / 2];
+        *pByte |= (this->mNibbleCount & 1) ? nibble : (uint8_t)(nibble << 4);
+        this->mNibbleCount++;
+    } while (value != 0);
+}
+
+static bool SampleCodec_ReadVarint(SampleCodecReader *this, uint32_t *pValue) {
+    uint32_t value = 0;
+    uint32_t shift = 0;
+
+    // A 17-bit zigzag difference takes at most 6 groups.
+    for (uint32_t group = 0; group < 6; group++) {
+        if (this->mNibbleCount >= this->mNibbleLimit) {
+            return false;
+        }
+        uint8_t byte = this->mpBuffer[this->mNibbleCount / 2];
+        uint8_t nibble = (this->mNibbleCount & 1) ? (byte & 0x0F) : (byte >> 4);
+        this->mNibbleCount++;
+
+        value |= (uint32_t)(nibble & SAMPLE_CODEC_GROUP_MASK) << shift;
+        shift += SAMPLE_CODEC_GROUP_BITS;
+        if ((nibble & SAMPLE_CODEC_CONTINUE) == 0) {
+            *pValue = value;
+            return true;
+        }
+    }
+    return false;
+}
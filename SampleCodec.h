@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Sample.h"
+#include <stdint.h>
+
+/**@brief Compact encoding of a sample series, newest sample first.
+ *
+ * @details Layout: sample count, the newest sample in full (temperature then humidity, big-endian), then for
+ *          every older sample the difference of each field from the sample before it. A difference is
+ *          zigzag-mapped, so small negative and positive steps both give small numbers, and written as a
+ *          varint of 4-bit groups, high nibble first: 3 value bits, least significant group first, with the
+ *          top bit set when another group follows. A steady reading costs one byte per sample.
+ *
+ *          The module is plain C with no SDK dependency, so that gateways can use the same decoder.
+ */
+
+#define SAMPLE_CODEC_HEADER_SIZE 5  /**< Sample count and the newest sample in full. */
+
+uint32_t SampleCodec_Encode(SAMPLE const *pSamples, uint32_t count, uint8_t *pBuffer, uint16_t size);
+uint32_t SampleCodec_Decode(uint8_t const *pBuffer, uint16_t length, SAMPLE *pSamples, uint32_t maxCount);
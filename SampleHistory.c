@@ -0,0 +1,57 @@
+#include "SampleHistory.h"
+#include "app_util.h"
+#include <string.h>
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define SAMPLE_HISTORY_MASK (SAMPLE_HISTORY_SIZE - 1)
+
+STATIC_ASSERT((SAMPLE_HISTORY_SIZE & SAMPLE_HISTORY_MASK) == 0);  // Indexes wrap with a mask.
+
+typedef struct
+{
+    SAMPLE mSamples[SAMPLE_HISTORY_SIZE];
+    uint32_t mTotal;  // Number of samples ever added, the next one goes to mTotal & SAMPLE_HISTORY_MASK.
+} SampleHistory;
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static SampleHistory sampleHistory;
+
+void SampleHistory_Init(void) {
+    memset(&sampleHistory, 0, sizeof(sampleHistory));
+}
+
+/**@brief Adds a sample, overwriting the oldest one once the buffer is full. */
+void SampleHistory_Add(int16_t temperature, int16_t humidity) {
+    SAMPLE *pSample = &sampleHistory.mSamples[sampleHistory.mTotal & SAMPLE_HISTORY_MASK];
+    pSample->mTemperature = temperature;
+    pSample->mHumidity = humidity;
+    sampleHistory.mTotal++;
+}
+
+/**@brief Number of samples held, at most SAMPLE_HISTORY_SIZE. */
+uint32_t SampleHistory_GetCount(void) {
+    return (sampleHistory.mTotal < SAMPLE_HISTORY_SIZE) ? sampleHistory.mTotal : SAMPLE_HISTORY_SIZE;
+}
+
+/**@brief Number of samples added since SampleHistory_Init. The newest sample has index total - 1. */
+uint32_t SampleHistory_GetTotal(void) {
+    return sampleHistory.mTotal;
+}
+
+/**@brief Reads a sample by age, 0 being the newest.
+ *
+ * @retval true  The sample is held.
+ * @retval false The sample is older than the buffer or was never taken.
+ */
+bool SampleHistory_Get(uint32_t age, SAMPLE *pSample) {
+    if (age >= SampleHistory_GetCount()) {
+        return false;
+    }
+
+    *pSample = sampleHistory.mSamples[(sampleHistory.mTotal - 1 - age) & SAMPLE_HISTORY_MASK];
+    return true;
+}
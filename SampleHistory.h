@@ -0,0 +1,12 @@
+#pragma once
+
+#include "sdk_config.h"
+#include "Sample.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+void SampleHistory_Init(void);
+void SampleHistory_Add(int16_t temperature, int16_t humidity);
+uint32_t SampleHistory_GetCount(void);
+uint32_t SampleHistory_GetTotal(void);
+bool SampleHistory_Get(uint32_t age, SAMPLE *pSample);
@@ -0,0 +1,171 @@
+#include "TaskScheduler.h"
+#include "TimerWheel.h"
+#include "CycleCounter.h"
+#include "nrf_soc.h"
+#include "app_util_platform.h"
+#include <string.h>
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+typedef struct
+{
+    TASK_HANDLER *mpHandler;
+    void *mpContext;
+    uint8_t mPriority;
+    volatile uint32_t mPendingEvents;
+    uint32_t mDeadlineEvents;
+    TIMER_WHEEL_TIMER mDeadline;
+    uint32_t mRunCount;
+    uint32_t mMaxCycles;
+    uint64_t mTotalCycles;
+} Task;
+
+typedef struct
+{
+    Task mTasks[TASK_SCHEDULER_MAX_TASKS];
+    uint8_t mTaskCount;
+    volatile uint32_t mReady;  // Bit n is set while task n has pending events.
+} TaskScheduler;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static void TaskScheduler_DeadlineCallback(void *pContext);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static TaskScheduler taskScheduler;
+
+void TaskScheduler_Init(void) {
+    memset(&taskScheduler, 0, sizeof(taskScheduler));
+}
+
+/**@brief Creates a task. A lower priority value runs first when several tasks are runnable. */
+TASK_ID TaskScheduler_Create(TASK_HANDLER *pHandler, void *pContext, uint8_t priority) {
+    if (taskScheduler.mTaskCount >= TASK_SCHEDULER_MAX_TASKS) {
+        printf("%s(%d) Failed to create task: Maximum count (%d) reached\n", __func__, __LINE__, TASK_SCHEDULER_MAX_TASKS);
+        return TASK_ID_INVALID;
+    }
+
+    TASK_ID taskId = taskScheduler.mTaskCount++;
+    Task *pTask = &taskScheduler.mTasks[taskId];
+    pTask->mpHandler = pHandler;
+    pTask->mpContext = pContext;
+    pTask->mPriority = priority;
+    return taskId;
+}
+
+/**@brief Posts events to a task. Can be called from interrupt context. */
+void TaskScheduler_Post(TASK_ID taskId, uint32_t events) {
+    if (taskId >= taskScheduler.mTaskCount) {
+        printf("%s(%d) Invalid task %d\n", __func__, __LINE__, taskId);
+        return;
+    }
+
+    CRITICAL_REGION_ENTER();
+    taskScheduler.mTasks[taskId].mPendingEvents |= events;
+    taskScheduler.mReady |= (1UL << taskId);
+    CRITICAL_REGION_EXIT();
+}
+
+/**@brief Posts events to a task once timeoutTicks RTC ticks have passed.
+ *
+ * @details Each task has one deadline. Setting it again replaces the previous one.
+ */
+void TaskScheduler_PostAfter(TASK_ID taskId, uint32_t events, uint32_t timeoutTicks) {
+    if (taskId >= taskScheduler.mTaskCount) {
+        printf("%s(%d) Invalid task %d\n", __func__, __LINE__, taskId);
+        return;
+    }
+
+    Task *pTask = &taskScheduler.mTasks[taskId];
+    uint32_t wheelTicks = (timeoutTicks + TIMER_WHEEL_RTC_TICKS_PER_TICK - 1) / TIMER_WHEEL_RTC_TICKS_PER_TICK;
+    pTask->mDeadlineEvents = events;
+    TimerWheel_Start(&pTask->mDeadline, wheelTicks, 0, TaskScheduler_DeadlineCallback, pTask);
+}
+
+void TaskScheduler_CancelDeadline(TASK_ID taskId) {
+    if (taskId >= taskScheduler.mTaskCount) {
+        printf("%s(%d) Invalid task %d\n", __func__, __LINE__, taskId);
+        return;
+    }
+
+    TimerWheel_Stop(&taskScheduler.mTasks[taskId].mDeadline);
+}
+
+/**@brief Runs the runnable task with the highest priority to completion.
+ *
+ * @retval true  A task ran.
+ * @retval false No task was runnable.
+ */
+bool TaskScheduler_RunNext(void) {
+    Task *pTask = NULL;
+    uint32_t events = 0;
+
+    CRITICAL_REGION_ENTER();
+    uint32_t ready = taskScheduler.mReady;
+    while (ready) {
+        TASK_ID taskId = (TASK_ID)__builtin_ctz(ready);
+        ready &= ready - 1;
+        if (pTask == NULL || taskScheduler.mTasks[taskId].mPriority < pTask->mPriority) {
+            pTask = &taskScheduler.mTasks[taskId];
+        }
+    }
+    if (pTask != NULL) {
+        events = pTask->mPendingEvents;
+        pTask->mPendingEvents = 0;
+        taskScheduler.mReady &= ~(1UL << (pTask - taskScheduler.mTasks));
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (pTask == NULL) {
+        return false;
+    }
+
+    uint32_t startCycles = CycleCounter_Get();
+    pTask->mpHandler(pTask->mpContext, events);
+    uint32_t cycles = CycleCounter_Get() - startCycles;
+
+    pTask->mRunCount++;
+    pTask->mTotalCycles += cycles;
+    if (cycles > pTask->mMaxCycles) {
+        pTask->mMaxCycles = cycles;
+    }
+    return true;
+}
+
+bool TaskScheduler_IsIdle(void) {
+    return taskScheduler.mReady == 0;
+}
+
+void TaskScheduler_GetStats(TASK_ID taskId, TASK_STATS *pStats) {
+    memset(pStats, 0, sizeof(*pStats));
+    if (taskId >= taskScheduler.mTaskCount) {
+        printf("%s(%d) Invalid task %d\n", __func__, __LINE__, taskId);
+        return;
+    }
+
+    Task *pTask = &taskScheduler.mTasks[taskId];
+    pStats->mRunCount = pTask->mRunCount;
+    pStats->mMaxCycles = pTask->mMaxCycles;
+    pStats->mTotalCycles = pTask->mTotalCycles;
+    pStats->mMeanCycles = (pTask->mRunCount > 0) ? (uint32_t)(pTask->mTotalCycles / pTask->mRunCount) : 0;
+}
+
+#if TASK_SCHEDULER_STATS_LOG_ENABLED
+void TaskScheduler_DumpStats(void) {
+    for (TASK_ID taskId = 0; taskId < taskScheduler.mTaskCount; taskId++) {
+        TASK_STATS stats;
+        TaskScheduler_GetStats(taskId, &stats);
+        printf("%s(%d) task %d: runs=%d max=%dus mean=%dus\n", __func__, __LINE__, taskId,
+               stats.mRunCount, CycleCounter_ToUs(stats.mMaxCycles), CycleCounter_ToUs(stats.mMeanCycles));
+    }
+}
+#endif
+
+static void TaskScheduler_DeadlineCallback(void *pContext) {
+    Task *pTask = (Task*)pContext;
+    TaskScheduler_Post((TASK_ID)(pTask - taskScheduler.mTasks), pTask->mDeadlineEvents);
+}
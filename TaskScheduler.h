@@ -0,0 +1,32 @@
+#pragma once
+
+#include "sdk_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TASK_SCHEDULER_MAX_TASKS 8  /**< Maximum number of tasks created. */
+#define TASK_ID_INVALID 0xFF
+
+typedef uint8_t TASK_ID;
+
+/**@brief Task body. Runs to completion with all events posted since its previous run. */
+typedef void(TASK_HANDLER)(void *pContext, uint32_t events);
+
+typedef struct {
+    uint32_t mRunCount;     /**< Number of times the task ran. */
+    uint32_t mMaxCycles;    /**< Longest run in CPU cycles. */
+    uint32_t mMeanCycles;   /**< Mean run in CPU cycles. */
+    uint64_t mTotalCycles;  /**< Total CPU cycles spent in the task. */
+} TASK_STATS;
+
+void TaskScheduler_Init(void);
+TASK_ID TaskScheduler_Create(TASK_HANDLER *pHandler, void *pContext, uint8_t priority);
+void TaskScheduler_Post(TASK_ID taskId, uint32_t events);
+void TaskScheduler_PostAfter(TASK_ID taskId, uint32_t events, uint32_t timeoutTicks);
+void TaskScheduler_CancelDeadline(TASK_ID taskId);
+bool TaskScheduler_RunNext(void);
+bool TaskScheduler_IsIdle(void);
+void TaskScheduler_GetStats(TASK_ID taskId, TASK_STATS *pStats);
+#if TASK_SCHEDULER_STATS_LOG_ENABLED
+void TaskScheduler_DumpStats(void);
+#endif
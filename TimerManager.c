@@ -1,35 +1,83 @@
 #include "TimerManager.h"
 #include "nrf_soc.h"
+#include "app_util_platform.h"
+#include <string.h>
+#if TIMER_MANAGER_PROFILER_ENABLED
+#include "CycleCounter.h"
+#endif
 
 /*============================================================================*/
 // define
 /*============================================================================*/
+struct Timer
+{
+    app_timer_t mTimerData;
+    app_timer_id_t mTimerId;
+    TIMER_CALLBACK *mpCallback;
+    void *mpContext;
+    bool mInUse;
+    bool mAutoRelease;
+    bool mRepeated;
+    bool mPeriodic;
+    TIMER_MISSED_POLICY mPolicy;
+    uint32_t mPeriodTicks;
+    uint32_t mTimeoutTicks;
+    uint32_t mDeadline;
+    uint32_t mCount;
+    uint32_t mMissedCount;
+    uint32_t mMaxLatenessTicks;
+    uint64_t mTotalLatenessTicks;
+};
+
+#if TIMER_MANAGER_PROFILER_ENABLED
 typedef struct
 {
-    app_timer_id_t *mpTimerId;
-    TIMER_CALLBACK *mCallback;
-} Timer;
+    TIMER_CALLBACK *mpCallback;
+    uint32_t mInvocationCount;
+    uint32_t mMaxCycles;
+    uint64_t mTotalCycles;
+    uint32_t mMaxLatenessTicks;
+} TimerProfile;
+#endif
 
 typedef struct
 {
-    Timer mTimers[TIMER_CREATE_COUNT];
-    uint8_t mRegisteredCount;
+    struct Timer mTimers[TIMER_POOL_SIZE];
+    uint8_t mUsedCount;
+    uint8_t mPeakCount;
+#if TIMER_MANAGER_PROFILER_ENABLED
+    TimerProfile mProfiles[TIMER_MANAGER_PROFILE_COUNT];
+#endif
 } TimerManager;
 
-#define APP_TIMER_OP_QUEUE_SIZE (TIMER_CREATE_COUNT)
+#define APP_TIMER_OP_QUEUE_SIZE (TIMER_POOL_SIZE)
+#define TIMER_COUNTER_BITS 24  /**< Width of the RTC counter behind app_timer. */
+#define TIMER_COUNTER_MASK ((1UL << TIMER_COUNTER_BITS) - 1)
 
 /*============================================================================*/
 // Local function
 /*============================================================================*/
-static Timer* TimerManager_FindTimerById(TimerManager *this, app_timer_id_t *mpTimerId);
+static TIMER_HANDLE TimerManager_Allocate(TimerManager *this, TIMER_CALLBACK *pCallback, app_timer_mode_t mode, bool autoRelease);
+static void TimerManager_Free(TimerManager *this, struct Timer *pTimer);
+static void TimerManager_Dispatch(void *pContext);
+static void TimerManager_PeriodicDispatch(struct Timer *pTimer);
+static int32_t TimerManager_TicksUntil(uint32_t deadline, uint32_t now);
+#if TIMER_MANAGER_PROFILER_ENABLED
+static TimerProfile* TimerManager_FindProfile(TimerManager *this, TIMER_CALLBACK *pCallback, bool create);
+static void TimerManager_ProfiledCall(TimerManager *this, TIMER_CALLBACK *pCallback, void *pContext, uint32_t latenessTicks);
+#endif
 
 /*============================================================================*/
 // Local variable
 /*============================================================================*/
-TimerManager timerManager;
+static TimerManager timerManager;
 
 void TimerManager_Init(void) {
-    memset(timerManager, 0, sizeof(timerManager));
+    memset(&timerManager, 0, sizeof(timerManager));
+
+    for (size_t i = 0; i < TIMER_POOL_SIZE; i++) {
+        timerManager.mTimers[i].mTimerId = &timerManager.mTimers[i].mTimerData;
+    }
 
     ret_code_t err_code = app_timer_init();
     if (err_code != NRF_SUCCESS) {
@@ -38,60 +86,321 @@ void TimerManager_Init(void) {
     }
 }
 
-void TimerManager_Register(app_timer_id_t *pTimerId, TIMER_CALLBACK *pCallback, app_timer_mode_t mode) {
-    if (timerManager.mRegisteredCount >= TIMER_CREATE_COUNT) {
-        printf("%s(%d) Failed to register timer: Maximum count (%d) reached\n", __func__, __LINE__, timerManager.mRegisteredCount);
+TIMER_HANDLE TimerManager_Acquire(TIMER_CALLBACK *pCallback, app_timer_mode_t mode) {
+    TIMER_HANDLE hTimer = TimerManager_Allocate(&timerManager, pCallback, mode, false);
+    if (hTimer != NULL) {
+        printf("%s(%d) Timer acquired successfully (ID: %p)\n", __func__, __LINE__, hTimer);
+    }
+    return hTimer;
+}
+
+void TimerManager_Release(TIMER_HANDLE hTimer) {
+    if (hTimer == NULL || !hTimer->mInUse) {
+        printf("%s(%d) Timer not acquired (ID: %p)\n", __func__, __LINE__, hTimer);
+        return;
+    }
+
+    app_timer_stop(hTimer->mTimerId);
+    TimerManager_Free(&timerManager, hTimer);
+}
+
+void TimerManager_Start(TIMER_HANDLE hTimer, uint32_t timeoutTicks, void *pContext) {
+    if (hTimer == NULL || !hTimer->mInUse) {
+        printf("%s(%d) Timer not acquired (ID: %p)\n", __func__, __LINE__, hTimer);
         return;
     }
 
-    Timer *pNewTimer = &timerManager.mTimers[timerManager.mRegisteredCount++];
-    pNewTimer->mCallback = pCallback;
-    pNewTimer->mpTimerId = pTimerId;
-    ret_code_t err_code = app_timer_create(pNewTimer->mpTimerId, mode, pNewTimer->mCallback);
+    hTimer->mpContext = pContext;
+    hTimer->mTimeoutTicks = timeoutTicks;
+    hTimer->mDeadline = (TimerManager_GetTicks() + timeoutTicks) & TIMER_COUNTER_MASK;
+    ret_code_t err_code = app_timer_start(hTimer->mTimerId, timeoutTicks, hTimer);
     if (err_code != NRF_SUCCESS) {
-        printf("%s(%d) Error creating timer: %d\n", __func__, __LINE__, err_code);
+        printf("%s(%d) Error starting timer (ID: %p): %d\n", __func__, __LINE__, hTimer, err_code);
         APP_ERROR_CHECK(err_code);
-    } else {
-        printf("%s(%d) Timer registered successfully (ID: %p)\n", __func__, __LINE__, pTimerId);
     }
 }
 
-void TimerManager_Start(app_timer_id_t *pTimerId, uint32_t timeoutTicks, void *pContext) {
-    Timer *pTimer = TimerManager_FindTimerById(&timerManager, pTimerId);
-    if (pTimer == NULL) {
-        printf("%s(%d) Timer not registered ID %p\n", __func__, __LINE__, pTimerId);  
-        return;      
+void TimerManager_Stop(TIMER_HANDLE hTimer) {
+    if (hTimer == NULL || !hTimer->mInUse) {
+        printf("%s(%d) Timer not acquired (ID: %p)\n", __func__, __LINE__, hTimer);
+        return;
     }
 
-    ret_code_t err_code = app_timer_start(*pTimer->mpTimerId, timeoutTicks, pContext);
+    ret_code_t err_code = app_timer_stop(hTimer->mTimerId);
     if (err_code != NRF_SUCCESS) {
-        printf("%s(%d) Error starting timer (ID: %p): %d\n", __func__, __LINE__, pTimerId, err_code);
+        printf("%s(%d) Error stopping timer (ID: %p): %d\n", __func__, __LINE__, hTimer, err_code);
         APP_ERROR_CHECK(err_code);
     }
 }
 
-void TimerManager_Stop(app_timer_id_t *pTimerId) {
-    Timer *pTimer = TimerManager_FindTimerById(&timerManager, pTimerId);
-    if (pTimer == NULL) {
-        printf("%s(%d) Timer not registered\n", __func__, __LINE__);
+/**@brief Starts a single shot timer whose slot is returned to the pool once the callback has run. */
+bool TimerManager_StartOneShot(TIMER_CALLBACK *pCallback, uint32_t timeoutTicks, void *pContext) {
+    TIMER_HANDLE hTimer = TimerManager_Allocate(&timerManager, pCallback, APP_TIMER_MODE_SINGLE_SHOT, true);
+    if (hTimer == NULL) {
+        return false;
+    }
+
+    TimerManager_Start(hTimer, timeoutTicks, pContext);
+    return true;
+}
+
+/**@brief Starts a periodic timer whose deadlines are fixed multiples of the period from the start time.
+ *
+ * @details Unlike APP_TIMER_MODE_REPEATED, a late callback does not shift the following deadlines.
+ *          Deadlines overdue by a whole period are counted as missed and handled according to policy.
+ */
+TIMER_HANDLE TimerManager_StartPeriodic(TIMER_CALLBACK *pCallback, uint32_t periodTicks, TIMER_MISSED_POLICY policy, void *pContext) {
+    TIMER_HANDLE hTimer = TimerManager_Allocate(&timerManager, pCallback, APP_TIMER_MODE_SINGLE_SHOT, false);
+    if (hTimer == NULL) {
+        return NULL;
+    }
+
+    hTimer->mPeriodic = true;
+    hTimer->mPolicy = policy;
+    hTimer->mPeriodTicks = periodTicks;
+    TimerManager_Start(hTimer, periodTicks, pContext);
+    return hTimer;
+}
+
+/**@brief Changes the period of a periodic timer. The new grid starts one period from now.
+ *
+ * @details A callback already queued for the old deadline still runs once.
+ */
+void TimerManager_SetPeriod(TIMER_HANDLE hTimer, uint32_t periodTicks) {
+    if (hTimer == NULL || !hTimer->mPeriodic) {
+        printf("%s(%d) Not a periodic timer (ID: %p)\n", __func__, __LINE__, hTimer);
+        return;
+    }
+
+    TimerManager_Stop(hTimer);
+    hTimer->mPeriodTicks = periodTicks;
+    TimerManager_Start(hTimer, periodTicks, hTimer->mpContext);
+}
+
+void TimerManager_GetPeriodicStats(TIMER_HANDLE hTimer, TIMER_PERIODIC_STATS *pStats) {
+    memset(pStats, 0, sizeof(*pStats));
+    if (hTimer == NULL || !hTimer->mPeriodic) {
+        printf("%s(%d) Not a periodic timer (ID: %p)\n", __func__, __LINE__, hTimer);
         return;
     }
 
-    ret_code_t err_code = app_timer_stop(*pTimer->mpTimerId);
+    CRITICAL_REGION_ENTER();
+    pStats->mCount = hTimer->mCount;
+    pStats->mMissedCount = hTimer->mMissedCount;
+    pStats->mMaxLatenessTicks = hTimer->mMaxLatenessTicks;
+    pStats->mMeanLatenessTicks = (hTimer->mCount > 0) ? (uint32_t)(hTimer->mTotalLatenessTicks / hTimer->mCount) : 0;
+    CRITICAL_REGION_EXIT();
+}
+
+uint32_t TimerManager_GetTicks(void) {
+    return app_timer_cnt_get();
+}
+
+/**@brief RTC ticks elapsed since a value returned by TimerManager_GetTicks, across counter wrap. */
+uint32_t TimerManager_GetTicksSince(uint32_t ticks) {
+    return (TimerManager_GetTicks() - ticks) & TIMER_COUNTER_MASK;
+}
+
+#if TIMER_MANAGER_PROFILER_ENABLED
+bool TimerManager_GetProfile(TIMER_CALLBACK *pCallback, TIMER_PROFILE *pProfile) {
+    memset(pProfile, 0, sizeof(*pProfile));
+    TimerProfile *pEntry;
+
+    CRITICAL_REGION_ENTER();
+    pEntry = TimerManager_FindProfile(&timerManager, pCallback, false);
+    if (pEntry != NULL) {
+        pProfile->mInvocationCount = pEntry->mInvocationCount;
+        pProfile->mMaxCycles = pEntry->mMaxCycles;
+        pProfile->mMeanCycles = (pEntry->mInvocationCount > 0) ? (uint32_t)(pEntry->mTotalCycles / pEntry->mInvocationCount) : 0;
+        pProfile->mMaxLatenessTicks = pEntry->mMaxLatenessTicks;
+    }
+    CRITICAL_REGION_EXIT();
+
+    return pEntry != NULL;
+}
+
+void TimerManager_DumpProfiles(void) {
+    for (size_t i = 0; i < TIMER_MANAGER_PROFILE_COUNT; i++) {
+        TIMER_PROFILE profile;
+        TIMER_CALLBACK *pCallback = timerManager.mProfiles[i].mpCallback;
+        if (pCallback == NULL || !TimerManager_GetProfile(pCallback, &profile)) {
+            continue;
+        }
+        printf("%s(%d) %p: count=%d max=%dus mean=%dus late=%dticks\n", __func__, __LINE__, pCallback,
+               profile.mInvocationCount, CycleCounter_ToUs(profile.mMaxCycles),
+               CycleCounter_ToUs(profile.mMeanCycles), profile.mMaxLatenessTicks);
+    }
+}
+#endif
+
+uint8_t TimerManager_GetUsage(void) {
+    return timerManager.mUsedCount;
+}
+
+uint8_t TimerManager_GetPeakUsage(void) {
+    return timerManager.mPeakCount;
+}
+
+static TIMER_HANDLE TimerManager_Allocate(TimerManager *this, TIMER_CALLBACK *pCallback, app_timer_mode_t mode, bool autoRelease) {
+    struct Timer *pTimer = NULL;
+
+    CRITICAL_REGION_ENTER();
+    for (size_t i = 0; i < TIMER_POOL_SIZE; i++) {
+        if (!this->mTimers[i].mInUse) {
+            pTimer = &this->mTimers[i];
+            pTimer->mInUse = true;
+            this->mUsedCount++;
+            if (this->mUsedCount > this->mPeakCount) {
+                this->mPeakCount = this->mUsedCount;
+            }
+            break;
+        }
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (pTimer == NULL) {
+        printf("%s(%d) Failed to acquire timer: Maximum count (%d) reached\n", __func__, __LINE__, TIMER_POOL_SIZE);
+        return NULL;
+    }
+
+    pTimer->mpCallback = pCallback;
+    pTimer->mpContext = NULL;
+    pTimer->mAutoRelease = autoRelease;
+    pTimer->mRepeated = (mode == APP_TIMER_MODE_REPEATED);
+    pTimer->mPeriodic = false;
+    pTimer->mCount = 0;
+    pTimer->mMissedCount = 0;
+    pTimer->mMaxLatenessTicks = 0;
+    pTimer->mTotalLatenessTicks = 0;
+
+    // app_timer2 allows an idle timer to be created again, so a slot can change its mode on every acquire.
+    ret_code_t err_code = app_timer_create(&pTimer->mTimerId, mode, TimerManager_Dispatch);
+    if (err_code != NRF_SUCCESS) {
+        printf("%s(%d) Error creating timer: %d\n", __func__, __LINE__, err_code);
+        TimerManager_Free(this, pTimer);
+        APP_ERROR_CHECK(err_code);
+        return NULL;
+    }
+    return pTimer;
+}
+
+static void TimerManager_Free(TimerManager *this, struct Timer *pTimer) {
+    CRITICAL_REGION_ENTER();
+    if (pTimer->mInUse) {
+        pTimer->mInUse = false;
+        pTimer->mpCallback = NULL;
+        this->mUsedCount--;
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+static void TimerManager_Dispatch(void *pContext) {
+    struct Timer *pTimer = (struct Timer*)pContext;
+#if TIMER_MANAGER_PROFILER_ENABLED
+    int32_t lateness = -TimerManager_TicksUntil(pTimer->mDeadline, TimerManager_GetTicks());
+#endif
+    if (pTimer->mPeriodic) {
+        TimerManager_PeriodicDispatch(pTimer);
+    } else if (pTimer->mRepeated) {
+        pTimer->mDeadline = (pTimer->mDeadline + pTimer->mTimeoutTicks) & TIMER_COUNTER_MASK;
+    }
+
+    TIMER_CALLBACK *pCallback = pTimer->mpCallback;
+    void *pUserContext = pTimer->mpContext;
+
+    // Return one-shot slots before the callback, so that it can chain another wait.
+    if (pTimer->mAutoRelease) {
+        TimerManager_Free(&timerManager, pTimer);
+    }
+
+#if TIMER_MANAGER_PROFILER_ENABLED
+    if (pCallback) TimerManager_ProfiledCall(&timerManager, pCallback, pUserContext, (lateness > 0) ? (uint32_t)lateness : 0);
+#else
+    if (pCallback) pCallback(pUserContext);
+#endif
+}
+
+static void TimerManager_PeriodicDispatch(struct Timer *pTimer) {
+    uint32_t now = TimerManager_GetTicks();
+    int32_t lateness = -TimerManager_TicksUntil(pTimer->mDeadline, now);
+    if (lateness < 0) {
+        lateness = 0;
+    }
+
+    uint32_t missed = (uint32_t)lateness / pTimer->mPeriodTicks;
+    if (missed > 0) {
+        if (pTimer->mPolicy == TIMER_MISSED_POLICY_SKIP) {
+            // Serve the latest overdue deadline only, so the grid stays aligned to the start time.
+            pTimer->mMissedCount += missed;
+            pTimer->mDeadline = (pTimer->mDeadline + missed * pTimer->mPeriodTicks) & TIMER_COUNTER_MASK;
+            lateness -= (int32_t)(missed * pTimer->mPeriodTicks);
+        } else {
+            // The following deadlines are served by the next runs, each counts when it is served.
+            pTimer->mMissedCount++;
+        }
+    }
+
+    pTimer->mCount++;
+    pTimer->mTotalLatenessTicks += (uint32_t)lateness;
+    if ((uint32_t)lateness > pTimer->mMaxLatenessTicks) {
+        pTimer->mMaxLatenessTicks = (uint32_t)lateness;
+    }
+
+    // Arm the next deadline before the callback runs, so that its runtime does not delay the grid.
+    pTimer->mDeadline = (pTimer->mDeadline + pTimer->mPeriodTicks) & TIMER_COUNTER_MASK;
+    int32_t timeout = TimerManager_TicksUntil(pTimer->mDeadline, now);
+    if (timeout < APP_TIMER_MIN_TIMEOUT_TICKS) {
+        timeout = APP_TIMER_MIN_TIMEOUT_TICKS;
+    }
+
+    ret_code_t err_code = app_timer_start(pTimer->mTimerId, (uint32_t)timeout, pTimer);
     if (err_code != NRF_SUCCESS) {
-        printf("%s(%d) Error stopping timer (ID: %p): %d\n", __func__, __LINE__, pTimerId, err_code);
+        printf("%s(%d) Error restarting timer (ID: %p): %d\n", __func__, __LINE__, pTimer, err_code);
         APP_ERROR_CHECK(err_code);
     }
 }
 
-static Timer* TimerManager_FindTimerById(TimerManager *this, app_timer_id_t *mpTimerId) {
+/**@brief Signed distance from now to deadline on the wrapping RTC counter. */
+static int32_t TimerManager_TicksUntil(uint32_t deadline, uint32_t now) {
+    uint32_t diff = (deadline - now) & TIMER_COUNTER_MASK;
+    return (int32_t)(diff << (32 - TIMER_COUNTER_BITS)) >> (32 - TIMER_COUNTER_BITS);
+}
 
-    for (size_t i = 0; i < this->mRegisteredCount; i++)
-    {
-        if (this->mTimers[i].mpTimerId == mpTimerId) {
-            return &this->mTimers[i];
+#if TIMER_MANAGER_PROFILER_ENABLED
+static TimerProfile* TimerManager_FindProfile(TimerManager *this, TIMER_CALLBACK *pCallback, bool create) {
+    for (size_t i = 0; i < TIMER_MANAGER_PROFILE_COUNT; i++) {
+        TimerProfile *pEntry = &this->mProfiles[i];
+        if (pEntry->mpCallback == pCallback) {
+            return pEntry;
+        }
+        if (pEntry->mpCallback == NULL) {
+            if (create) {
+                pEntry->mpCallback = pCallback;
+                return pEntry;
+            }
+            break;
         }
     }
-    printf("%s(%d) Timer not found (ID: %p)\n", __func__, __LINE__, mpTimerId);
     return NULL;
 }
+
+static void TimerManager_ProfiledCall(TimerManager *this, TIMER_CALLBACK *pCallback, void *pContext, uint32_t latenessTicks) {
+    uint32_t startCycles = CycleCounter_Get();
+    pCallback(pContext);
+    uint32_t cycles = CycleCounter_Get() - startCycles;
+
+    CRITICAL_REGION_ENTER();
+    TimerProfile *pEntry = TimerManager_FindProfile(this, pCallback, true);
+    if (pEntry != NULL) {
+        pEntry->mInvocationCount++;
+        pEntry->mTotalCycles += cycles;
+        if (cycles > pEntry->mMaxCycles) {
+            pEntry->mMaxCycles = cycles;
+        }
+        if (latenessTicks > pEntry->mMaxLatenessTicks) {
+            pEntry->mMaxLatenessTicks = latenessTicks;
+        }
+    }
+    CRITICAL_REGION_EXIT();
+}
+#endif
@@ -1,16 +1,62 @@
 #pragma once
 
 #include "app_timer.h"
+#include "sdk_config.h"
+#include <stdbool.h>
 #include <stdint.h>
 
-#define TIMER_CREATE_COUNT 2  /**< Maximum number of timers created. */
-
-APP_TIMER_DEF(TIMER_ID_SHT31);
-APP_TIMER_DEF(TIMER_ID_MAIN);
+#define TIMER_POOL_SIZE 4  /**< Number of timers available in the pool. */
+#define TIMER_TICKS_PER_SECOND (APP_TIMER_CLOCK_FREQ / (APP_TIMER_CONFIG_RTC_FREQUENCY + 1))  /**< RTC1 rate after the prescaler. */
 
 typedef void(TIMER_CALLBACK)(void *pContext);
 
+typedef struct Timer *TIMER_HANDLE;
+
+typedef enum {
+    TIMER_MISSED_POLICY_SKIP,      /**< Missed deadlines are dropped, the next callback runs on the following deadline. */
+    TIMER_MISSED_POLICY_CATCH_UP,  /**< The callback runs back-to-back until every missed deadline has been served. */
+} TIMER_MISSED_POLICY;
+
+typedef struct {
+    uint32_t mCount;             /**< Number of callbacks run. */
+    uint32_t mMissedCount;       /**< Number of deadlines that were overdue by one period or more. */
+    uint32_t mMaxLatenessTicks;  /**< Largest delay between a deadline and its callback. */
+    uint32_t mMeanLatenessTicks; /**< Mean delay between a deadline and its callback. */
+} TIMER_PERIODIC_STATS;
+
+#if TIMER_MANAGER_PROFILER_ENABLED
+typedef struct {
+    uint32_t mInvocationCount;   /**< Number of times the callback ran. */
+    uint32_t mMaxCycles;         /**< Longest callback runtime in CPU cycles. */
+    uint32_t mMeanCycles;        /**< Mean callback runtime in CPU cycles. */
+    uint32_t mMaxLatenessTicks;  /**< Largest delay between the expiry time and the callback in RTC ticks. */
+} TIMER_PROFILE;
+#endif
+
 void TimerManager_Init(void);
-void TimerManager_Register(app_timer_id_t *pTimerId, TIMER_CALLBACK *pCallback, app_timer_mode_t mode);
-void TimerManager_Start(app_timer_id_t *pTimerId, uint32_t timeoutTicks, void *pContext);
-void TimerManager_Stop(app_timer_id_t *pTimerId);
+TIMER_HANDLE TimerManager_Acquire(TIMER_CALLBACK *pCallback, app_timer_mode_t mode);
+void TimerManager_Release(TIMER_HANDLE hTimer);
+void TimerManager_Start(TIMER_HANDLE hTimer, uint32_t timeoutTicks, void *pContext);
+void TimerManager_Stop(TIMER_HANDLE hTimer);
+bool TimerManager_StartOneShot(TIMER_CALLBACK *pCallback, uint32_t timeoutTicks, void *pContext);
+TIMER_HANDLE TimerManager_StartPeriodic(TIMER_CALLBACK *pCallback, uint32_t periodTicks, TIMER_MISSED_POLICY policy, void *pContext);
+void TimerManager_SetPeriod(TIMER_HANDLE hTimer, uint32_t periodTicks);
+void TimerManager_GetPeriodicStats(TIMER_HANDLE hTimer, TIMER_PERIODIC_STATS *pStats);
+uint32_t TimerManager_GetTicks(void);
+uint32_t TimerManager_GetTicksSince(uint32_t ticks);
+uint8_t TimerManager_GetUsage(void);
+uint8_t TimerManager_GetPeakUsage(void);
+#if TIMER_MANAGER_PROFILER_ENABLED
+bool TimerManager_GetProfile(TIMER_CALLBACK *pCallback, TIMER_PROFILE *pProfile);
+void TimerManager_DumpProfiles(void);
+#endif
+
+/**@brief Converts RTC ticks to microseconds. */
+static inline uint32_t TimerManager_TicksToUs(uint64_t ticks) {
+    return (uint32_t)((ticks * 1000000) / TIMER_TICKS_PER_SECOND);
+}
+
+/**@brief Converts microseconds to RTC ticks, rounded down. */
+static inline uint32_t TimerManager_UsToTicks(uint64_t us) {
+    return (uint32_t)((us * TIMER_TICKS_PER_SECOND) / 1000000);
+}
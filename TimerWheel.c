@@ -0,0 +1,295 @@
+#include "TimerWheel.h"
+#include "nrf_soc.h"
+#include "app_util_platform.h"
+#include "app_util.h"
+#include "nordic_common.h"
+#include <string.h>
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define TIMER_WHEEL_SLOTS (1UL << TIMER_WHEEL_LEVEL_BITS)
+#define TIMER_WHEEL_SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_RANGE (1UL << (TIMER_WHEEL_LEVEL_BITS * TIMER_WHEEL_LEVELS))
+#define TIMER_WHEEL_MAX_SLEEP_TICKS TIMER_WHEEL_TICKS(60000)  /**< Longest single app_timer wait, well within the RTC counter range. */
+
+STATIC_ASSERT(TIMER_WHEEL_SLOTS == 32);  // Slot occupancy is kept in one 32-bit word per level.
+STATIC_ASSERT(TIMER_WHEEL_LEVEL_BITS * TIMER_WHEEL_LEVELS < 32);
+
+typedef struct
+{
+    TIMER_WHEEL_TIMER *mpSlots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    uint32_t mOccupied[TIMER_WHEEL_LEVELS];
+    uint32_t mNow;           // Current time in wheel ticks.
+    uint32_t mLastTicks;     // RTC counter value matching mNow.
+    uint32_t mTarget;        // Time being advanced to while expired timers are processed.
+    uint32_t mArmedAt;       // Wheel time at which the RTC timer fires.
+    uint32_t mActiveCount;
+    bool mArmed;
+    bool mAdvancing;
+    TIMER_HANDLE mhTimer;
+} TimerWheel;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static void TimerWheel_Insert(TimerWheel *this, TIMER_WHEEL_TIMER *pTimer);
+static void TimerWheel_Unlink(TimerWheel *this, TIMER_WHEEL_TIMER *pTimer);
+static uint32_t TimerWheel_Elapsed(TimerWheel *this);
+static void TimerWheel_Advance(TimerWheel *this, uint32_t target);
+static void TimerWheel_Cascade(TimerWheel *this, uint8_t level);
+static void TimerWheel_Expire(TimerWheel *this, uint8_t slot);
+static uint32_t TimerWheel_NextEventDistance(TimerWheel *this);
+static void TimerWheel_Arm(TimerWheel *this);
+static void TimerWheel_TimerCallback(void *pContext);
+static uint32_t TimerWheel_NextSetBit(uint32_t bits, uint32_t after);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static TimerWheel timerWheel;
+
+void TimerWheel_Init(void) {
+    memset(&timerWheel, 0, sizeof(timerWheel));
+    timerWheel.mhTimer = TimerManager_Acquire(TimerWheel_TimerCallback, APP_TIMER_MODE_SINGLE_SHOT);
+}
+
+/**@brief Starts or restarts a timer in O(1).
+ *
+ * @param[in] delayTicks   Wheel ticks until the first expiry, see TIMER_WHEEL_TICKS.
+ * @param[in] periodTicks  Wheel ticks between following expiries, 0 for a single shot.
+ */
+void TimerWheel_Start(TIMER_WHEEL_TIMER *pTimer, uint32_t delayTicks, uint32_t periodTicks, TIMER_CALLBACK *pCallback, void *pContext) {
+    TimerWheel *this = &timerWheel;
+    bool rearm = false;
+
+    if (delayTicks == 0) {
+        delayTicks = 1;
+    }
+
+    CRITICAL_REGION_ENTER();
+    if (TimerWheel_IsActive(pTimer)) {
+        TimerWheel_Unlink(this, pTimer);
+    }
+    if (this->mActiveCount == 0 && !this->mAdvancing) {
+        this->mLastTicks = TimerManager_GetTicks();
+    }
+
+    uint32_t base = this->mAdvancing ? this->mTarget : this->mNow;
+    pTimer->mExpires = base + TimerWheel_Elapsed(this) + delayTicks;
+    pTimer->mPeriodTicks = periodTicks;
+    pTimer->mpCallback = pCallback;
+    pTimer->mpContext = pContext;
+    TimerWheel_Insert(this, pTimer);
+
+    rearm = !this->mAdvancing && (!this->mArmed || (int32_t)(pTimer->mExpires - this->mArmedAt) < 0);
+    CRITICAL_REGION_EXIT();
+
+    if (rearm) {
+        TimerWheel_Arm(this);
+    }
+}
+
+void TimerWheel_Stop(TIMER_WHEEL_TIMER *pTimer) {
+    TimerWheel *this = &timerWheel;
+    bool idle = false;
+
+    CRITICAL_REGION_ENTER();
+    if (TimerWheel_IsActive(pTimer)) {
+        TimerWheel_Unlink(this, pTimer);
+        idle = (this->mActiveCount == 0) && this->mArmed && !this->mAdvancing;
+        if (idle) {
+            this->mArmed = false;
+        }
+    }
+    CRITICAL_REGION_EXIT();
+
+    // A wake-up for a stopped timer is harmless, so the RTC timer is only stopped once the wheel is empty.
+    if (idle) {
+        TimerManager_Stop(this->mhTimer);
+    }
+}
+
+bool TimerWheel_IsActive(TIMER_WHEEL_TIMER const *pTimer) {
+    return pTimer->mppPrev != NULL;
+}
+
+uint32_t TimerWheel_GetActiveCount(void) {
+    return timerWheel.mActiveCount;
+}
+
+static void TimerWheel_Insert(TimerWheel *this, TIMER_WHEEL_TIMER *pTimer) {
+    uint32_t delta = pTimer->mExpires - this->mNow;
+    if (delta >= TIMER_WHEEL_RANGE) {
+        printf("%s(%d) Timeout out of range: %d ticks\n", __func__, __LINE__, delta);
+        delta = TIMER_WHEEL_RANGE - 1;
+        pTimer->mExpires = this->mNow + delta;
+    }
+
+    uint8_t level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (1UL << ((level + 1) * TIMER_WHEEL_LEVEL_BITS))) {
+        level++;
+    }
+    uint8_t slot = (pTimer->mExpires >> (level * TIMER_WHEEL_LEVEL_BITS)) & TIMER_WHEEL_SLOT_MASK;
+
+    TIMER_WHEEL_TIMER **ppHead = &this->mpSlots[level][slot];
+    pTimer->mpNext = *ppHead;
+    pTimer->mppPrev = ppHead;
+    if (*ppHead != NULL) {
+        (*ppHead)->mppPrev = &pTimer->mpNext;
+    }
+    *ppHead = pTimer;
+
+    pTimer->mLevel = level;
+    pTimer->mSlot = slot;
+    this->mOccupied[level] |= (1UL << slot);
+    this->mActiveCount++;
+}
+
+static void TimerWheel_Unlink(TimerWheel *this, TIMER_WHEEL_TIMER *pTimer) {
+    *pTimer->mppPrev = pTimer->mpNext;
+    if (pTimer->mpNext != NULL) {
+        pTimer->mpNext->mppPrev = pTimer->mppPrev;
+    }
+    pTimer->mpNext = NULL;
+    pTimer->mppPrev = NULL;
+
+    if (this->mpSlots[pTimer->mLevel][pTimer->mSlot] == NULL) {
+        this->mOccupied[pTimer->mLevel] &= ~(1UL << pTimer->mSlot);
+    }
+    this->mActiveCount--;
+}
+
+/**@brief Wheel ticks passed since mLastTicks. */
+static uint32_t TimerWheel_Elapsed(TimerWheel *this) {
+    return TimerManager_GetTicksSince(this->mLastTicks) / TIMER_WHEEL_RTC_TICKS_PER_TICK;
+}
+
+/**@brief Moves the wheel to target, expiring every timer on the way.
+ *
+ * @details Runs of empty level 0 slots are skipped using the occupancy bitmap,
+ *          so the cost depends on the number of slot boundaries, not on elapsed ticks.
+ */
+static void TimerWheel_Advance(TimerWheel *this, uint32_t target) {
+    this->mTarget = target;
+    this->mAdvancing = true;
+
+    while (this->mNow != target) {
+        uint32_t slot = this->mNow & TIMER_WHEEL_SLOT_MASK;
+        uint32_t ahead = this->mOccupied[0] & ~((2UL << slot) - 1);
+        uint32_t step = (ahead ? (uint32_t)__builtin_ctz(ahead) : TIMER_WHEEL_SLOTS) - slot;
+        if (step > target - this->mNow) {
+            this->mNow = target;
+            break;
+        }
+
+        this->mNow += step;
+        if ((this->mNow & TIMER_WHEEL_SLOT_MASK) == 0) {
+            TimerWheel_Cascade(this, 1);
+        }
+        TimerWheel_Expire(this, this->mNow & TIMER_WHEEL_SLOT_MASK);
+    }
+
+    this->mAdvancing = false;
+}
+
+/**@brief Moves the timers of the slot that became current on a level down to the lower levels. */
+static void TimerWheel_Cascade(TimerWheel *this, uint8_t level) {
+    uint8_t slot = (this->mNow >> (level * TIMER_WHEEL_LEVEL_BITS)) & TIMER_WHEEL_SLOT_MASK;
+    if (slot == 0 && level + 1 < TIMER_WHEEL_LEVELS) {
+        TimerWheel_Cascade(this, level + 1);
+    }
+
+    CRITICAL_REGION_ENTER();
+    TIMER_WHEEL_TIMER *pTimer = this->mpSlots[level][slot];
+    while (pTimer != NULL) {
+        TIMER_WHEEL_TIMER *pNext = pTimer->mpNext;
+        TimerWheel_Unlink(this, pTimer);
+        TimerWheel_Insert(this, pTimer);
+        pTimer = pNext;
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+static void TimerWheel_Expire(TimerWheel *this, uint8_t slot) {
+    while (true) {
+        TIMER_CALLBACK *pCallback = NULL;
+        void *pContext = NULL;
+
+        CRITICAL_REGION_ENTER();
+        TIMER_WHEEL_TIMER *pTimer = this->mpSlots[0][slot];
+        if (pTimer != NULL) {
+            TimerWheel_Unlink(this, pTimer);
+            if (pTimer->mPeriodTicks > 0) {
+                pTimer->mExpires += pTimer->mPeriodTicks;
+                TimerWheel_Insert(this, pTimer);
+            }
+            pCallback = pTimer->mpCallback;
+            pContext = pTimer->mpContext;
+        }
+        CRITICAL_REGION_EXIT();
+
+        if (pCallback == NULL) {
+            break;
+        }
+        pCallback(pContext);
+    }
+}
+
+/**@brief Wheel ticks until the next expiry or cascade that has work to do. */
+static uint32_t TimerWheel_NextEventDistance(TimerWheel *this) {
+    uint32_t distance = TIMER_WHEEL_MAX_SLEEP_TICKS;
+
+    if (this->mOccupied[0]) {
+        uint32_t slot = this->mNow & TIMER_WHEEL_SLOT_MASK;
+        distance = MIN(distance, TimerWheel_NextSetBit(this->mOccupied[0], slot));
+    }
+
+    for (uint8_t level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+        if (!this->mOccupied[level]) {
+            continue;
+        }
+        uint8_t shift = level * TIMER_WHEEL_LEVEL_BITS;
+        uint32_t block = this->mNow >> shift;
+        uint32_t next = TimerWheel_NextSetBit(this->mOccupied[level], block & TIMER_WHEEL_SLOT_MASK);
+        distance = MIN(distance, ((block + next) << shift) - this->mNow);
+    }
+    return distance;
+}
+
+static void TimerWheel_Arm(TimerWheel *this) {
+    uint32_t timeout;
+
+    CRITICAL_REGION_ENTER();
+    uint32_t elapsed = TimerWheel_Elapsed(this);
+    uint32_t distance = TimerWheel_NextEventDistance(this);
+    this->mArmedAt = this->mNow + distance;
+    this->mArmed = true;
+
+    distance = (distance > elapsed) ? (distance - elapsed) : 0;
+    timeout = MAX(distance * TIMER_WHEEL_RTC_TICKS_PER_TICK, APP_TIMER_MIN_TIMEOUT_TICKS);
+    CRITICAL_REGION_EXIT();
+
+    TimerManager_Stop(this->mhTimer);
+    TimerManager_Start(this->mhTimer, timeout, this);
+}
+
+static void TimerWheel_TimerCallback(void *pContext) {
+    TimerWheel *this = (TimerWheel*)pContext;
+
+    this->mArmed = false;
+    uint32_t elapsed = TimerWheel_Elapsed(this);
+    this->mLastTicks += elapsed * TIMER_WHEEL_RTC_TICKS_PER_TICK;
+    TimerWheel_Advance(this, this->mNow + elapsed);
+
+    if (this->mActiveCount > 0) {
+        TimerWheel_Arm(this);
+    }
+}
+
+/**@brief Distance from bit "after" to the next set bit, going around: 1 for the following bit, 32 for "after" itself. */
+static uint32_t TimerWheel_NextSetBit(uint32_t bits, uint32_t after) {
+    uint32_t shift = (after + 1) & TIMER_WHEEL_SLOT_MASK;
+    uint32_t rotated = (bits >> shift) | (bits << ((TIMER_WHEEL_SLOTS - shift) & TIMER_WHEEL_SLOT_MASK));
+    return (uint32_t)__builtin_ctz(rotated) + 1;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "TimerManager.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TIMER_WHEEL_RTC_TICKS_PER_TICK 16  /**< Resolution of the wheel in RTC ticks (about 1 ms at 16384 Hz). */
+#define TIMER_WHEEL_LEVEL_BITS 5           /**< Each level has 2^TIMER_WHEEL_LEVEL_BITS slots. */
+#define TIMER_WHEEL_LEVELS 4               /**< Number of levels, the range is 2^(LEVEL_BITS * LEVELS) wheel ticks (about 17 min). */
+
+#define TIMER_WHEEL_TICKS(ms) (APP_TIMER_TICKS(ms) / TIMER_WHEEL_RTC_TICKS_PER_TICK)
+
+/**@brief Timer entry of the wheel. The storage is owned by the caller, so the number of timers is not limited. */
+typedef struct TimerWheelTimer {
+    struct TimerWheelTimer *mpNext;
+    struct TimerWheelTimer **mppPrev;
+    uint32_t mExpires;
+    uint32_t mPeriodTicks;
+    TIMER_CALLBACK *mpCallback;
+    void *mpContext;
+    uint8_t mLevel;
+    uint8_t mSlot;
+} TIMER_WHEEL_TIMER;
+
+void TimerWheel_Init(void);
+void TimerWheel_Start(TIMER_WHEEL_TIMER *pTimer, uint32_t delayTicks, uint32_t periodTicks, TIMER_CALLBACK *pCallback, void *pContext);
+void TimerWheel_Stop(TIMER_WHEEL_TIMER *pTimer);
+bool TimerWheel_IsActive(TIMER_WHEEL_TIMER const *pTimer);
+uint32_t TimerWheel_GetActiveCount(void);
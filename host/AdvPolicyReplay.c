@@ -0,0 +1,71 @@
+#include "AdvPolicy.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Replays recorded sensor traces through AdvPolicy and reports the estimated charge per day.
+ *
+ * Each trace file holds one sample per line, "temperature,humidity[,battery]" with the readings in 0.01 units
+ * and the battery level in percent. Lines starting with '#' are ignored.
+ *
+ *   cc -Ihost -Ipca10056/s140/config -I. host/AdvPolicyReplay.c AdvPolicy.c -o adv_policy_replay
+ *   ./adv_policy_replay office.csv cellar.csv
+ */
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static int AdvPolicyReplay_Run(char const *pPath);
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        printf("usage: %s trace.csv...\n", argv[0]);
+        return 1;
+    }
+
+    int result = 0;
+    for (int i = 1; i < argc; i++) {
+        result |= AdvPolicyReplay_Run(argv[i]);
+    }
+    return result;
+}
+
+static int AdvPolicyReplay_Run(char const *pPath) {
+    FILE *pFile = fopen(pPath, "r");
+    if (pFile == NULL) {
+        printf("%s: cannot open\n", pPath);
+        return 1;
+    }
+
+    char line[64];
+    uint32_t sampleCount = 0;
+    AdvPolicy_Init();
+    while (fgets(line, sizeof(line), pFile) != NULL) {
+        int temperature;
+        int humidity;
+        int battery;
+        if (line[0] == '#') {
+            continue;
+        }
+
+        int fields = sscanf(line, "%d,%d,%d", &temperature, &humidity, &battery);
+        if (fields < 2) {
+            continue;
+        }
+        if (fields == 3) {
+            AdvPolicy_SetBatteryLevel((uint8_t)battery);
+        }
+        AdvPolicy_Update((int16_t)temperature, (int16_t)humidity);
+        sampleCount++;
+    }
+    fclose(pFile);
+
+    ADV_POLICY_STATS stats;
+    AdvPolicy_GetStats(&stats);
+    printf("%s: samples=%u changes=%u", pPath, sampleCount, stats.mChangeCount);
+    for (int i = 0; i < ADV_POLICY_CLASS_COUNT; i++) {
+        uint32_t percent = (sampleCount > 0) ? (uint32_t)((uint64_t)stats.mSampleCount[i] * 100 / sampleCount) : 0;
+        printf(" %ums=%u%%", AdvPolicy_GetIntervalMs((ADV_POLICY_CLASS)i), percent);
+    }
+    printf(" estimate=%uuAh/day\n", AdvPolicy_EstimateMicroAhPerDay());
+    return 0;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**@brief Software AES-128 block encryption for host tools and gateways.
+ *
+ * @details Matches BEACON_CRYPTO_BLOCK_ENCRYPT, so verifiers pass it to BeaconCrypto_Init. Aes128.c also
+ *          provides sd_ecb_block_encrypt for firmware modules built on the host. Not hardened against
+ *          timing attacks, do not use it on devices.
+ */
+bool Aes128_Encrypt(uint8_t const *pKey, uint8_t const *pIn, uint8_t *pOut);
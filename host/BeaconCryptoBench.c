@@ -0,0 +1,114 @@
+#include "BeaconCrypto.h"
+#include "BeaconSchema.h"
+#include "Aes128.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* Measures the cost of sealing a frame with BeaconCrypto, for the sizes of data the firmware seals: the readings,
+ * the history in a legacy frame and in extended frames of 64 and 255 bytes, all behind the 4-byte identifier.
+ *
+ * The block encryptions of a seal depend only on the sizes, and are counted. On the device each of them is a call
+ * to sd_ecb_block_encrypt, and the seal time it reports in ADVERTISING_STATS is measured with the cycle counter.
+ * On the host the block cipher is host/Aes128.c, so the time per block is not the one of the ECB peripheral. The
+ * seal is also timed with a cipher that does nothing, which leaves the CCM code around the blocks, the part that
+ * runs on the CPU on the device as well.
+ *
+ *   cc -O2 -Ihost -Ipca10056/s140/config -I. host/BeaconCryptoBench.c BeaconCrypto.c host/Aes128.c \
+ *      -o beacon_crypto_bench
+ *   ./beacon_crypto_bench
+ */
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define BENCH_SEAL_COUNT        200000
+#define BENCH_AAD_SIZE          6       /**< Version, 4-byte identifier and data type. */
+#define BENCH_TRAILER_SIZE      (BEACON_CRYPTO_COUNTER_SIZE + BEACON_CRYPTO_MIC_SIZE)
+#define BENCH_MAX_DATA_SIZE     255
+
+typedef struct {
+    char const *mpName;
+    uint16_t mDataSize;
+} BenchCase;
+
+typedef struct
+{
+    BEACON_CRYPTO_BLOCK_ENCRYPT *mpCipher;
+    uint32_t mBlockCount;
+} BeaconCryptoBench;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static uint64_t BeaconCryptoBench_Run(BeaconCryptoBench *this, BEACON_CRYPTO_BLOCK_ENCRYPT *pCipher, uint16_t dataSize);
+static bool BeaconCryptoBench_Encrypt(uint8_t const *pKey, uint8_t const *pIn, uint8_t *pOut);
+static bool BeaconCryptoBench_NoEncrypt(uint8_t const *pKey, uint8_t const *pIn, uint8_t *pOut);
+static uint64_t BeaconCryptoBench_GetNs(void);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static BeaconCryptoBench beaconCryptoBench;
+
+static BenchCase const m_cases[] =
+{
+    { "readings", BEACON_READINGS_SIZE - 1 },
+    { "legacy history", 31 - 2 - 2 - BENCH_AAD_SIZE - BENCH_TRAILER_SIZE },
+    { "extended 64", 64 - 2 - 2 - BENCH_AAD_SIZE - BENCH_TRAILER_SIZE },
+    { "extended 255", 255 - 2 - 2 - BENCH_AAD_SIZE - BENCH_TRAILER_SIZE },
+};
+
+int main(void) {
+    BeaconCryptoBench *this = &beaconCryptoBench;
+
+    BeaconCrypto_Init(BeaconCryptoBench_Encrypt);
+    printf("frame            data  blocks  seal ns  CCM only ns\n");
+    for (size_t i = 0; i < sizeof(m_cases) / sizeof(m_cases[0]); i++) {
+        BenchCase const *pCase = &m_cases[i];
+        uint64_t sealNs = BeaconCryptoBench_Run(this, Aes128_Encrypt, pCase->mDataSize);
+        uint32_t blockCount = this->mBlockCount / BENCH_SEAL_COUNT;
+        uint64_t ccmNs = BeaconCryptoBench_Run(this, BeaconCryptoBench_NoEncrypt, pCase->mDataSize);
+        printf("%-15s %5u %7u %8.0f %12.0f\n", pCase->mpName, pCase->mDataSize, blockCount,
+               (double)sealNs / BENCH_SEAL_COUNT, (double)ccmNs / BENCH_SEAL_COUNT);
+    }
+    return 0;
+}
+
+/**@brief Seals BENCH_SEAL_COUNT frames with the given cipher and returns the time they took. */
+static uint64_t BeaconCryptoBench_Run(BeaconCryptoBench *this, BEACON_CRYPTO_BLOCK_ENCRYPT *pCipher, uint16_t dataSize) {
+    uint8_t key[BEACON_CRYPTO_KEY_SIZE] = { 0 };
+    uint8_t identifier[BEACON_CRYPTO_IDENTIFIER_SIZE] = { 0x12, 0x34, 0x56, 0x78 };
+    uint8_t frame[BENCH_AAD_SIZE + BENCH_MAX_DATA_SIZE + BEACON_CRYPTO_MIC_SIZE] = { 0 };
+    uint8_t nonce[BEACON_CRYPTO_NONCE_SIZE];
+
+    this->mpCipher = pCipher;
+    this->mBlockCount = 0;
+    uint64_t startNs = BeaconCryptoBench_GetNs();
+    for (uint32_t counter = 0; counter < BENCH_SEAL_COUNT; counter++) {
+        BeaconCrypto_MakeNonce(identifier, counter, nonce);
+        if (!BeaconCrypto_Seal(key, nonce, frame, BENCH_AAD_SIZE, &frame[BENCH_AAD_SIZE], dataSize,
+                               &frame[BENCH_AAD_SIZE + dataSize])) {
+            printf("%s(%d) Failed to seal\n", __func__, __LINE__);
+        }
+    }
+    return BeaconCryptoBench_GetNs() - startNs;
+}
+
+static bool BeaconCryptoBench_Encrypt(uint8_t const *pKey, uint8_t const *pIn, uint8_t *pOut) {
+    beaconCryptoBench.mBlockCount++;
+    return beaconCryptoBench.mpCipher(pKey, pIn, pOut);
+}
+
+/**@brief Stands in for the cipher, so that only the CCM code is timed. */
+static bool BeaconCryptoBench_NoEncrypt(uint8_t const *pKey, uint8_t const *pIn, uint8_t *pOut) {
+    (void)pKey;
+    memcpy(pOut, pIn, BEACON_CRYPTO_BLOCK_SIZE);
+    return true;
+}
+
+static uint64_t BeaconCryptoBench_GetNs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
@@ -0,0 +1,330 @@
+#include "BeaconSchema.h"
+#include "SampleCodec.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Computes per-beacon reception from advertisements captured by a gateway.
+ *
+ * Each capture file holds one received advertisement per line, "time_ms,address,advertising data in hex".
+ * Lines starting with '#' and frames without Open Sensor service data are ignored, as are scan responses and
+ * the statistics and health frames, which carry no sequence number.
+ * Frames are placed by their sequence number, or by the index of the newest sample for history frames,
+ * which wrap at 256: a beacon must be heard at least once every 127 sequence numbers.
+ *
+ * For every beacon it reports how many frames were heard, how many of them were new, and the share of the
+ * sequence numbers between the first and the last one heard that were received. For history frames this
+ * is the share of samples, including those recovered from the older entries of later frames. Many repeats
+ * per new frame mean the advertising interval could be longer for the gateways in range.
+ *
+ *   cc -Ihost -I. host/BeaconLossAnalyzer.c SampleCodec.c -o beacon_loss_analyzer
+ *   ./beacon_loss_analyzer capture.csv
+ */
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define BEACON_LOSS_MAX_BEACONS     64
+#define BEACON_LOSS_MAX_SEQUENCES   (1UL << 20)  /**< Sequence numbers tracked per beacon, about 12 days at 1 Hz. */
+#define BEACON_LOSS_ADDRESS_SIZE    24
+#define BEACON_LOSS_LINE_SIZE       640
+#define BEACON_LOSS_MAX_ADV_DATA    255
+
+#define OPEN_SENSOR_SERVICE_UUID    0xFCBE
+#define AD_TYPE_SERVICE_DATA        0x16
+#define HISTORY_SAMPLE_SIZE         4
+#define HISTORY_NO_SAMPLE           0x8000
+
+/* Flags per sequence number. */
+#define BEACON_LOSS_SENT            (1U << 0)  /**< A frame with this sequence number was heard. */
+#define BEACON_LOSS_SAMPLE          (1U << 1)  /**< The sample was heard, possibly in a later history frame. */
+
+typedef struct
+{
+    char mAddress[BEACON_LOSS_ADDRESS_SIZE];
+    uint8_t *mpFlags;            // Indexed by unwrapped sequence number.
+    bool mHasSequence;
+    uint32_t mSequence;          // Unwrapped sequence number of the last frame heard.
+    uint32_t mFirst;
+    uint32_t mLast;
+    uint32_t mFrameCount;
+    uint32_t mRepeatCount;
+    uint32_t mLateCount;         // Frames older than the last one, or too far ahead to place.
+    bool mIsHistory;
+} BeaconLossBeacon;
+
+typedef struct
+{
+    BeaconLossBeacon mBeacons[BEACON_LOSS_MAX_BEACONS];
+    uint32_t mBeaconCount;
+    uint32_t mIgnoredCount;
+} BeaconLossAnalyzer;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static int BeaconLossAnalyzer_Run(BeaconLossAnalyzer *this, char const *pPath);
+static void BeaconLossAnalyzer_Report(BeaconLossAnalyzer *this, char const *pPath);
+static BeaconLossBeacon *BeaconLossAnalyzer_GetBeacon(BeaconLossAnalyzer *this, char const *pAddress);
+static bool BeaconLossAnalyzer_ParseFrame(uint8_t const *pData, uint16_t length, uint8_t *pSequence,
+                                          uint32_t *pSampleCount, bool *pIsHistory);
+static bool BeaconLossAnalyzer_IsReadings(uint8_t const *pReadings, uint16_t length);
+static uint16_t BeaconLossAnalyzer_ParseHex(char const *pHex, uint8_t *pData, uint16_t size);
+static void BeaconLossAnalyzer_Add(BeaconLossBeacon *this, uint8_t sequence, uint32_t sampleCount, bool isHistory);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static BeaconLossAnalyzer analyzer;
+
+static BEACON_SCHEMA_FIELD const m_readings_fields[] = { BEACON_READINGS_FIELDS };
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        printf("usage: %s capture.csv...\n", argv[0]);
+        return 1;
+    }
+
+    int result = 0;
+    for (int i = 1; i < argc; i++) {
+        memset(&analyzer, 0, sizeof(analyzer));
+        result |= BeaconLossAnalyzer_Run(&analyzer, argv[i]);
+        for (uint32_t j = 0; j < analyzer.mBeaconCount; j++) {
+            free(analyzer.mBeacons[j].mpFlags);
+        }
+    }
+    return result;
+}
+
+static int BeaconLossAnalyzer_Run(BeaconLossAnalyzer *this, char const *pPath) {
+    FILE *pFile = fopen(pPath, "r");
+    if (pFile == NULL) {
+        printf("%s: cannot open\n", pPath);
+        return 1;
+    }
+
+    char line[BEACON_LOSS_LINE_SIZE];
+    while (fgets(line, sizeof(line), pFile) != NULL) {
+        if (line[0] == '#') {
+            continue;
+        }
+
+        char *pAddress = strchr(line, ',');
+        char *pHex = (pAddress != NULL) ? strchr(pAddress + 1, ',') : NULL;
+        if (pHex == NULL) {
+            this->mIgnoredCount++;
+            continue;
+        }
+        *pHex++ = '\0';
+        pAddress++;
+
+        uint8_t data[BEACON_LOSS_MAX_ADV_DATA];
+        uint16_t length = BeaconLossAnalyzer_ParseHex(pHex, data, sizeof(data));
+        uint8_t sequence;
+        uint32_t sampleCount;
+        bool isHistory;
+        if (!BeaconLossAnalyzer_ParseFrame(data, length, &sequence, &sampleCount, &isHistory)) {
+            this->mIgnoredCount++;
+            continue;
+        }
+
+        BeaconLossBeacon *pBeacon = BeaconLossAnalyzer_GetBeacon(this, pAddress);
+        if (pBeacon == NULL) {
+            this->mIgnoredCount++;
+            continue;
+        }
+        BeaconLossAnalyzer_Add(pBeacon, sequence, sampleCount, isHistory);
+    }
+    fclose(pFile);
+
+    BeaconLossAnalyzer_Report(this, pPath);
+    return 0;
+}
+
+static void BeaconLossAnalyzer_Report(BeaconLossAnalyzer *this, char const *pPath) {
+    printf("%s: beacons=%u ignored=%u\n", pPath, this->mBeaconCount, this->mIgnoredCount);
+    for (uint32_t i = 0; i < this->mBeaconCount; i++) {
+        BeaconLossBeacon *pBeacon = &this->mBeacons[i];
+        uint32_t span = pBeacon->mLast - pBeacon->mFirst + 1;
+        uint32_t sent = 0;
+        uint32_t samples = 0;
+        for (uint32_t sequence = pBeacon->mFirst; sequence <= pBeacon->mLast; sequence++) {
+            sent += (pBeacon->mpFlags[sequence] & BEACON_LOSS_SENT) ? 1 : 0;
+            samples += (pBeacon->mpFlags[sequence] & BEACON_LOSS_SAMPLE) ? 1 : 0;
+        }
+
+        // Every frame of a readings beacon has its own sequence number. History frames skip sample indexes
+        // while the readings stay within the deadband, so only the samples they carry count.
+        uint32_t received = pBeacon->mIsHistory ? samples : sent;
+        uint32_t newCount = pBeacon->mFrameCount - pBeacon->mRepeatCount;
+        printf("  %s: frames=%u new=%u frames/new=%u.%02u late=%u %s=%u received=%u (%u.%u%%)\n",
+               pBeacon->mAddress, pBeacon->mFrameCount, newCount,
+               (newCount > 0) ? pBeacon->mFrameCount / newCount : 0,
+               (newCount > 0) ? pBeacon->mFrameCount * 100 / newCount % 100 : 0,
+               pBeacon->mLateCount, pBeacon->mIsHistory ? "samples" : "sequences", span, received,
+               received * 100 / span, received * 1000 / span % 10);
+    }
+}
+
+static BeaconLossBeacon *BeaconLossAnalyzer_GetBeacon(BeaconLossAnalyzer *this, char const *pAddress) {
+    for (uint32_t i = 0; i < this->mBeaconCount; i++) {
+        if (strcmp(this->mBeacons[i].mAddress, pAddress) == 0) {
+            return &this->mBeacons[i];
+        }
+    }
+    if (this->mBeaconCount >= BEACON_LOSS_MAX_BEACONS) {
+        return NULL;
+    }
+
+    BeaconLossBeacon *pBeacon = &this->mBeacons[this->mBeaconCount];
+    pBeacon->mpFlags = calloc(BEACON_LOSS_MAX_SEQUENCES, sizeof(uint8_t));
+    if (pBeacon->mpFlags == NULL) {
+        return NULL;
+    }
+    snprintf(pBeacon->mAddress, sizeof(pBeacon->mAddress), "%s", pAddress);
+    this->mBeaconCount++;
+    return pBeacon;
+}
+
+/**@brief Finds the Open Sensor service data and reads the sequence number and the samples of a frame.
+ *
+ * @retval true  The frame carries readings.
+ * @retval false Other advertisement, scan response or malformed data.
+ */
+static bool BeaconLossAnalyzer_ParseFrame(uint8_t const *pData, uint16_t length, uint8_t *pSequence,
+                                          uint32_t *pSampleCount, bool *pIsHistory) {
+    uint16_t offset = 0;
+    uint8_t const *pInfo = NULL;
+    uint16_t infoLength = 0;
+
+    while (offset + 2 <= length && pData[offset] != 0) {
+        uint8_t fieldLength = pData[offset];
+        if (offset + 1 + fieldLength > length) {
+            return false;
+        }
+        if (pData[offset + 1] == AD_TYPE_SERVICE_DATA && fieldLength > 3 &&
+            (pData[offset + 2] | (pData[offset + 3] << 8)) == OPEN_SENSOR_SERVICE_UUID) {
+            pInfo = &pData[offset + 4];
+            infoLength = (uint16_t)(fieldLength - 3);
+            break;
+        }
+        offset += fieldLength + 1;
+    }
+    if (pInfo == NULL || infoLength < 1) {
+        return false;
+    }
+
+    uint16_t dataIndex;
+    if (pInfo[0] == DATA_SCHEMA_VERSION) {
+        dataIndex = 6;
+    } else if (pInfo[0] == DATA_SCHEMA_VERSION_COMPACT) {
+        dataIndex = 4;
+    } else {
+        return false;
+    }
+    if (infoLength < dataIndex + 1) {
+        return false;
+    }
+
+    uint8_t const *pReadings = &pInfo[dataIndex - 1];
+    if (BeaconLossAnalyzer_IsReadings(pReadings, (uint16_t)(infoLength - dataIndex + 1))) {
+        *pSequence = (uint8_t)BEACON_SCHEMA_GET(pReadings, READINGS, SEQUENCE);
+        *pSampleCount = 1;
+        *pIsHistory = false;
+        return true;
+    }
+
+    uint8_t const *pPayload = &pInfo[dataIndex];
+    uint16_t payloadLength = (uint16_t)(infoLength - dataIndex);
+    switch (pInfo[dataIndex - 1]) {
+    case DATA_TYPE_HISTORY:
+        *pSequence = pPayload[0];
+        *pSampleCount = 0;
+        for (uint16_t i = 1; i + HISTORY_SAMPLE_SIZE <= payloadLength; i += HISTORY_SAMPLE_SIZE) {
+            if ((uint16_t)((pPayload[i] << 8) | pPayload[i + 1]) != HISTORY_NO_SAMPLE) {
+                (*pSampleCount)++;
+            }
+        }
+        *pIsHistory = true;
+        return true;
+
+    case DATA_TYPE_HISTORY_COMPRESSED: {
+        SAMPLE samples[UINT8_MAX];
+        *pSequence = pPayload[0];
+        *pSampleCount = SampleCodec_Decode(&pPayload[1], (uint16_t)(payloadLength - 1), samples, UINT8_MAX);
+        *pIsHistory = true;
+        return *pSampleCount > 0;
+    }
+
+    default:
+        return false;
+    }
+}
+
+/**@brief Tells whether the data holds every field of the readings frame of BeaconSchema.h. */
+static bool BeaconLossAnalyzer_IsReadings(uint8_t const *pReadings, uint16_t length) {
+    if (length < BEACON_READINGS_SIZE) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(m_readings_fields) / sizeof(m_readings_fields[0]); i++) {
+        if (pReadings[m_readings_fields[i].mIndex] != m_readings_fields[i].mType) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint16_t BeaconLossAnalyzer_ParseHex(char const *pHex, uint8_t *pData, uint16_t size) {
+    uint16_t length = 0;
+    unsigned int byte;
+    while (length < size && sscanf(pHex, "%2x", &byte) == 1) {
+        pData[length++] = (uint8_t)byte;
+        pHex += 2;
+    }
+    return length;
+}
+
+static void BeaconLossAnalyzer_Add(BeaconLossBeacon *this, uint8_t sequence, uint32_t sampleCount, bool isHistory) {
+    this->mFrameCount++;
+    this->mIsHistory |= isHistory;
+
+    uint32_t unwrapped;
+    if (!this->mHasSequence) {
+        // Leave room for the older samples of the first frame and for frames arriving out of order.
+        unwrapped = 2 * 256 + sequence;
+        this->mSequence = unwrapped;
+        this->mFirst = unwrapped;
+        this->mLast = unwrapped;
+        this->mHasSequence = true;
+    } else {
+        uint8_t ahead = (uint8_t)(sequence - (uint8_t)this->mSequence);
+        if (ahead >= 128) {
+            unwrapped = this->mSequence - (uint32_t)(256 - ahead);
+            this->mLateCount++;
+        } else {
+            unwrapped = this->mSequence + ahead;
+        }
+        if (unwrapped >= BEACON_LOSS_MAX_SEQUENCES) {
+            return;
+        }
+    }
+
+    if (this->mpFlags[unwrapped] & BEACON_LOSS_SENT) {
+        this->mRepeatCount++;
+    }
+    this->mpFlags[unwrapped] |= BEACON_LOSS_SENT;
+    for (uint32_t age = 0; age < sampleCount && age <= unwrapped; age++) {
+        this->mpFlags[unwrapped - age] |= BEACON_LOSS_SAMPLE;
+    }
+
+    if (unwrapped > this->mSequence) {
+        this->mSequence = unwrapped;
+    }
+    if (unwrapped < this->mFirst) {
+        this->mFirst = unwrapped;
+    }
+    if (unwrapped > this->mLast) {
+        this->mLast = unwrapped;
+    }
+}
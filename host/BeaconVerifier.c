@@ -0,0 +1,279 @@
+#include "Aes128.h"
+#include "BeaconCrypto.h"
+#include "BeaconSchema.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Checks and decrypts sealed advertisements captured by a gateway.
+ *
+ * Reads the capture format of BeaconLossAnalyzer, "time_ms,address,advertising data in hex", and writes
+ * every authentic frame back in the same format on stdout, decrypted, without the counter and the MIC and
+ * with the sealed flag cleared, so that the output can be fed to the analyzer. Frames in clear are passed
+ * through. The report goes to stderr.
+ *
+ * Compact frames carry only the last 2 bytes of the identifier. The full identifier is taken from the
+ * scan response of the same address, so compact frames heard before any scan response are not verified.
+ *
+ * A frame is counted as replayed when its counter is below the last authentic counter of the beacon; the
+ * repeats of the current frame are authentic. The counter starts at a random value on every reset of the
+ * beacon, so a reset can show up as replays until the counter passes the last value heard.
+ *
+ *   cc -Ihost -I. host/BeaconVerifier.c host/Aes128.c BeaconCrypto.c -o beacon_verifier
+ *   ./beacon_verifier 000102030405060708090a0b0c0d0e0f capture.csv > opened.csv
+ */
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define BEACON_VERIFIER_MAX_BEACONS     64
+#define BEACON_VERIFIER_ADDRESS_SIZE    24
+#define BEACON_VERIFIER_LINE_SIZE       640
+#define BEACON_VERIFIER_MAX_ADV_DATA    255
+
+#define OPEN_SENSOR_SERVICE_UUID        0xFCBE
+#define AD_TYPE_SERVICE_DATA            0x16
+#define AD_SERVICE_DATA_HEADER_SIZE     4     /**< Length, AD type and UUID in front of the service data. */
+#define SHORT_IDENTIFIER_SIZE           2
+#define TRAILER_SIZE                    (BEACON_CRYPTO_COUNTER_SIZE + BEACON_CRYPTO_MIC_SIZE)
+
+typedef struct
+{
+    char mAddress[BEACON_VERIFIER_ADDRESS_SIZE];
+    bool mHasIdentifier;
+    uint8_t mIdentifier[BEACON_CRYPTO_IDENTIFIER_SIZE];
+    uint8_t mKey[BEACON_CRYPTO_KEY_SIZE];
+    bool mHasCounter;
+    uint32_t mCounter;           // Counter of the last authentic frame.
+    uint32_t mAuthenticCount;
+    uint32_t mForgedCount;       // Frames whose MIC does not match.
+    uint32_t mReplayedCount;     // Authentic frames older than the last one.
+    uint32_t mUnverifiedCount;   // Compact frames heard before the identifier is known.
+    uint32_t mClearCount;
+} BeaconVerifierBeacon;
+
+typedef struct
+{
+    uint8_t mMasterKey[BEACON_CRYPTO_KEY_SIZE];
+    BeaconVerifierBeacon mBeacons[BEACON_VERIFIER_MAX_BEACONS];
+    uint32_t mBeaconCount;
+    uint32_t mIgnoredCount;
+} BeaconVerifier;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static int BeaconVerifier_Run(BeaconVerifier *this, char const *pPath);
+static void BeaconVerifier_Report(BeaconVerifier *this, char const *pPath);
+static BeaconVerifierBeacon *BeaconVerifier_GetBeacon(BeaconVerifier *this, char const *pAddress);
+static bool BeaconVerifier_FindServiceData(uint8_t const *pData, uint16_t length, uint16_t *pOffset);
+static bool BeaconVerifier_Open(BeaconVerifier *this, BeaconVerifierBeacon *pBeacon, uint8_t *pInfo,
+                                uint16_t infoLength);
+static uint16_t BeaconVerifier_ParseHex(char const *pHex, uint8_t *pData, uint16_t size);
+static uint32_t BeaconVerifier_GetUint32(uint8_t const *pData);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static BeaconVerifier verifier;
+
+int main(int argc, char **argv) {
+    if (argc < 3 || strlen(argv[1]) != BEACON_CRYPTO_KEY_SIZE * 2 ||
+        BeaconVerifier_ParseHex(argv[1], verifier.mMasterKey, BEACON_CRYPTO_KEY_SIZE) != BEACON_CRYPTO_KEY_SIZE) {
+        printf("usage: %s master_key_hex capture.csv...\n", argv[0]);
+        return 1;
+    }
+    BeaconCrypto_Init(Aes128_Encrypt);
+
+    int result = 0;
+    for (int i = 2; i < argc; i++) {
+        memset(verifier.mBeacons, 0, sizeof(verifier.mBeacons));
+        verifier.mBeaconCount = 0;
+        verifier.mIgnoredCount = 0;
+        result |= BeaconVerifier_Run(&verifier, argv[i]);
+    }
+    return result;
+}
+
+static int BeaconVerifier_Run(BeaconVerifier *this, char const *pPath) {
+    FILE *pFile = fopen(pPath, "r");
+    if (pFile == NULL) {
+        fprintf(stderr, "%s: cannot open\n", pPath);
+        return 1;
+    }
+
+    char line[BEACON_VERIFIER_LINE_SIZE];
+    while (fgets(line, sizeof(line), pFile) != NULL) {
+        if (line[0] == '#') {
+            fputs(line, stdout);
+            continue;
+        }
+
+        char *pAddress = strchr(line, ',');
+        char *pHex = (pAddress != NULL) ? strchr(pAddress + 1, ',') : NULL;
+        if (pHex == NULL) {
+            this->mIgnoredCount++;
+            continue;
+        }
+        *pAddress++ = '\0';
+        *pHex++ = '\0';
+
+        uint8_t data[BEACON_VERIFIER_MAX_ADV_DATA];
+        uint16_t length = BeaconVerifier_ParseHex(pHex, data, sizeof(data));
+        uint16_t offset;
+        BeaconVerifierBeacon *pBeacon;
+        if (!BeaconVerifier_FindServiceData(data, length, &offset) ||
+            (pBeacon = BeaconVerifier_GetBeacon(this, pAddress)) == NULL) {
+            this->mIgnoredCount++;
+            continue;
+        }
+
+        uint8_t *pInfo = &data[offset + AD_SERVICE_DATA_HEADER_SIZE];
+        uint16_t infoLength = (uint16_t)(data[offset] + 1 - AD_SERVICE_DATA_HEADER_SIZE);
+        if (pInfo[0] & DATA_SCHEMA_SEALED) {
+            if (!BeaconVerifier_Open(this, pBeacon, pInfo, infoLength)) {
+                continue;
+            }
+            // Drop the trailer and shift the AD structures behind the service data.
+            uint16_t end = (uint16_t)(offset + data[offset] + 1);
+            memmove(&data[end - TRAILER_SIZE], &data[end], length - end);
+            data[offset] -= TRAILER_SIZE;
+            length -= TRAILER_SIZE;
+        } else {
+            pBeacon->mClearCount++;
+            // Learn the full identifier from the metadata in the scan response.
+            if (pInfo[0] == DATA_SCHEMA_VERSION && infoLength > 1 + BEACON_CRYPTO_IDENTIFIER_SIZE &&
+                pInfo[1 + BEACON_CRYPTO_IDENTIFIER_SIZE] == DATA_TYPE_METADATA && !pBeacon->mHasIdentifier) {
+                memcpy(pBeacon->mIdentifier, &pInfo[1], BEACON_CRYPTO_IDENTIFIER_SIZE);
+                pBeacon->mHasIdentifier = BeaconCrypto_DeriveKey(this->mMasterKey, pBeacon->mIdentifier, pBeacon->mKey);
+            }
+        }
+
+        printf("%s,%s,", line, pAddress);
+        for (uint16_t i = 0; i < length; i++) {
+            printf("%02x", data[i]);
+        }
+        printf("\n");
+    }
+    fclose(pFile);
+
+    BeaconVerifier_Report(this, pPath);
+    return 0;
+}
+
+static void BeaconVerifier_Report(BeaconVerifier *this, char const *pPath) {
+    fprintf(stderr, "%s: beacons=%u ignored=%u\n", pPath, this->mBeaconCount, this->mIgnoredCount);
+    for (uint32_t i = 0; i < this->mBeaconCount; i++) {
+        BeaconVerifierBeacon *pBeacon = &this->mBeacons[i];
+        fprintf(stderr, "  %s: authentic=%u forged=%u replayed=%u unverified=%u clear=%u\n", pBeacon->mAddress,
+                pBeacon->mAuthenticCount, pBeacon->mForgedCount, pBeacon->mReplayedCount, pBeacon->mUnverifiedCount,
+                pBeacon->mClearCount);
+    }
+}
+
+static BeaconVerifierBeacon *BeaconVerifier_GetBeacon(BeaconVerifier *this, char const *pAddress) {
+    for (uint32_t i = 0; i < this->mBeaconCount; i++) {
+        if (strcmp(this->mBeacons[i].mAddress, pAddress) == 0) {
+            return &this->mBeacons[i];
+        }
+    }
+    if (this->mBeaconCount >= BEACON_VERIFIER_MAX_BEACONS) {
+        return NULL;
+    }
+
+    BeaconVerifierBeacon *pBeacon = &this->mBeacons[this->mBeaconCount];
+    snprintf(pBeacon->mAddress, sizeof(pBeacon->mAddress), "%s", pAddress);
+    this->mBeaconCount++;
+    return pBeacon;
+}
+
+/**@brief Finds the AD structure holding the Open Sensor service data.
+ *
+ * @retval true  pOffset is the position of its length byte.
+ * @retval false Other advertisement or malformed data.
+ */
+static bool BeaconVerifier_FindServiceData(uint8_t const *pData, uint16_t length, uint16_t *pOffset) {
+    uint16_t offset = 0;
+    while (offset + 2 <= length && pData[offset] != 0) {
+        uint8_t fieldLength = pData[offset];
+        if (offset + 1 + fieldLength > length) {
+            return false;
+        }
+        if (pData[offset + 1] == AD_TYPE_SERVICE_DATA && fieldLength >= AD_SERVICE_DATA_HEADER_SIZE &&
+            (pData[offset + 2] | (pData[offset + 3] << 8)) == OPEN_SENSOR_SERVICE_UUID) {
+            *pOffset = offset;
+            return true;
+        }
+        offset += fieldLength + 1;
+    }
+    return false;
+}
+
+/**@brief Checks the MIC of a sealed frame and decrypts it in place, clearing the sealed flag.
+ *
+ * @retval true  The frame is authentic and not older than the last one.
+ * @retval false The frame was forged, replayed or could not be verified, it is counted in the beacon.
+ */
+static bool BeaconVerifier_Open(BeaconVerifier *this, BeaconVerifierBeacon *pBeacon, uint8_t *pInfo,
+                                uint16_t infoLength) {
+    uint8_t version = (uint8_t)(pInfo[0] & ~DATA_SCHEMA_SEALED);
+    uint16_t dataIndex;
+    if (version == DATA_SCHEMA_VERSION) {
+        dataIndex = 1 + BEACON_CRYPTO_IDENTIFIER_SIZE + 1;
+        if (!pBeacon->mHasIdentifier || memcmp(pBeacon->mIdentifier, &pInfo[1], BEACON_CRYPTO_IDENTIFIER_SIZE) != 0) {
+            memcpy(pBeacon->mIdentifier, &pInfo[1], BEACON_CRYPTO_IDENTIFIER_SIZE);
+            pBeacon->mHasIdentifier = BeaconCrypto_DeriveKey(this->mMasterKey, pBeacon->mIdentifier, pBeacon->mKey);
+        }
+    } else if (version == DATA_SCHEMA_VERSION_COMPACT) {
+        dataIndex = 1 + SHORT_IDENTIFIER_SIZE + 1;
+        if (!pBeacon->mHasIdentifier ||
+            memcmp(&pBeacon->mIdentifier[BEACON_CRYPTO_IDENTIFIER_SIZE - SHORT_IDENTIFIER_SIZE], &pInfo[1],
+                   SHORT_IDENTIFIER_SIZE) != 0) {
+            pBeacon->mUnverifiedCount++;
+            return false;
+        }
+    } else {
+        this->mIgnoredCount++;
+        return false;
+    }
+    if (!pBeacon->mHasIdentifier || infoLength < dataIndex + TRAILER_SIZE) {
+        pBeacon->mForgedCount++;
+        return false;
+    }
+
+    uint8_t *pTrailer = &pInfo[infoLength - TRAILER_SIZE];
+    uint32_t counter = BeaconVerifier_GetUint32(pTrailer);
+    uint8_t nonce[BEACON_CRYPTO_NONCE_SIZE];
+    BeaconCrypto_MakeNonce(pBeacon->mIdentifier, counter, nonce);
+    if (!BeaconCrypto_Open(pBeacon->mKey, nonce, pInfo, dataIndex, &pInfo[dataIndex],
+                           (uint16_t)(infoLength - TRAILER_SIZE - dataIndex), &pTrailer[BEACON_CRYPTO_COUNTER_SIZE])) {
+        pBeacon->mForgedCount++;
+        return false;
+    }
+
+    // Gateways hear the same frame many times, only an older counter is a replay.
+    if (pBeacon->mHasCounter && (int32_t)(counter - pBeacon->mCounter) < 0) {
+        pBeacon->mReplayedCount++;
+        return false;
+    }
+    pBeacon->mHasCounter = true;
+    pBeacon->mCounter = counter;
+    pBeacon->mAuthenticCount++;
+    pInfo[0] = version;
+    return true;
+}
+
+static uint16_t BeaconVerifier_ParseHex(char const *pHex, uint8_t *pData, uint16_t size) {
+    uint16_t length = 0;
+    unsigned int byte;
+    while (length < size && sscanf(pHex, "%2x", &byte) == 1) {
+        pData[length++] = (uint8_t)byte;
+        pHex += 2;
+    }
+    return length;
+}
+
+static uint32_t BeaconVerifier_GetUint32(uint8_t const *pData) {
+    return ((uint32_t)pData[0] << 24) | ((uint32_t)pData[1] << 16) | ((uint32_t)pData[2] << 8) | pData[3];
+}
@@ -0,0 +1,248 @@
+#include "Advertising.h"
+#include "BeaconSchema.h"
+#include "FrameRotation.h"
+#include "RadioSync.h"
+#include "SampleHistory.h"
+#include "TaskScheduler.h"
+#include "TimerWheel.h"
+#include "SoftDeviceSim.h"
+#include "TimerManagerSim.h"
+#include "app_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Runs the frame rotation on the radio notifications of advertising events timed like the link layer does, and
+ * sorts the frames sent by the data type of their first field. It reports the share of the events each frame
+ * got, the longest run of events between two frames of each rotated type, and the time from the readings being
+ * applied to the first frame carrying them, which the rotated frames must not delay. The SoftDevice model
+ * rejects a buffer handed over while in use and counts frames changed while on air.
+ *
+ *   cc -DRADIO_SYNC_ENABLED=1 -DADVERTISING_ROTATION_ENABLED=1 -Ihost -Ipca10056/s140/config -I. \
+ *      host/FrameRotationBench.c FrameRotation.c RadioSync.c Advertising.c SampleHistory.c SampleCodec.c \
+ *      BeaconCrypto.c TaskScheduler.c TimerWheel.c host/SoftDeviceSim.c host/TimerManagerSim.c host/Aes128.c \
+ *      -o frame_rotation_bench
+ *   ./frame_rotation_bench
+ */
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define BENCH_CONN_CFG_TAG          1
+#define BENCH_SAMPLE_COUNT          (4 * ADVERTISING_STATISTICS_WINDOW)
+#define BENCH_ADV_DELAY_MAX_TICKS   APP_TIMER_TICKS(10)
+#define BENCH_MEASURE_TICKS         APP_TIMER_TICKS(17)  /**< SHT31 measurement and the TWI transfers around it. */
+#define BENCH_MAX_FRAME             255
+
+#define OPEN_SENSOR_SERVICE_UUID    0xFCBE
+#define AD_TYPE_SERVICE_DATA        0x16
+
+typedef struct
+{
+    uint64_t mNextEventTicks;
+    uint32_t mSampleCount;
+    uint64_t mAppliedTicks;
+    bool mIsAppliedPending;          // Readings applied, not yet seen in a frame sent.
+    uint8_t mReadings[BENCH_MAX_FRAME];
+    uint16_t mReadingsLength;
+    uint32_t mFrameCount[FRAME_ROTATION_COUNT];
+    uint32_t mSinceLast[FRAME_ROTATION_COUNT];
+    uint32_t mMaxGap[FRAME_ROTATION_COUNT];
+    uint32_t mInvalidCount;          // Statistics frames with a minimum above the maximum.
+    uint32_t mLatencyCount;
+    uint64_t mTotalLatencyTicks;
+    uint64_t mMaxLatencyTicks;
+} FrameRotationBench;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static void FrameRotationBench_Run(FrameRotationBench *this, uint32_t intervalMs);
+static void FrameRotationBench_AdvanceTo(uint64_t timeTicks);
+static void FrameRotationBench_OnDeadline(void *pContext);
+static void FrameRotationBench_Measure(void);
+static void FrameRotationBench_OnReadings(void *pContext);
+static void FrameRotationBench_AdvertisingEvent(FrameRotationBench *this);
+static uint8_t const *FrameRotationBench_FindInfo(uint8_t const *pData, uint16_t length, uint16_t *pInfoLength);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static FrameRotationBench frameRotationBench;
+
+static uint32_t const m_intervals_ms[] = { 100, 250, 1000 };
+
+static char const * const m_frame_names[FRAME_ROTATION_COUNT] = { "readings", "statistics", "health" };
+
+int main(void) {
+    printf("statistics every %u events, health every %u events, window of %u samples\n",
+           ADVERTISING_ROTATION_STATISTICS_EVERY, ADVERTISING_ROTATION_HEALTH_EVERY, ADVERTISING_STATISTICS_WINDOW);
+    for (size_t i = 0; i < sizeof(m_intervals_ms) / sizeof(m_intervals_ms[0]); i++) {
+        FrameRotationBench_Run(&frameRotationBench, m_intervals_ms[i]);
+    }
+    return 0;
+}
+
+static void FrameRotationBench_Run(FrameRotationBench *this, uint32_t intervalMs) {
+    memset(this, 0, sizeof(*this));
+    srand(1);
+
+    // The firmware initialization order of main.c.
+    SoftDeviceSim_Init();
+    TaskScheduler_Init();
+    TimerManager_Init();
+    TimerWheel_Init();
+    SampleHistory_Init();
+    Advertising_Init();
+    Advertising_SetInterval(MSEC_TO_UNITS(intervalMs, UNIT_0_625_MS));
+    RadioSync_Init(FrameRotationBench_Measure, Advertising_GetInterval());
+    RadioSync_SetEventHandler(Advertising_OnAdvertisingEvent);
+    Advertising_Start(BENCH_CONN_CFG_TAG);
+    TimerManager_StartPeriodic(FrameRotationBench_OnDeadline, APP_TIMER_TICKS(SAMPLE_INTERVAL_MS), TIMER_MISSED_POLICY_SKIP, this);
+
+    uint64_t intervalTicks = APP_TIMER_TICKS(intervalMs);
+    uint64_t distanceTicks = TimerManager_UsToTicks(SoftDeviceSim_GetRadioNotificationUs());
+    this->mNextEventTicks = TimerManagerSim_GetTime() + (uint64_t)rand() % intervalTicks;
+    while (this->mSampleCount < BENCH_SAMPLE_COUNT) {
+        FrameRotationBench_AdvanceTo(this->mNextEventTicks - distanceTicks);
+        SoftDeviceSim_RadioNotification();
+        while (TaskScheduler_RunNext()) {}
+
+        FrameRotationBench_AdvanceTo(this->mNextEventTicks);
+        FrameRotationBench_AdvertisingEvent(this);
+        this->mNextEventTicks += intervalTicks + (uint64_t)rand() % (BENCH_ADV_DELAY_MAX_TICKS + 1);
+    }
+
+    SOFTDEVICE_SIM_STATS simStats;
+    FRAME_ROTATION_STATS rotationStats;
+    SoftDeviceSim_GetStats(&simStats);
+    FrameRotation_GetStats(&rotationStats);
+    printf("%4ums: events=%u deferred=%u torn=%u rejected=%u invalid=%u, first air mean=%uus max=%uus\n", intervalMs,
+           simStats.mAdvEventCount, rotationStats.mDeferredCount, simStats.mTornFrameCount, simStats.mRejectedCount,
+           this->mInvalidCount, (this->mLatencyCount > 0) ? TimerManager_TicksToUs(this->mTotalLatencyTicks / this->mLatencyCount) : 0,
+           TimerManager_TicksToUs(this->mMaxLatencyTicks));
+    for (size_t i = 0; i < FRAME_ROTATION_COUNT; i++) {
+        uint32_t share = (simStats.mAdvEventCount > 0) ? this->mFrameCount[i] * 1000 / simStats.mAdvEventCount : 0;
+        printf("        %-10s sent=%5u (%2u.%u%%) longest gap=%u events\n", m_frame_names[i], this->mFrameCount[i],
+               share / 10, share % 10, this->mMaxGap[i]);
+    }
+}
+
+/**@brief Advances the virtual time, running the tasks woken up by every timer on the way. */
+static void FrameRotationBench_AdvanceTo(uint64_t timeTicks) {
+    uint64_t nextTicks;
+    while (TimerManagerSim_GetNextEventTime(&nextTicks) && nextTicks <= timeTicks) {
+        TimerManagerSim_AdvanceToNextEvent();
+        while (TaskScheduler_RunNext()) {}
+    }
+    TimerManagerSim_AdvanceTo(timeTicks);
+}
+
+/**@brief Sampling deadline, what the application task does on APP_EVT_SAMPLE. */
+static void FrameRotationBench_OnDeadline(void *pContext) {
+    (void)pContext;
+    RadioSync_RequestSample();
+}
+
+/**@brief Stands in for SHT31_GetValue, the readings come BENCH_MEASURE_TICKS later. */
+static void FrameRotationBench_Measure(void) {
+    TimerManager_StartOneShot(FrameRotationBench_OnReadings, BENCH_MEASURE_TICKS, &frameRotationBench);
+}
+
+/**@brief What onSensorDataReceived does, with readings moving enough to leave the deadband every time. */
+static void FrameRotationBench_OnReadings(void *pContext) {
+    FrameRotationBench *this = (FrameRotationBench*)pContext;
+    this->mSampleCount++;
+
+    int16_t temperature = (int16_t)(2000 + (int16_t)(this->mSampleCount % 7) * 30);
+    int16_t humidity = (int16_t)(5000 - (int16_t)(this->mSampleCount % 5) * 40);
+    SampleHistory_Add(temperature, humidity);
+    bool isApplied = Advertising_SetReadings(temperature, humidity);
+    RadioSync_OnSampleDone(isApplied);
+    if (isApplied && !this->mIsAppliedPending) {
+        this->mIsAppliedPending = true;
+        this->mAppliedTicks = TimerManagerSim_GetTime();
+    }
+
+    ADVERTISING_HEALTH health;
+    health.mUptimeS = (uint32_t)(TimerManagerSim_GetTime() / TIMER_TICKS_PER_SECOND);
+    health.mDieTemperature = 25 * 4;
+    health.mMissedCount = 0;
+    Advertising_SetHealth(&health);
+}
+
+/**@brief Sends a frame and sorts it by the data type of its first field. */
+static void FrameRotationBench_AdvertisingEvent(FrameRotationBench *this) {
+    if (!SoftDeviceSim_AdvertisingEvent()) {
+        return;
+    }
+
+    uint8_t frame[BENCH_MAX_FRAME];
+    uint16_t length = SoftDeviceSim_GetFrame(frame);
+    uint16_t infoLength;
+    uint8_t const *pInfo = FrameRotationBench_FindInfo(frame, length, &infoLength);
+    if (pInfo == NULL) {
+        return;
+    }
+    // The version, then the short or the full identifier.
+    uint16_t fieldsIndex = ((pInfo[0] & ~DATA_SCHEMA_SEALED) == DATA_SCHEMA_VERSION_COMPACT) ? 3 : 5;
+    if (infoLength <= fieldsIndex) {
+        return;
+    }
+    uint8_t const *pFields = &pInfo[fieldsIndex];
+    uint16_t fieldsLength = (uint16_t)(infoLength - fieldsIndex);
+
+    FRAME_ROTATION_FRAME type = FRAME_ROTATION_READINGS;
+    if (pFields[0] == DATA_TYPE_TEMPERATURE_MIN && fieldsLength >= BEACON_STATISTICS_SIZE) {
+        type = FRAME_ROTATION_STATISTICS;
+        // Sealed frames carry the values in cipher text, only frames in clear can be checked.
+        if (!(pInfo[0] & DATA_SCHEMA_SEALED) &&
+            (BEACON_SCHEMA_GET(pFields, STATISTICS, TEMPERATURE_MIN) > BEACON_SCHEMA_GET(pFields, STATISTICS, TEMPERATURE_MAX) ||
+             BEACON_SCHEMA_GET(pFields, STATISTICS, HUMIDITY_MIN) > BEACON_SCHEMA_GET(pFields, STATISTICS, HUMIDITY_MAX))) {
+            this->mInvalidCount++;
+        }
+    } else if (pFields[0] == DATA_TYPE_UPTIME && fieldsLength >= BEACON_HEALTH_SIZE) {
+        type = FRAME_ROTATION_HEALTH;
+    } else if (this->mIsAppliedPending &&
+               (fieldsLength != this->mReadingsLength || memcmp(pFields, this->mReadings, fieldsLength) != 0)) {
+        uint64_t latencyTicks = TimerManagerSim_GetTime() - this->mAppliedTicks;
+        this->mIsAppliedPending = false;
+        this->mLatencyCount++;
+        this->mTotalLatencyTicks += latencyTicks;
+        if (latencyTicks > this->mMaxLatencyTicks) {
+            this->mMaxLatencyTicks = latencyTicks;
+        }
+    }
+    if (type == FRAME_ROTATION_READINGS) {
+        memcpy(this->mReadings, pFields, fieldsLength);
+        this->mReadingsLength = fieldsLength;
+    }
+
+    // Gaps are counted from the first frame of each type, the rotated frames wait for their data at first.
+    for (size_t i = 0; i < FRAME_ROTATION_COUNT; i++) {
+        if (i == type) {
+            if (this->mFrameCount[i] > 0 && this->mSinceLast[i] > this->mMaxGap[i]) {
+                this->mMaxGap[i] = this->mSinceLast[i];
+            }
+            this->mSinceLast[i] = 0;
+        } else {
+            this->mSinceLast[i]++;
+        }
+    }
+    this->mFrameCount[type]++;
+}
+
+/**@brief Finds the Open Sensor service data, and returns it from the schema version on. */
+static uint8_t const *FrameRotationBench_FindInfo(uint8_t const *pData, uint16_t length, uint16_t *pInfoLength) {
+    uint16_t offset = 0;
+    while (offset + 2 <= length && pData[offset] != 0) {
+        uint8_t fieldLength = pData[offset];
+        if (pData[offset + 1] == AD_TYPE_SERVICE_DATA && fieldLength > 3 &&
+            (pData[offset + 2] | (pData[offset + 3] << 8)) == OPEN_SENSOR_SERVICE_UUID) {
+            *pInfoLength = (uint16_t)(fieldLength - 3);
+            return &pData[offset + 4];
+        }
+        offset += fieldLength + 1;
+    }
+    return NULL;
+}
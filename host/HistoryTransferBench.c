@@ -0,0 +1,253 @@
+#include "HistoryTransfer.h"
+#include "Connection.h"
+#include "SampleHistory.h"
+#include "TaskScheduler.h"
+#include "TimerWheel.h"
+#include "SoftDeviceSim.h"
+#include "TimerManagerSim.h"
+#include "ble_hci.h"
+#include "ble_srv_common.h"
+#include "app_util.h"
+#include "nrf_sdh_ble.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Downloads a full history through HistoryTransfer with SoftDeviceSim standing in for the central, and reports
+ * the throughput for centrals of different capabilities. Every sample received is checked against the one
+ * stored, and one run drops the link halfway and resumes from the last index received.
+ *
+ *   cc -DENV_SENSING_ENABLED=1 -DHISTORY_TRANSFER_ENABLED=1 -DSAMPLE_HISTORY_SIZE=4096 -Ihost -Ipca10056/s140/config -I. \
+ *      host/HistoryTransferBench.c HistoryTransfer.c Connection.c SampleHistory.c TaskScheduler.c TimerWheel.c \
+ *      host/SoftDeviceSim.c host/TimerManagerSim.c -o history_transfer_bench
+ *   ./history_transfer_bench
+ */
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define BENCH_CONN_CFG_TAG          1
+#define BENCH_OP_START              0x01
+#define BENCH_UUID_DATA             0x0003
+#define BENCH_UUID_CONTROL          0x0002
+#define BENCH_TIMEOUT_US            (120 * 1000000ULL)
+#define BENCH_RECONNECT_DELAY_US    1000000ULL
+
+typedef struct {
+    char const *mpName;
+    SOFTDEVICE_SIM_CENTRAL mCentral;
+    uint32_t mDropAfter;          // Notifications received before the link is dropped, 0 to keep it.
+} BenchScenario;
+
+typedef struct
+{
+    BenchScenario const *mpScenario;
+    ble_gatts_char_handles_t mControlHandles;
+    ble_gatts_char_handles_t mDataHandles;
+    uint8_t mAdvHandle;
+    uint64_t mNowUs;
+    uint64_t mStartUs;
+    uint64_t mEndUs;
+    uint32_t mAddedCount;         // Samples added to the history, the pattern of each one follows from its index.
+    uint32_t mExpectedIndex;
+    uint32_t mSampleCount;
+    uint32_t mNotificationCount;
+    uint32_t mByteCount;
+    uint32_t mMissedCount;
+    uint32_t mErrorCount;
+    uint32_t mResumeCount;
+    bool mIsDone;
+} HistoryTransferBench;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static bool HistoryTransferBench_Run(HistoryTransferBench *this, BenchScenario const *pScenario);
+static bool HistoryTransferBench_Connect(HistoryTransferBench *this);
+static void HistoryTransferBench_AddSample(void *pContext);
+static SAMPLE HistoryTransferBench_GetPattern(uint32_t index);
+static void HistoryTransferBench_OnNotification(uint16_t handle, uint8_t const *pData, uint16_t length);
+static void HistoryTransferBench_RunTasks(void);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static HistoryTransferBench historyTransferBench;
+
+static BenchScenario const m_scenarios[] =
+{
+    { "1M, MTU 23, 27 B",         { 24, BLE_GATT_ATT_MTU_DEFAULT, BLE_GAP_DATA_LENGTH_DEFAULT, BLE_GAP_PHY_1MBPS }, 0 },
+    { "1M, MTU 247, 251 B",       { 24, 247, BLE_GAP_DATA_LENGTH_MAX, BLE_GAP_PHY_1MBPS }, 0 },
+    { "2M, MTU 247, 251 B",       { 24, 247, BLE_GAP_DATA_LENGTH_MAX, BLE_GAP_PHY_1MBPS | BLE_GAP_PHY_2MBPS }, 0 },
+    { "2M, MTU 247, 251 B, 75ms", { 60, 247, BLE_GAP_DATA_LENGTH_MAX, BLE_GAP_PHY_1MBPS | BLE_GAP_PHY_2MBPS }, 0 },
+    { "2M, resumed after a drop", { 24, 247, BLE_GAP_DATA_LENGTH_MAX, BLE_GAP_PHY_1MBPS | BLE_GAP_PHY_2MBPS }, 30 },
+};
+
+int main(void) {
+    int result = 0;
+    for (size_t i = 0; i < sizeof(m_scenarios) / sizeof(m_scenarios[0]); i++) {
+        if (!HistoryTransferBench_Run(&historyTransferBench, &m_scenarios[i])) {
+            result = 1;
+        }
+    }
+    return result;
+}
+
+static bool HistoryTransferBench_Run(HistoryTransferBench *this, BenchScenario const *pScenario) {
+    memset(this, 0, sizeof(*this));
+    this->mpScenario = pScenario;
+    this->mAdvHandle = BLE_GAP_ADV_SET_HANDLE_NOT_SET;
+
+    // The firmware initialization order of main.c.
+    SoftDeviceSim_Init();
+    TaskScheduler_Init();
+    TimerManager_Init();
+    TimerWheel_Init();
+    uint32_t ramStart = 0;
+    nrf_sdh_ble_default_cfg_set(BENCH_CONN_CFG_TAG, &ramStart);
+    Connection_ConfigureStack(BENCH_CONN_CFG_TAG, ramStart);
+    Connection_Init(NULL);
+    HistoryTransfer_Init();
+    SampleHistory_Init();
+
+    SoftDeviceSim_SetCentral(&pScenario->mCentral);
+    SoftDeviceSim_SetNotificationHandler(HistoryTransferBench_OnNotification);
+    SoftDeviceSim_SetEventHook(HistoryTransferBench_RunTasks);
+
+    // A full history, still growing during the transfer.
+    while (this->mAddedCount < SAMPLE_HISTORY_SIZE) {
+        HistoryTransferBench_AddSample(this);
+    }
+    TimerManager_StartPeriodic(HistoryTransferBench_AddSample, APP_TIMER_TICKS(PUBLISH_INTERVAL_MS), TIMER_MISSED_POLICY_CATCH_UP, this);
+
+    this->mExpectedIndex = 0;
+    this->mStartUs = this->mNowUs;
+    if (!HistoryTransferBench_Connect(this)) {
+        return false;
+    }
+    while (!this->mIsDone && this->mNowUs - this->mStartUs < BENCH_TIMEOUT_US) {
+        CONNECTION_STATS connStats;
+        Connection_GetStats(&connStats);
+        this->mNowUs += connStats.mIntervalUs;
+        TimerManagerSim_AdvanceTo(TimerManager_UsToTicks(this->mNowUs));
+        HistoryTransferBench_RunTasks();
+
+        uint32_t notificationCount = this->mNotificationCount;
+        uint32_t airUs = SoftDeviceSim_ConnectionEvent();
+        if (this->mIsDone) {
+            this->mEndUs = this->mNowUs + airUs;
+        }
+        if (pScenario->mDropAfter != 0 && this->mResumeCount == 0 &&
+            notificationCount < pScenario->mDropAfter && this->mNotificationCount >= pScenario->mDropAfter) {
+            SoftDeviceSim_Disconnect(BLE_HCI_CONNECTION_TIMEOUT);
+            this->mNowUs += BENCH_RECONNECT_DELAY_US;
+            TimerManagerSim_AdvanceTo(TimerManager_UsToTicks(this->mNowUs));
+            HistoryTransferBench_RunTasks();
+            this->mResumeCount++;
+            if (!HistoryTransferBench_Connect(this)) {
+                return false;
+            }
+        }
+    }
+
+    CONNECTION_STATS connStats;
+    HISTORY_TRANSFER_STATS transferStats;
+    Connection_GetStats(&connStats);
+    HistoryTransfer_GetStats(&transferStats);
+    uint64_t durationUs = this->mEndUs - this->mStartUs;
+    uint32_t centralBps = (durationUs > 0) ? (uint32_t)(((uint64_t)this->mByteCount * 8 * 1000000) / durationUs) : 0;
+    bool isPassed = this->mIsDone && this->mErrorCount == 0 && this->mMissedCount == 0;
+
+    printf("%-26s mtu=%d length=%d phy=%d interval=%dus\n", pScenario->mpName, connStats.mAttMtu, connStats.mDataLength,
+           connStats.mTxPhy, connStats.mIntervalUs);
+    printf("%-26s samples=%d notifications=%d bytes=%d time=%dms central=%dbps device=%dbps resumed=%d missed=%d errors=%d %s\n",
+           "", this->mSampleCount, this->mNotificationCount, this->mByteCount, (uint32_t)(durationUs / 1000), centralBps,
+           transferStats.mThroughputBps, this->mResumeCount, this->mMissedCount, this->mErrorCount, isPassed ? "ok" : "FAILED");
+    return isPassed;
+}
+
+/**@brief Advertises, connects, enables the notifications and asks for the samples from the next index expected. */
+static bool HistoryTransferBench_Connect(HistoryTransferBench *this) {
+    ble_gap_adv_params_t advParams;
+    memset(&advParams, 0, sizeof(advParams));
+    advParams.properties.type = BLE_GAP_ADV_TYPE_CONNECTABLE_SCANNABLE_UNDIRECTED;
+    advParams.interval = MSEC_TO_UNITS(100, UNIT_0_625_MS);
+    ble_gap_adv_data_t advData;
+    memset(&advData, 0, sizeof(advData));
+    if ((this->mAdvHandle == BLE_GAP_ADV_SET_HANDLE_NOT_SET &&
+         sd_ble_gap_adv_set_configure(&this->mAdvHandle, &advData, &advParams) != NRF_SUCCESS) ||
+        sd_ble_gap_adv_start(this->mAdvHandle, BENCH_CONN_CFG_TAG) != NRF_SUCCESS || !SoftDeviceSim_Connect()) {
+        printf("%s: cannot connect\n", this->mpScenario->mpName);
+        return false;
+    }
+
+    if (!SoftDeviceSim_FindCharacteristic(BLE_UUID_TYPE_VENDOR_BEGIN, BENCH_UUID_CONTROL, &this->mControlHandles) ||
+        !SoftDeviceSim_FindCharacteristic(BLE_UUID_TYPE_VENDOR_BEGIN, BENCH_UUID_DATA, &this->mDataHandles)) {
+        printf("%s: service not found\n", this->mpScenario->mpName);
+        return false;
+    }
+
+    uint8_t cccd[BLE_CCCD_VALUE_LEN];
+    uint16_encode(0x0001, cccd);
+    uint8_t request[5] = { BENCH_OP_START };
+    uint32_encode(this->mExpectedIndex, &request[1]);
+    if (!SoftDeviceSim_Write(this->mDataHandles.cccd_handle, cccd, sizeof(cccd)) ||
+        !SoftDeviceSim_Write(this->mControlHandles.value_handle, request, sizeof(request))) {
+        printf("%s: request refused\n", this->mpScenario->mpName);
+        return false;
+    }
+    return true;
+}
+
+/**@brief Adds the next sample of the pattern, as the sampling timer would. */
+static void HistoryTransferBench_AddSample(void *pContext) {
+    HistoryTransferBench *this = (HistoryTransferBench*)pContext;
+    SAMPLE sample = HistoryTransferBench_GetPattern(this->mAddedCount++);
+    SampleHistory_Add(sample.mTemperature, sample.mHumidity);
+}
+
+static SAMPLE HistoryTransferBench_GetPattern(uint32_t index) {
+    SAMPLE sample;
+    sample.mTemperature = (int16_t)(2000 + (int32_t)((index * 37) % 1000) - 500);
+    sample.mHumidity = (int16_t)(5000 + (index * 91) % 2000);
+    return sample;
+}
+
+/**@brief Checks a notification: contiguous indexes, each sample as stored, and the end marker. */
+static void HistoryTransferBench_OnNotification(uint16_t handle, uint8_t const *pData, uint16_t length) {
+    HistoryTransferBench *this = &historyTransferBench;
+    if (handle != this->mDataHandles.value_handle || length < 4 || (length - 4) % 4 != 0) {
+        this->mErrorCount++;
+        return;
+    }
+
+    this->mNotificationCount++;
+    this->mByteCount += length;
+    uint32_t index = uint32_decode(pData);
+    if (index < this->mExpectedIndex) {
+        printf("index %d sent again, %d expected\n", index, this->mExpectedIndex);
+        this->mErrorCount++;
+    } else if (index > this->mExpectedIndex) {
+        this->mMissedCount += index - this->mExpectedIndex;
+    }
+
+    uint32_t count = (uint32_t)(length - 4) / 4;
+    if (count == 0) {
+        this->mIsDone = true;
+        return;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        SAMPLE expected = HistoryTransferBench_GetPattern(index + i);
+        int16_t temperature = (int16_t)uint16_decode(&pData[4 + i * 4]);
+        int16_t humidity = (int16_t)uint16_decode(&pData[4 + i * 4 + 2]);
+        if (temperature != expected.mTemperature || humidity != expected.mHumidity) {
+            this->mErrorCount++;
+        }
+    }
+    this->mSampleCount += count;
+    this->mExpectedIndex = index + count;
+}
+
+/**@brief Runs the tasks woken by a SoftDevice event, as the main loop does when the SoftDevice interrupt returns. */
+static void HistoryTransferBench_RunTasks(void) {
+    while (TaskScheduler_RunNext()) {}
+}
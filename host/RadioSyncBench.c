@@ -0,0 +1,201 @@
+#include "RadioSync.h"
+#include "Advertising.h"
+#include "SampleHistory.h"
+#include "TaskScheduler.h"
+#include "TimerWheel.h"
+#include "SoftDeviceSim.h"
+#include "TimerManagerSim.h"
+#include "app_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Runs the sampling with RadioSync against advertising events timed like the link layer does, the interval plus a
+ * random delay of up to 10 ms, and compares the sample-to-air latency with the measurements started at their
+ * deadline and timed from the advertising events. The latency is measured by the driver from the frames sent,
+ * and by RadioSync from the radio notifications.
+ *
+ *   cc -DRADIO_SYNC_ENABLED=1 -Ihost -Ipca10056/s140/config -I. host/RadioSyncBench.c RadioSync.c Advertising.c \
+ *      SampleHistory.c SampleCodec.c BeaconCrypto.c TaskScheduler.c TimerWheel.c host/SoftDeviceSim.c \
+ *      host/TimerManagerSim.c host/Aes128.c -o radio_sync_bench
+ *   ./radio_sync_bench
+ */
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define BENCH_CONN_CFG_TAG          1
+#define BENCH_SAMPLE_COUNT          600
+#define BENCH_ADV_DELAY_MAX_TICKS   APP_TIMER_TICKS(10)
+#define BENCH_MEASURE_TICKS         APP_TIMER_TICKS(17)  /**< SHT31 measurement and the TWI transfers around it. */
+#define BENCH_MEASURE_JITTER_TICKS  APP_TIMER_TICKS(2)
+
+typedef struct {
+    char const *mpName;
+    uint32_t mIntervalMs;
+    RADIO_SYNC_MODE mMode;
+} BenchScenario;
+
+typedef struct
+{
+    uint64_t mNextEventTicks;
+    bool mIsMeasuring;
+    uint32_t mSampleCount;
+    uint64_t mAppliedTicks;
+    uint32_t mAppliedConfigureCount;  // Configure count of the readings applied last.
+    uint32_t mAiredConfigureCount;    // Configure count of the readings on air at the last event.
+    uint32_t mLatencyCount;
+    uint64_t mTotalLatencyTicks;
+    uint64_t mMaxLatencyTicks;
+    uint32_t mAdvEventCount;
+    uint64_t mTotalAgeTicks;
+    uint32_t mRaceCount;              // Readings applied between a radio notification and its event.
+    uint32_t mOverlapCount;           // Measurements requested while one was running.
+} RadioSyncBench;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static void RadioSyncBench_Run(RadioSyncBench *this, BenchScenario const *pScenario);
+static void RadioSyncBench_AdvanceTo(uint64_t timeTicks);
+static void RadioSyncBench_OnDeadline(void *pContext);
+static void RadioSyncBench_Measure(void);
+static void RadioSyncBench_OnReadings(void *pContext);
+static void RadioSyncBench_AdvertisingEvent(RadioSyncBench *this);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static RadioSyncBench radioSyncBench;
+
+static BenchScenario const m_scenarios[] =
+{
+    { "100ms, deadline", 100, RADIO_SYNC_MODE_DEADLINE },
+    { "100ms, aligned",  100, RADIO_SYNC_MODE_ALIGNED },
+    { "250ms, deadline", 250, RADIO_SYNC_MODE_DEADLINE },
+    { "250ms, aligned",  250, RADIO_SYNC_MODE_ALIGNED },
+    { "500ms, deadline", 500, RADIO_SYNC_MODE_DEADLINE },
+    { "500ms, aligned",  500, RADIO_SYNC_MODE_ALIGNED },
+};
+
+int main(void) {
+    for (size_t i = 0; i < sizeof(m_scenarios) / sizeof(m_scenarios[0]); i++) {
+        RadioSyncBench_Run(&radioSyncBench, &m_scenarios[i]);
+    }
+    return 0;
+}
+
+static void RadioSyncBench_Run(RadioSyncBench *this, BenchScenario const *pScenario) {
+    memset(this, 0, sizeof(*this));
+    srand(1);
+
+    // The firmware initialization order of main.c.
+    SoftDeviceSim_Init();
+    TaskScheduler_Init();
+    TimerManager_Init();
+    TimerWheel_Init();
+    SampleHistory_Init();
+    Advertising_Init();
+    Advertising_SetInterval(MSEC_TO_UNITS(pScenario->mIntervalMs, UNIT_0_625_MS));
+    RadioSync_Init(RadioSyncBench_Measure, Advertising_GetInterval());
+    RadioSync_SetMode(pScenario->mMode);
+    Advertising_Start(BENCH_CONN_CFG_TAG);
+    TimerManager_StartPeriodic(RadioSyncBench_OnDeadline, APP_TIMER_TICKS(SAMPLE_INTERVAL_MS), TIMER_MISSED_POLICY_SKIP, this);
+
+    uint64_t intervalTicks = APP_TIMER_TICKS(pScenario->mIntervalMs);
+    uint64_t distanceTicks = TimerManager_UsToTicks(SoftDeviceSim_GetRadioNotificationUs());
+    this->mNextEventTicks = TimerManagerSim_GetTime() + (uint64_t)rand() % intervalTicks;
+    while (this->mSampleCount < BENCH_SAMPLE_COUNT) {
+        RadioSyncBench_AdvanceTo(this->mNextEventTicks - distanceTicks);
+        SoftDeviceSim_RadioNotification();
+        while (TaskScheduler_RunNext()) {}
+
+        RadioSyncBench_AdvanceTo(this->mNextEventTicks);
+        RadioSyncBench_AdvertisingEvent(this);
+        this->mNextEventTicks += intervalTicks + (uint64_t)rand() % (BENCH_ADV_DELAY_MAX_TICKS + 1);
+    }
+
+    RADIO_SYNC_STATS stats;
+    RadioSync_GetStats(&stats);
+    printf("%-16s first air mean=%6uus max=%6uus, age on air mean=%6uus, races=%u overlaps=%u\n", pScenario->mpName,
+           (this->mLatencyCount > 0) ? TimerManager_TicksToUs(this->mTotalLatencyTicks / this->mLatencyCount) : 0,
+           TimerManager_TicksToUs(this->mMaxLatencyTicks),
+           (this->mAdvEventCount > 0) ? TimerManager_TicksToUs(this->mTotalAgeTicks / this->mAdvEventCount) : 0,
+           this->mRaceCount, this->mOverlapCount);
+    printf("%-16s RadioSync mean=%6uus max=%6uus, aligned=%u deadline=%u measure=%uus\n", "", stats.mMeanLatencyUs,
+           stats.mMaxLatencyUs, stats.mAlignedCount, stats.mDeadlineCount, stats.mMeasureUs);
+}
+
+/**@brief Advances the virtual time, running the tasks woken up by every timer on the way. */
+static void RadioSyncBench_AdvanceTo(uint64_t timeTicks) {
+    uint64_t nextTicks;
+    while (TimerManagerSim_GetNextEventTime(&nextTicks) && nextTicks <= timeTicks) {
+        TimerManagerSim_AdvanceToNextEvent();
+        while (TaskScheduler_RunNext()) {}
+    }
+    TimerManagerSim_AdvanceTo(timeTicks);
+}
+
+/**@brief Sampling deadline, what the application task does on APP_EVT_SAMPLE. */
+static void RadioSyncBench_OnDeadline(void *pContext) {
+    (void)pContext;
+    RadioSync_RequestSample();
+}
+
+/**@brief Stands in for SHT31_GetValue, the readings come BENCH_MEASURE_TICKS later. */
+static void RadioSyncBench_Measure(void) {
+    RadioSyncBench *this = &radioSyncBench;
+    if (this->mIsMeasuring) {
+        this->mOverlapCount++;
+        return;
+    }
+
+    this->mIsMeasuring = true;
+    TimerManager_StartOneShot(RadioSyncBench_OnReadings, BENCH_MEASURE_TICKS + (uint32_t)rand() % BENCH_MEASURE_JITTER_TICKS, this);
+}
+
+/**@brief What onSensorDataReceived does, with readings moving enough to leave the deadband every time. */
+static void RadioSyncBench_OnReadings(void *pContext) {
+    RadioSyncBench *this = (RadioSyncBench*)pContext;
+    this->mIsMeasuring = false;
+    this->mSampleCount++;
+
+    int16_t temperature = (int16_t)(2000 + ((this->mSampleCount & 1) ? 50 : 0));
+    int16_t humidity = 5000;
+    SampleHistory_Add(temperature, humidity);
+    bool isApplied = Advertising_SetReadings(temperature, humidity);
+    RadioSync_OnSampleDone(isApplied);
+    if (!isApplied) {
+        return;
+    }
+
+    SOFTDEVICE_SIM_STATS simStats;
+    SoftDeviceSim_GetStats(&simStats);
+    this->mAppliedTicks = TimerManagerSim_GetTime();
+    this->mAppliedConfigureCount = simStats.mConfigureCount;
+    uint64_t distanceTicks = TimerManager_UsToTicks(SoftDeviceSim_GetRadioNotificationUs());
+    if (this->mAppliedTicks + distanceTicks > this->mNextEventTicks) {
+        this->mRaceCount++;
+    }
+}
+
+/**@brief Sends a frame, and measures the time since the readings it carries were applied. */
+static void RadioSyncBench_AdvertisingEvent(RadioSyncBench *this) {
+    if (!SoftDeviceSim_AdvertisingEvent() || this->mAppliedConfigureCount == 0) {
+        return;
+    }
+
+    uint64_t ageTicks = TimerManagerSim_GetTime() - this->mAppliedTicks;
+    this->mAdvEventCount++;
+    this->mTotalAgeTicks += ageTicks;
+    if (this->mAiredConfigureCount == this->mAppliedConfigureCount) {
+        return;
+    }
+
+    this->mAiredConfigureCount = this->mAppliedConfigureCount;
+    this->mLatencyCount++;
+    this->mTotalLatencyTicks += ageTicks;
+    if (ageTicks > this->mMaxLatencyTicks) {
+        this->mMaxLatencyTicks = ageTicks;
+    }
+}
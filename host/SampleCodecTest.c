@@ -0,0 +1,272 @@
+#include "SampleCodec.h"
+#include "Advertising.h"
+#include "BeaconSchema.h"
+#include "SampleHistory.h"
+#include "SoftDeviceSim.h"
+#include "TimerManagerSim.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Tests of SampleCodec, the encoder of the compressed history frame and the decoder the gateway tools use.
+ *
+ * - Known series against their encoding, written out by hand from the layout in SampleCodec.h.
+ * - Round trips of random series with steps from steady to full range, into buffers of every size a frame
+ *   can give: every encoded sample decodes to itself, and nothing is written past the buffer.
+ * - Random and truncated input: the decoder never writes more than maxCount samples.
+ * - Frames sent by Advertising with the compressed history: the service data decodes to the newest samples
+ *   of SampleHistory, and the frames hold as many samples as the codec can fit.
+ *
+ *   cc -DADVERTISING_HISTORY_ENABLED=1 -DADVERTISING_HISTORY_COMPRESSED=1 -Ihost -Ipca10056/s140/config -I. \
+ *      host/SampleCodecTest.c SampleCodec.c Advertising.c SampleHistory.c BeaconCrypto.c host/SoftDeviceSim.c \
+ *      host/TimerManagerSim.c host/Aes128.c -o sample_codec_test
+ *   ./sample_codec_test
+ */
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define TEST_SEED                   1
+#define TEST_ROUND_TRIPS            200000
+#define TEST_MAX_SAMPLES            40
+#define TEST_MAX_SIZE               32
+#define TEST_GUARD                  0xA5
+#define TEST_FRAME_SAMPLES          2000
+#define TEST_CONN_CFG_TAG           1
+#define TEST_MAX_FRAME              255
+
+#define OPEN_SENSOR_SERVICE_UUID    0xFCBE
+#define AD_TYPE_SERVICE_DATA        0x16
+#define TEST_IDENTIFIER_SIZE        4       /**< DEVICE_IDENTIFIER of the DATA_SCHEMA_VERSION frames. */
+
+typedef struct {
+    char const *mpName;
+    SAMPLE mSamples[4];
+    uint32_t mCount;
+    uint8_t mEncoded[9];
+    uint32_t mEncodedCount;
+} TestVector;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static bool SampleCodecTest_Vectors(void);
+static bool SampleCodecTest_RoundTrips(void);
+static bool SampleCodecTest_Malformed(void);
+static bool SampleCodecTest_Frames(void);
+static void SampleCodecTest_RandomSeries(SAMPLE *pSamples, uint32_t count);
+static uint8_t const *SampleCodecTest_FindInfo(uint8_t const *pData, uint16_t length, uint16_t *pInfoLength);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static TestVector const m_vectors[] =
+{
+    // Count, newest sample in full, then zigzag nibbles: +1 -> 2, 0 -> 0, -2 -> 3, +2 -> 4.
+    { "small steps", { { 2000, 5000 }, { 2001, 5000 }, { 1999, 5002 } }, 3,
+      { 0x03, 0x07, 0xD0, 0x13, 0x88, 0x20, 0x34, 0x00, 0x00 }, 3 },
+    // +100 -> zigzag 200 -> groups 0, 1, 3, least significant first, continuation bit on all but the last.
+    { "large step", { { 2000, 5000 }, { 2100, 5000 } }, 2,
+      { 0x02, 0x07, 0xD0, 0x13, 0x88, 0x89, 0x30, 0x00, 0x00 }, 2 },
+    // Negative readings are written as 16-bit two's complement.
+    { "negative", { { -1000, 0 }, { -1000, -1 } }, 2,
+      { 0x02, 0xFC, 0x18, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00 }, 2 },
+    // -32768 to 32767 -> zigzag 131070 -> 6 groups, the longest a difference takes, then 0 for the humidity.
+    { "full range", { { -32768, 0 }, { 32767, 0 } }, 2,
+      { 0x02, 0x80, 0x00, 0x00, 0x00, 0xEF, 0xFF, 0xF3, 0x00 }, 2 },
+};
+
+int main(void) {
+    bool isPassed = true;
+
+    srand(TEST_SEED);
+    isPassed &= SampleCodecTest_Vectors();
+    isPassed &= SampleCodecTest_RoundTrips();
+    isPassed &= SampleCodecTest_Malformed();
+    isPassed &= SampleCodecTest_Frames();
+    return isPassed ? 0 : 1;
+}
+
+static bool SampleCodecTest_Vectors(void) {
+    bool isPassed = true;
+
+    for (size_t i = 0; i < sizeof(m_vectors) / sizeof(m_vectors[0]); i++) {
+        TestVector const *pVector = &m_vectors[i];
+        uint8_t buffer[sizeof(pVector->mEncoded)];
+        SAMPLE decoded[4];
+
+        uint32_t encoded = SampleCodec_Encode(pVector->mSamples, pVector->mCount, buffer, sizeof(buffer));
+        bool isEncoded = (encoded == pVector->mEncodedCount) && (memcmp(buffer, pVector->mEncoded, sizeof(buffer)) == 0);
+        uint32_t count = SampleCodec_Decode(pVector->mEncoded, sizeof(pVector->mEncoded), decoded, 4);
+        bool isDecoded = (count == pVector->mEncodedCount) && (memcmp(decoded, pVector->mSamples, count * sizeof(SAMPLE)) == 0);
+        printf("vector %-12s encode %s decode %s\n", pVector->mpName, isEncoded ? "ok" : "FAILED", isDecoded ? "ok" : "FAILED");
+        isPassed &= isEncoded && isDecoded;
+    }
+    return isPassed;
+}
+
+static bool SampleCodecTest_RoundTrips(void) {
+    uint32_t failureCount = 0;
+    uint32_t overrunCount = 0;
+
+    for (uint32_t i = 0; i < TEST_ROUND_TRIPS; i++) {
+        SAMPLE samples[TEST_MAX_SAMPLES];
+        SAMPLE decoded[TEST_MAX_SAMPLES];
+        uint8_t buffer[TEST_MAX_SIZE + 1];
+        uint32_t count = 1 + (uint32_t)rand() % TEST_MAX_SAMPLES;
+        uint16_t size = (uint16_t)(SAMPLE_CODEC_HEADER_SIZE + (uint32_t)rand() % (TEST_MAX_SIZE - SAMPLE_CODEC_HEADER_SIZE + 1));
+
+        SampleCodecTest_RandomSeries(samples, count);
+        buffer[size] = TEST_GUARD;
+        uint32_t encoded = SampleCodec_Encode(samples, count, buffer, size);
+        if (buffer[size] != TEST_GUARD) {
+            overrunCount++;
+        }
+        uint32_t decodedCount = SampleCodec_Decode(buffer, size, decoded, TEST_MAX_SAMPLES);
+        if (encoded == 0 || encoded > count || decodedCount != encoded ||
+            memcmp(decoded, samples, encoded * sizeof(SAMPLE)) != 0) {
+            failureCount++;
+        }
+    }
+
+    bool isPassed = (failureCount == 0) && (overrunCount == 0);
+    printf("round trips  %u series, failures=%u overruns=%u %s\n", TEST_ROUND_TRIPS, failureCount, overrunCount, isPassed ? "ok" : "FAILED");
+    return isPassed;
+}
+
+static bool SampleCodecTest_Malformed(void) {
+    uint32_t overrunCount = 0;
+    uint32_t truncatedCount = 0;
+
+    for (uint32_t i = 0; i < TEST_ROUND_TRIPS; i++) {
+        SAMPLE decoded[TEST_MAX_SAMPLES + 1];
+        uint8_t buffer[TEST_MAX_SIZE];
+        uint32_t maxCount = 1 + (uint32_t)rand() % TEST_MAX_SAMPLES;
+        uint16_t length = (uint16_t)((uint32_t)rand() % (TEST_MAX_SIZE + 1));
+
+        for (uint16_t j = 0; j < length; j++) {
+            buffer[j] = (uint8_t)rand();
+        }
+        memset(&decoded[maxCount], TEST_GUARD, sizeof(SAMPLE));
+        uint32_t count = SampleCodec_Decode(buffer, length, decoded, maxCount);
+        uint8_t const *pGuard = (uint8_t const*)&decoded[maxCount];
+        for (size_t j = 0; j < sizeof(SAMPLE); j++) {
+            if (pGuard[j] != TEST_GUARD) {
+                overrunCount++;
+                break;
+            }
+        }
+        if (count > maxCount) {
+            overrunCount++;
+        }
+    }
+
+    // A valid encoding cut short must be rejected rather than read past its end.
+    for (uint32_t i = 0; i < TEST_ROUND_TRIPS / 10; i++) {
+        SAMPLE samples[TEST_MAX_SAMPLES];
+        SAMPLE decoded[TEST_MAX_SAMPLES];
+        uint8_t buffer[TEST_MAX_SIZE];
+
+        SampleCodecTest_RandomSeries(samples, TEST_MAX_SAMPLES);
+        uint32_t encoded = SampleCodec_Encode(samples, TEST_MAX_SAMPLES, buffer, TEST_MAX_SIZE);
+        uint16_t length = SAMPLE_CODEC_HEADER_SIZE;
+        while (length < TEST_MAX_SIZE && SampleCodec_Decode(buffer, length, decoded, TEST_MAX_SAMPLES) != encoded) {
+            length++;
+        }
+        if (length > SAMPLE_CODEC_HEADER_SIZE && encoded > 1 && SampleCodec_Decode(buffer, (uint16_t)(length - 1), decoded, TEST_MAX_SAMPLES) != 0) {
+            truncatedCount++;
+        }
+    }
+
+    bool isPassed = (overrunCount == 0) && (truncatedCount == 0);
+    printf("malformed    %u inputs, overruns=%u truncated accepted=%u %s\n", TEST_ROUND_TRIPS, overrunCount, truncatedCount, isPassed ? "ok" : "FAILED");
+    return isPassed;
+}
+
+/**@brief Decodes the frames Advertising sends, as a gateway does, and compares them with the history. */
+static bool SampleCodecTest_Frames(void) {
+    uint32_t frameCount = 0;
+    uint32_t mismatchCount = 0;
+    uint32_t totalSamples = 0;
+    int16_t temperature = 2000;
+    int16_t humidity = 5000;
+
+    SoftDeviceSim_Init();
+    TimerManager_Init();
+    SampleHistory_Init();
+    Advertising_Init();
+    Advertising_Start(TEST_CONN_CFG_TAG);
+
+    for (uint32_t i = 0; i < TEST_FRAME_SAMPLES; i++) {
+        temperature = (int16_t)(temperature + rand() % 21 - 10);
+        humidity = (int16_t)(humidity + rand() % 41 - 20);
+        SampleHistory_Add(temperature, humidity);
+        if (!Advertising_SetReadings(temperature, humidity)) {
+            continue;
+        }
+
+        uint8_t frame[TEST_MAX_FRAME];
+        uint16_t infoLength;
+        SoftDeviceSim_AdvertisingEvent();
+        uint16_t length = SoftDeviceSim_GetFrame(frame);
+        uint8_t const *pInfo = SampleCodecTest_FindInfo(frame, length, &infoLength);
+        uint16_t dataIndex = 1 + TEST_IDENTIFIER_SIZE;
+        if (pInfo == NULL || infoLength <= dataIndex + 2 || pInfo[dataIndex] != DATA_TYPE_HISTORY_COMPRESSED) {
+            mismatchCount++;
+            continue;
+        }
+
+        // The index of the newest sample, then the codec output.
+        SAMPLE decoded[UINT8_MAX];
+        uint32_t count = SampleCodec_Decode(&pInfo[dataIndex + 2], (uint16_t)(infoLength - dataIndex - 2), decoded, UINT8_MAX);
+        bool isMatch = (count > 0) && (pInfo[dataIndex + 1] == (uint8_t)(SampleHistory_GetTotal() - 1));
+        for (uint32_t age = 0; isMatch && age < count; age++) {
+            SAMPLE sample;
+            isMatch = SampleHistory_Get(age, &sample) && (memcmp(&sample, &decoded[age], sizeof(SAMPLE)) == 0);
+        }
+        if (!isMatch) {
+            mismatchCount++;
+        }
+        frameCount++;
+        totalSamples += count;
+    }
+
+    bool isPassed = (frameCount > 0) && (mismatchCount == 0);
+    printf("frames       %u frames, %.1f samples per frame, mismatches=%u %s\n", frameCount,
+           (frameCount > 0) ? (double)totalSamples / frameCount : 0.0, mismatchCount, isPassed ? "ok" : "FAILED");
+    return isPassed;
+}
+
+/**@brief Series of one of four kinds: steady, small steps, large steps or any value. */
+static void SampleCodecTest_RandomSeries(SAMPLE *pSamples, uint32_t count) {
+    static int32_t const steps[] = { 1, 10, 300, 0 };
+    int32_t step = steps[rand() % 4];
+
+    pSamples[0].mTemperature = (int16_t)rand();
+    pSamples[0].mHumidity = (int16_t)rand();
+    for (uint32_t i = 1; i < count; i++) {
+        if (step == 0) {
+            pSamples[i].mTemperature = (int16_t)rand();
+            pSamples[i].mHumidity = (int16_t)rand();
+        } else {
+            pSamples[i].mTemperature = (int16_t)(pSamples[i - 1].mTemperature + rand() % (2 * step + 1) - step);
+            pSamples[i].mHumidity = (int16_t)(pSamples[i - 1].mHumidity + rand() % (2 * step + 1) - step);
+        }
+    }
+}
+
+/**@brief Finds the Open Sensor service data, and returns it from the schema version on. */
+static uint8_t const *SampleCodecTest_FindInfo(uint8_t const *pData, uint16_t length, uint16_t *pInfoLength) {
+    uint16_t offset = 0;
+    while (offset + 2 <= length && pData[offset] != 0) {
+        uint8_t fieldLength = pData[offset];
+        if (pData[offset + 1] == AD_TYPE_SERVICE_DATA && fieldLength > 3 &&
+            (pData[offset + 2] | (pData[offset + 3] << 8)) == OPEN_SENSOR_SERVICE_UUID) {
+            *pInfoLength = (uint16_t)(fieldLength - 3);
+            return &pData[offset + 4];
+        }
+        offset += fieldLength + 1;
+    }
+    return NULL;
+}
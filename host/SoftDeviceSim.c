@@ -0,0 +1,973 @@
+#include "SoftDeviceSim.h"
+#include "ble_advdata.h"
+#include "app_util.h"
+#include "ble_hci.h"
+#include "ble_srv_common.h"
+#include "nrf_sdh_ble.h"
+#include "nrf_soc.h"
+#include "nrf_nvic.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define SOFTDEVICE_SIM_ADV_HANDLE 0
+#define SOFTDEVICE_SIM_CONN_HANDLE 0
+#define SOFTDEVICE_SIM_MAX_OBSERVERS 8
+#define SOFTDEVICE_SIM_MAX_CHARACTERISTICS 8
+#define SOFTDEVICE_SIM_MAX_VALUE_SIZE 256
+#define SOFTDEVICE_SIM_MAX_HVN_QUEUE_SIZE 32
+#define SOFTDEVICE_SIM_EVENT_LENGTH_DEFAULT 3      /**< BLE_GAP_EVENT_LENGTH_DEFAULT, 3.75 ms. */
+#define SOFTDEVICE_SIM_SUPERVISION_TIMEOUT 400     /**< 4 s in 10 ms units. */
+#define SOFTDEVICE_SIM_IFS_US 150                  /**< Inter frame space between a packet and its response. */
+#define SOFTDEVICE_SIM_L2CAP_ATT_HEADER_SIZE 7     /**< L2CAP length and channel, ATT opcode and handle. */
+
+typedef struct
+{
+    nrf_sdh_ble_evt_handler_t mHandler;
+    void *mpContext;
+    uint8_t mPriority;
+} SoftDeviceSimObserver;
+
+typedef struct
+{
+    ble_uuid_t mUuid;
+    ble_gatts_char_handles_t mHandles;
+    uint8_t mValue[SOFTDEVICE_SIM_MAX_VALUE_SIZE];
+    uint16_t mLength;
+    bool mIsNotifying;  // Written by the central to the CCCD.
+} SoftDeviceSimCharacteristic;
+
+typedef struct
+{
+    uint16_t mHandle;
+    uint16_t mLength;
+    uint8_t mData[SOFTDEVICE_SIM_MAX_VALUE_SIZE];
+} SoftDeviceSimNotification;
+
+/** Event with room for the data of a write. */
+typedef union
+{
+    ble_evt_t mEvt;
+    uint8_t mRaw[sizeof(ble_evt_t) + SOFTDEVICE_SIM_MAX_VALUE_SIZE];
+} SoftDeviceSimEvt;
+
+typedef struct
+{
+    bool mConfigured;
+    bool mAdvertising;
+    ble_gap_adv_params_t mAdvParams;
+    ble_data_t mAdvData;                                    // Buffer in use, owned by the application.
+    ble_data_t mScanRspData;
+    uint8_t mHandedOver[BLE_GAP_ADV_SET_DATA_SIZE_EXTENDED_MAX_SUPPORTED];  // Content of that buffer when it was configured.
+    uint8_t mLastFrame[BLE_GAP_ADV_SET_DATA_SIZE_EXTENDED_MAX_SUPPORTED];
+    uint16_t mLastFrameLength;
+    uint32_t mFailNextConfigure;
+    uint32_t mConfigureCount;
+    uint32_t mRejectedCount;
+    uint32_t mAdvEventCount;
+    uint32_t mScanRequestCount;
+    uint32_t mTornFrameCount;
+    uint32_t mRandomState;
+    uint8_t mRadioNotificationType;
+    uint8_t mRadioNotificationDistance;
+    bool mIsRadioIrqEnabled;
+
+    // Stack configuration and attribute table.
+    uint8_t mHvnQueueSize;
+    uint16_t mEventLength;
+    uint16_t mMaxAttMtu;
+    bool mIsEventExtended;
+    uint8_t mVsUuidCount;
+    uint16_t mNextHandle;
+    SoftDeviceSimCharacteristic mCharacteristics[SOFTDEVICE_SIM_MAX_CHARACTERISTICS];
+    uint8_t mCharacteristicCount;
+
+    // Link, and the procedures the firmware started on it, completed by the next connection event.
+    SOFTDEVICE_SIM_CENTRAL mCentral;
+    SOFTDEVICE_SIM_NOTIFICATION_HANDLER *mpNotificationHandler;
+    SOFTDEVICE_SIM_EVENT_HOOK *mpEventHook;
+    bool mConnected;
+    uint16_t mInterval;
+    uint16_t mAttMtu;
+    uint16_t mDataLength;
+    uint8_t mPhy;
+    bool mIsMtuExchanged;
+    uint16_t mPendingMtu;
+    uint16_t mPendingDataLength;
+    uint8_t mPendingPhys;
+    bool mIsParamsPending;
+    ble_gap_conn_params_t mPendingParams;
+    bool mIsDisconnectPending;
+    SoftDeviceSimNotification mQueue[SOFTDEVICE_SIM_MAX_HVN_QUEUE_SIZE];
+    uint8_t mQueueHead;
+    uint8_t mQueueCount;
+    uint32_t mConnEventCount;
+    uint32_t mNotificationCount;
+} SoftDeviceSim;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static uint32_t SoftDeviceSim_Reject(SoftDeviceSim *this, uint32_t errCode);
+static uint16_t SoftDeviceSim_GetMaxDataLength(ble_gap_adv_params_t const *pParams);
+static void SoftDeviceSim_Dispatch(SoftDeviceSim *this, ble_evt_t const *pEvt);
+static void SoftDeviceSim_DispatchGap(SoftDeviceSim *this, uint16_t evtId, ble_gap_evt_t const *pGapEvt);
+static void SoftDeviceSim_RunProcedures(SoftDeviceSim *this);
+static void SoftDeviceSim_Drop(SoftDeviceSim *this, uint8_t reason);
+static SoftDeviceSimCharacteristic* SoftDeviceSim_FindHandle(SoftDeviceSim *this, uint16_t handle);
+static uint32_t SoftDeviceSim_GetNotificationUs(SoftDeviceSim *this, uint16_t length);
+static uint32_t SoftDeviceSim_GetPacketUs(uint8_t phy, uint16_t payloadSize);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static SoftDeviceSim softDeviceSim;
+
+// Registered before main runs, so not cleared by SoftDeviceSim_Init.
+static SoftDeviceSimObserver m_observers[SOFTDEVICE_SIM_MAX_OBSERVERS];
+static uint8_t m_observer_count;
+
+static SOFTDEVICE_SIM_CENTRAL const m_default_central =
+{
+    .mInterval   = 24,  // 30 ms, what phones usually pick.
+    .mAttMtu     = BLE_GATT_ATT_MTU_DEFAULT,
+    .mDataLength = BLE_GAP_DATA_LENGTH_DEFAULT,
+    .mPhys       = BLE_GAP_PHY_1MBPS,
+};
+
+/** Time from the notification to the radio event for each NRF_RADIO_NOTIFICATION_DISTANCE. */
+static uint16_t const m_radio_notification_us[] = { 0, 800, 1740, 2680, 3620, 4560, 5500 };
+
+/**@brief Resets the advertising set, the configuration, the attribute table and the link. Observers are kept. */
+void SoftDeviceSim_Init(void) {
+    memset(&softDeviceSim, 0, sizeof(softDeviceSim));
+    softDeviceSim.mHvnQueueSize = 1;
+    softDeviceSim.mEventLength = SOFTDEVICE_SIM_EVENT_LENGTH_DEFAULT;
+    softDeviceSim.mMaxAttMtu = BLE_GATT_ATT_MTU_DEFAULT;
+    softDeviceSim.mNextHandle = 1;
+    softDeviceSim.mCentral = m_default_central;
+}
+
+/**@brief Registers an event handler, called by NRF_SDH_BLE_OBSERVER. A lower priority value is called first. */
+void SoftDeviceSim_AddObserver(uint8_t priority, nrf_sdh_ble_evt_handler_t handler, void *pContext) {
+    if (m_observer_count >= SOFTDEVICE_SIM_MAX_OBSERVERS) {
+        printf("%s(%d) Too many observers\n", __func__, __LINE__);
+        abort();
+    }
+
+    // Insertion sort, observers of the same priority keep their registration order.
+    uint8_t index = m_observer_count++;
+    while (index > 0 && m_observers[index - 1].mPriority > priority) {
+        m_observers[index] = m_observers[index - 1];
+        index--;
+    }
+    m_observers[index].mHandler = handler;
+    m_observers[index].mpContext = pContext;
+    m_observers[index].mPriority = priority;
+}
+
+/**@brief Sends one frame from the buffer in use.
+ *
+ * @retval true  A frame was sent.
+ * @retval false Advertising is not running.
+ */
+bool SoftDeviceSim_AdvertisingEvent(void) {
+    SoftDeviceSim *this = &softDeviceSim;
+    if (!this->mAdvertising) {
+        return false;
+    }
+
+    this->mAdvEventCount++;
+    this->mLastFrameLength = this->mAdvData.len;
+    memcpy(this->mLastFrame, this->mAdvData.p_data, this->mAdvData.len);
+    if (memcmp(this->mLastFrame, this->mHandedOver, this->mLastFrameLength) != 0) {
+        this->mTornFrameCount++;
+    }
+    return true;
+}
+
+/**@brief Answers a scan request with the scan response in use.
+ *
+ * @return Length of the scan response copied to pBuffer, 0 if the set is not advertising or not scannable.
+ */
+uint16_t SoftDeviceSim_ScanRequest(uint8_t *pBuffer) {
+    SoftDeviceSim *this = &softDeviceSim;
+    if (!this->mAdvertising || (this->mAdvParams.properties.type != BLE_GAP_ADV_TYPE_NONCONNECTABLE_SCANNABLE_UNDIRECTED &&
+                                this->mAdvParams.properties.type != BLE_GAP_ADV_TYPE_CONNECTABLE_SCANNABLE_UNDIRECTED)) {
+        return 0;
+    }
+
+    this->mScanRequestCount++;
+    memcpy(pBuffer, this->mScanRspData.p_data, this->mScanRspData.len);
+    return this->mScanRspData.len;
+}
+
+/**@brief Accepts a connection request, which stops advertising like the SoftDevice does with a single link.
+ *
+ * @retval true  The set was advertising and connectable.
+ * @retval false Nothing happened.
+ */
+bool SoftDeviceSim_Connect(void) {
+    SoftDeviceSim *this = &softDeviceSim;
+    if (!this->mAdvertising || (this->mAdvParams.properties.type != BLE_GAP_ADV_TYPE_CONNECTABLE_SCANNABLE_UNDIRECTED &&
+                                this->mAdvParams.properties.type != BLE_GAP_ADV_TYPE_EXTENDED_CONNECTABLE_NONSCANNABLE_UNDIRECTED)) {
+        return false;
+    }
+
+    this->mAdvertising = false;
+    this->mConnected = true;
+    this->mInterval = this->mCentral.mInterval;
+    this->mAttMtu = BLE_GATT_ATT_MTU_DEFAULT;
+    this->mDataLength = BLE_GAP_DATA_LENGTH_DEFAULT;
+    this->mPhy = BLE_GAP_PHY_1MBPS;
+
+    ble_gap_evt_t gapEvt;
+    memset(&gapEvt, 0, sizeof(gapEvt));
+    gapEvt.params.connected.conn_params.min_conn_interval = this->mInterval;
+    gapEvt.params.connected.conn_params.max_conn_interval = this->mInterval;
+    gapEvt.params.connected.conn_params.conn_sup_timeout = SOFTDEVICE_SIM_SUPERVISION_TIMEOUT;
+    gapEvt.params.connected.adv_handle = SOFTDEVICE_SIM_ADV_HANDLE;
+    SoftDeviceSim_DispatchGap(this, BLE_GAP_EVT_CONNECTED, &gapEvt);
+    return true;
+}
+
+/**@brief Sets what the central connecting next supports. The default is a BLE 4.0 central at 30 ms. */
+void SoftDeviceSim_SetCentral(SOFTDEVICE_SIM_CENTRAL const *pCentral) {
+    softDeviceSim.mCentral = *pCentral;
+}
+
+void SoftDeviceSim_SetNotificationHandler(SOFTDEVICE_SIM_NOTIFICATION_HANDLER *pHandler) {
+    softDeviceSim.mpNotificationHandler = pHandler;
+}
+
+void SoftDeviceSim_SetEventHook(SOFTDEVICE_SIM_EVENT_HOOK *pHook) {
+    softDeviceSim.mpEventHook = pHook;
+}
+
+/**@brief Stands in for service discovery: looks up the handles of a characteristic by UUID. */
+bool SoftDeviceSim_FindCharacteristic(uint8_t uuidType, uint16_t uuid, ble_gatts_char_handles_t *pHandles) {
+    for (uint8_t i = 0; i < softDeviceSim.mCharacteristicCount; i++) {
+        SoftDeviceSimCharacteristic *pCharacteristic = &softDeviceSim.mCharacteristics[i];
+        if (pCharacteristic->mUuid.type == uuidType && pCharacteristic->mUuid.uuid == uuid) {
+            *pHandles = pCharacteristic->mHandles;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**@brief Writes a value or a CCCD as the central, and dispatches BLE_GATTS_EVT_WRITE.
+ *
+ * @retval true  The write was accepted.
+ * @retval false Not connected, unknown handle or longer than the MTU allows.
+ */
+bool SoftDeviceSim_Write(uint16_t handle, uint8_t const *pData, uint16_t length) {
+    SoftDeviceSim *this = &softDeviceSim;
+    SoftDeviceSimCharacteristic *pCharacteristic = SoftDeviceSim_FindHandle(this, handle);
+    if (!this->mConnected || pCharacteristic == NULL || length > this->mAttMtu - 3) {
+        return false;
+    }
+
+    if (handle == pCharacteristic->mHandles.cccd_handle) {
+        if (length != BLE_CCCD_VALUE_LEN) {
+            return false;
+        }
+        pCharacteristic->mIsNotifying = ble_srv_is_notification_enabled(pData);
+    } else {
+        memcpy(pCharacteristic->mValue, pData, length);
+        pCharacteristic->mLength = length;
+    }
+
+    SoftDeviceSimEvt evt;
+    memset(&evt, 0, sizeof(evt));
+    evt.mEvt.header.evt_id = BLE_GATTS_EVT_WRITE;
+    evt.mEvt.evt.gatts_evt.conn_handle = SOFTDEVICE_SIM_CONN_HANDLE;
+    evt.mEvt.evt.gatts_evt.params.write.handle = handle;
+    evt.mEvt.evt.gatts_evt.params.write.uuid = pCharacteristic->mUuid;
+    evt.mEvt.evt.gatts_evt.params.write.len = length;
+    memcpy(evt.mEvt.evt.gatts_evt.params.write.data, pData, length);
+    SoftDeviceSim_Dispatch(this, &evt.mEvt);
+    return true;
+}
+
+/**@brief Runs one connection event.
+ *
+ * @details The procedures started since the previous event complete first. Notifications are then sent in
+ *          order until the queue is empty or the next one would not end before the event does. The event lasts
+ *          the configured event length, or the whole interval with the event length extension enabled.
+ *
+ * @return Air time used in us, 0 if not connected.
+ */
+uint32_t SoftDeviceSim_ConnectionEvent(void) {
+    SoftDeviceSim *this = &softDeviceSim;
+    if (!this->mConnected) {
+        return 0;
+    }
+
+    this->mConnEventCount++;
+    SoftDeviceSim_RunProcedures(this);
+    if (!this->mConnected) {
+        return 0;
+    }
+
+    uint32_t intervalUs = (uint32_t)this->mInterval * 1250;
+    uint32_t eventUs = this->mIsEventExtended ? intervalUs : MIN((uint32_t)this->mEventLength * 1250, intervalUs);
+    uint32_t usedUs = 0;
+    while (this->mQueueCount > 0 && this->mConnected) {
+        SoftDeviceSimNotification *pNotification = &this->mQueue[this->mQueueHead];
+        uint32_t notificationUs = SoftDeviceSim_GetNotificationUs(this, pNotification->mLength);
+        if (usedUs + notificationUs > eventUs) {
+            break;
+        }
+
+        usedUs += notificationUs;
+        this->mQueueHead = (uint8_t)((this->mQueueHead + 1) % SOFTDEVICE_SIM_MAX_HVN_QUEUE_SIZE);
+        this->mQueueCount--;
+        this->mNotificationCount++;
+        if (this->mpNotificationHandler) {
+            this->mpNotificationHandler(pNotification->mHandle, pNotification->mData, pNotification->mLength);
+        }
+
+        ble_evt_t evt;
+        memset(&evt, 0, sizeof(evt));
+        evt.header.evt_id = BLE_GATTS_EVT_HVN_TX_COMPLETE;
+        evt.evt.gatts_evt.conn_handle = SOFTDEVICE_SIM_CONN_HANDLE;
+        evt.evt.gatts_evt.params.hvn_tx_complete.count = 1;
+        SoftDeviceSim_Dispatch(this, &evt);
+    }
+    if (usedUs == 0) {
+        // An event without data still exchanges a pair of empty packets.
+        usedUs = 2 * SoftDeviceSim_GetPacketUs(this->mPhy, 0) + SOFTDEVICE_SIM_IFS_US;
+    }
+    return usedUs;
+}
+
+/**@brief Drops the link as the central or the radio would, and dispatches BLE_GAP_EVT_DISCONNECTED.
+ *
+ * @retval true  The link was up.
+ * @retval false Not connected.
+ */
+bool SoftDeviceSim_Disconnect(uint8_t reason) {
+    if (!softDeviceSim.mConnected) {
+        return false;
+    }
+
+    SoftDeviceSim_Drop(&softDeviceSim, reason);
+    return true;
+}
+
+/**@brief Time from the radio notification to the radio event it announces, 0 if no interrupt is raised ahead of them. */
+uint32_t SoftDeviceSim_GetRadioNotificationUs(void) {
+    SoftDeviceSim *this = &softDeviceSim;
+    if (!this->mIsRadioIrqEnabled || (this->mRadioNotificationType != NRF_RADIO_NOTIFICATION_TYPE_INT_ON_ACTIVE &&
+                                      this->mRadioNotificationType != NRF_RADIO_NOTIFICATION_TYPE_INT_ON_BOTH)) {
+        return 0;
+    }
+    return m_radio_notification_us[this->mRadioNotificationDistance];
+}
+
+/**@brief Raises the radio notification interrupt, the driver calls it SoftDeviceSim_GetRadioNotificationUs ahead
+ *        of every radio event.
+ *
+ * @retval true  The interrupt handler ran.
+ * @retval false The notification is not enabled.
+ */
+bool SoftDeviceSim_RadioNotification(void) {
+    if (SoftDeviceSim_GetRadioNotificationUs() == 0) {
+        return false;
+    }
+    RADIO_NOTIFICATION_IRQHandler();
+    return true;
+}
+
+/**@brief Copies the last frame sent and returns its length. */
+uint16_t SoftDeviceSim_GetFrame(uint8_t *pBuffer) {
+    memcpy(pBuffer, softDeviceSim.mLastFrame, softDeviceSim.mLastFrameLength);
+    return softDeviceSim.mLastFrameLength;
+}
+
+/**@brief Advertising interval in 0.625 ms units, 0 while not advertising. */
+uint32_t SoftDeviceSim_GetInterval(void) {
+    return softDeviceSim.mAdvertising ? softDeviceSim.mAdvParams.interval : 0;
+}
+
+/**@brief Makes the next sd_ble_gap_adv_set_configure call fail with errCode. */
+void SoftDeviceSim_FailNextConfigure(uint32_t errCode) {
+    softDeviceSim.mFailNextConfigure = errCode;
+}
+
+void SoftDeviceSim_GetStats(SOFTDEVICE_SIM_STATS *pStats) {
+    pStats->mConfigureCount = softDeviceSim.mConfigureCount;
+    pStats->mRejectedCount = softDeviceSim.mRejectedCount;
+    pStats->mAdvEventCount = softDeviceSim.mAdvEventCount;
+    pStats->mScanRequestCount = softDeviceSim.mScanRequestCount;
+    pStats->mTornFrameCount = softDeviceSim.mTornFrameCount;
+    pStats->mConnEventCount = softDeviceSim.mConnEventCount;
+    pStats->mNotificationCount = softDeviceSim.mNotificationCount;
+}
+
+uint32_t sd_ble_gap_adv_set_configure(uint8_t *p_adv_handle, ble_gap_adv_data_t const *p_adv_data, ble_gap_adv_params_t const *p_adv_params) {
+    SoftDeviceSim *this = &softDeviceSim;
+
+    if (this->mFailNextConfigure != NRF_SUCCESS) {
+        uint32_t errCode = this->mFailNextConfigure;
+        this->mFailNextConfigure = NRF_SUCCESS;
+        return SoftDeviceSim_Reject(this, errCode);
+    }
+    if (*p_adv_handle == BLE_GAP_ADV_SET_HANDLE_NOT_SET) {
+        if (this->mConfigured || p_adv_params == NULL) {
+            return SoftDeviceSim_Reject(this, NRF_ERROR_INVALID_PARAM);
+        }
+        *p_adv_handle = SOFTDEVICE_SIM_ADV_HANDLE;
+    } else if (*p_adv_handle != SOFTDEVICE_SIM_ADV_HANDLE || !this->mConfigured) {
+        return SoftDeviceSim_Reject(this, NRF_ERROR_INVALID_PARAM);
+    }
+    if (this->mAdvertising && p_adv_params != NULL) {
+        return SoftDeviceSim_Reject(this, NRF_ERROR_INVALID_STATE);
+    }
+    if (p_adv_params != NULL && SoftDeviceSim_GetMaxDataLength(p_adv_params) == 0) {
+        return SoftDeviceSim_Reject(this, NRF_ERROR_INVALID_PARAM);
+    }
+    // Channels 37 to 39 are the top bits of the last byte of the mask, one of them must stay in use.
+    if (p_adv_params != NULL && (p_adv_params->channel_mask[4] & 0xE0) == 0xE0) {
+        return SoftDeviceSim_Reject(this, NRF_ERROR_INVALID_PARAM);
+    }
+    if (p_adv_data != NULL) {
+        if (p_adv_data->adv_data.len > SoftDeviceSim_GetMaxDataLength((p_adv_params != NULL) ? p_adv_params : &this->mAdvParams)) {
+            return SoftDeviceSim_Reject(this, NRF_ERROR_INVALID_LENGTH);
+        }
+        if (p_adv_data->scan_rsp_data.len > BLE_GAP_ADV_SET_DATA_SIZE_MAX) {
+            return SoftDeviceSim_Reject(this, NRF_ERROR_INVALID_LENGTH);
+        }
+        // The SoftDevice requires new buffers while advertising, it reads the old ones until the switch.
+        if (this->mAdvertising && (p_adv_data->adv_data.p_data == this->mAdvData.p_data ||
+                                   (p_adv_data->scan_rsp_data.len > 0 && p_adv_data->scan_rsp_data.p_data == this->mScanRspData.p_data))) {
+            return SoftDeviceSim_Reject(this, NRF_ERROR_INVALID_STATE);
+        }
+        this->mAdvData = p_adv_data->adv_data;
+        this->mScanRspData = p_adv_data->scan_rsp_data;
+        memcpy(this->mHandedOver, this->mAdvData.p_data, this->mAdvData.len);
+    }
+    if (p_adv_params != NULL) {
+        this->mAdvParams = *p_adv_params;
+    }
+
+    this->mConfigured = true;
+    this->mConfigureCount++;
+    return NRF_SUCCESS;
+}
+
+/**@brief Like the SoftDevice, only accepts the configuration while the radio is idle. */
+uint32_t sd_radio_notification_cfg_set(uint8_t type, uint8_t distance) {
+    SoftDeviceSim *this = &softDeviceSim;
+    if (type > NRF_RADIO_NOTIFICATION_TYPE_INT_ON_BOTH || distance > NRF_RADIO_NOTIFICATION_DISTANCE_5500US) {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    if (this->mAdvertising || this->mConnected) {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    this->mRadioNotificationType = type;
+    this->mRadioNotificationDistance = distance;
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_nvic_ClearPendingIRQ(IRQn_Type IRQn) {
+    (void)IRQn;
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_nvic_SetPriority(IRQn_Type IRQn, uint32_t priority) {
+    (void)IRQn;
+    (void)priority;
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_nvic_EnableIRQ(IRQn_Type IRQn) {
+    if (IRQn == RADIO_NOTIFICATION_IRQn) {
+        softDeviceSim.mIsRadioIrqEnabled = true;
+    }
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_nvic_DisableIRQ(IRQn_Type IRQn) {
+    if (IRQn == RADIO_NOTIFICATION_IRQn) {
+        softDeviceSim.mIsRadioIrqEnabled = false;
+    }
+    return NRF_SUCCESS;
+}
+
+/**@brief Default handler, like the weak one of the vector table, for drivers linking no firmware that uses it. */
+__attribute__((weak)) void RADIO_NOTIFICATION_IRQHandler(void) {
+}
+
+/**@brief Deterministic stand-in for the random number generator, so that runs are repeatable. */
+uint32_t sd_rand_application_bytes_available_get(uint8_t *p_bytes_available) {
+    *p_bytes_available = UINT8_MAX;
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_rand_application_vector_get(uint8_t *p_buff, uint8_t length) {
+    for (uint8_t i = 0; i < length; i++) {
+        softDeviceSim.mRandomState = softDeviceSim.mRandomState * 1664525 + 1013904223;
+        p_buff[i] = (uint8_t)(softDeviceSim.mRandomState >> 24);
+    }
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_ble_gap_adv_start(uint8_t adv_handle, uint8_t conn_cfg_tag) {
+    (void)conn_cfg_tag;
+    if (adv_handle != SOFTDEVICE_SIM_ADV_HANDLE || !softDeviceSim.mConfigured) {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    if (softDeviceSim.mAdvertising) {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    softDeviceSim.mAdvertising = true;
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_ble_gap_adv_stop(uint8_t adv_handle) {
+    if (adv_handle != SOFTDEVICE_SIM_ADV_HANDLE) {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    if (!softDeviceSim.mAdvertising) {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    softDeviceSim.mAdvertising = false;
+    return NRF_SUCCESS;
+}
+
+/**@brief Accepts the powers of the S140 on the nRF52840, for the advertising set once configured. */
+uint32_t sd_ble_gap_tx_power_set(uint8_t role, uint16_t handle, int8_t tx_power) {
+    static int8_t const powers[] = { -40, -20, -16, -12, -8, -4, 0, 2, 3, 4, 5, 6, 7, 8 };
+    if (role != BLE_GAP_TX_POWER_ROLE_ADV || handle != SOFTDEVICE_SIM_ADV_HANDLE || !softDeviceSim.mConfigured) {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    for (size_t i = 0; i < sizeof(powers) / sizeof(powers[0]); i++) {
+        if (powers[i] == tx_power) {
+            return NRF_SUCCESS;
+        }
+    }
+    return NRF_ERROR_INVALID_PARAM;
+}
+
+/**@brief Encodes flags and 16-bit UUID service data, the only fields the firmware uses. */
+ret_code_t ble_advdata_encode(ble_advdata_t const *p_advdata, uint8_t *p_encoded_data, uint16_t *p_len) {
+    uint16_t maxLength = *p_len;
+    uint16_t offset = 0;
+
+    if (p_advdata->flags != 0) {
+        if (offset + 3 > maxLength) {
+            return NRF_ERROR_DATA_SIZE;
+        }
+        p_encoded_data[offset++] = 2;
+        p_encoded_data[offset++] = BLE_GAP_AD_TYPE_FLAGS;
+        p_encoded_data[offset++] = p_advdata->flags;
+    }
+
+    for (uint8_t i = 0; i < p_advdata->service_data_count; i++) {
+        ble_advdata_service_data_t const *pServiceData = &p_advdata->p_service_data_array[i];
+        uint16_t fieldLength = 1 + 2 + pServiceData->data.size;
+        if (offset + 1 + fieldLength > maxLength) {
+            return NRF_ERROR_DATA_SIZE;
+        }
+        p_encoded_data[offset++] = (uint8_t)fieldLength;
+        p_encoded_data[offset++] = BLE_GAP_AD_TYPE_SERVICE_DATA;
+        p_encoded_data[offset++] = (uint8_t)(pServiceData->service_uuid & 0xFF);
+        p_encoded_data[offset++] = (uint8_t)(pServiceData->service_uuid >> 8);
+        memcpy(&p_encoded_data[offset], pServiceData->data.p_data, pServiceData->data.size);
+        offset += pServiceData->data.size;
+    }
+
+    *p_len = offset;
+    return NRF_SUCCESS;
+}
+
+/**@brief Applies the SoftDevice handler configuration of sdk_config.h, like the SDK function does. */
+ret_code_t nrf_sdh_ble_default_cfg_set(uint8_t conn_cfg_tag, uint32_t *p_ram_start) {
+    (void)conn_cfg_tag;
+    softDeviceSim.mEventLength = NRF_SDH_BLE_GAP_EVENT_LENGTH;
+    softDeviceSim.mMaxAttMtu = NRF_SDH_BLE_GATT_MAX_MTU_SIZE;
+    *p_ram_start = 0;
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_ble_cfg_set(uint32_t cfg_id, ble_cfg_t const *p_cfg, uint32_t app_ram_base) {
+    (void)app_ram_base;
+    switch (cfg_id)
+    {
+    case BLE_CONN_CFG_GAP:
+        softDeviceSim.mEventLength = p_cfg->conn_cfg.params.gap_conn_cfg.event_length;
+        return NRF_SUCCESS;
+
+    case BLE_CONN_CFG_GATT:
+        softDeviceSim.mMaxAttMtu = p_cfg->conn_cfg.params.gatt_conn_cfg.att_mtu;
+        return NRF_SUCCESS;
+
+    case BLE_CONN_CFG_GATTS:
+        if (p_cfg->conn_cfg.params.gatts_conn_cfg.hvn_tx_queue_size > SOFTDEVICE_SIM_MAX_HVN_QUEUE_SIZE) {
+            return NRF_ERROR_INVALID_PARAM;
+        }
+        softDeviceSim.mHvnQueueSize = p_cfg->conn_cfg.params.gatts_conn_cfg.hvn_tx_queue_size;
+        return NRF_SUCCESS;
+
+    default:
+        return NRF_ERROR_INVALID_PARAM;
+    }
+}
+
+uint32_t sd_ble_opt_set(uint32_t opt_id, ble_opt_t const *p_opt) {
+    if (opt_id != BLE_COMMON_OPT_CONN_EVT_EXT) {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    softDeviceSim.mIsEventExtended = p_opt->common_opt.conn_evt_ext.enable;
+    return NRF_SUCCESS;
+}
+
+/**@brief Fails like the SoftDevice when NRF_SDH_BLE_VS_UUID_COUNT does not leave room for the base. */
+uint32_t sd_ble_uuid_vs_add(ble_uuid128_t const *p_vs_uuid, uint8_t *p_uuid_type) {
+    (void)p_vs_uuid;
+    if (softDeviceSim.mVsUuidCount + 1 > NRF_SDH_BLE_VS_UUID_COUNT) {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    *p_uuid_type = (uint8_t)(BLE_UUID_TYPE_VENDOR_BEGIN + softDeviceSim.mVsUuidCount++);
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_ble_gatts_service_add(uint8_t type, ble_uuid_t const *p_uuid, uint16_t *p_handle) {
+    (void)type;
+    (void)p_uuid;
+    *p_handle = softDeviceSim.mNextHandle++;
+    return NRF_SUCCESS;
+}
+
+/**@brief Allocates the declaration, value and CCCD handles of a characteristic, like the SDK function does. */
+uint32_t characteristic_add(uint16_t service_handle, ble_add_char_params_t *p_char_props, ble_gatts_char_handles_t *p_char_handle) {
+    SoftDeviceSim *this = &softDeviceSim;
+    (void)service_handle;
+    if (this->mCharacteristicCount >= SOFTDEVICE_SIM_MAX_CHARACTERISTICS || p_char_props->max_len > SOFTDEVICE_SIM_MAX_VALUE_SIZE) {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    SoftDeviceSimCharacteristic *pCharacteristic = &this->mCharacteristics[this->mCharacteristicCount++];
+    memset(pCharacteristic, 0, sizeof(*pCharacteristic));
+    pCharacteristic->mUuid.uuid = p_char_props->uuid;
+    pCharacteristic->mUuid.type = p_char_props->uuid_type;
+    this->mNextHandle++;  // Declaration.
+    pCharacteristic->mHandles.value_handle = this->mNextHandle++;
+    if (p_char_props->char_props.notify || p_char_props->char_props.indicate) {
+        pCharacteristic->mHandles.cccd_handle = this->mNextHandle++;
+    }
+    if (p_char_props->p_init_value != NULL) {
+        memcpy(pCharacteristic->mValue, p_char_props->p_init_value, p_char_props->init_len);
+        pCharacteristic->mLength = p_char_props->init_len;
+    }
+    *p_char_handle = pCharacteristic->mHandles;
+    return NRF_SUCCESS;
+}
+
+bool ble_srv_is_notification_enabled(uint8_t const *p_encoded_data) {
+    return (uint16_decode(p_encoded_data) & 0x0001) != 0;
+}
+
+uint32_t sd_ble_gatts_value_set(uint16_t conn_handle, uint16_t handle, ble_gatts_value_t *p_value) {
+    (void)conn_handle;
+    SoftDeviceSimCharacteristic *pCharacteristic = SoftDeviceSim_FindHandle(&softDeviceSim, handle);
+    if (pCharacteristic == NULL || handle != pCharacteristic->mHandles.value_handle) {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    if (p_value->len > SOFTDEVICE_SIM_MAX_VALUE_SIZE) {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    memcpy(pCharacteristic->mValue, p_value->p_value, p_value->len);
+    pCharacteristic->mLength = p_value->len;
+    return NRF_SUCCESS;
+}
+
+/**@brief Queues a notification. Like the SoftDevice, a full queue is reported with NRF_ERROR_RESOURCES. */
+uint32_t sd_ble_gatts_hvx(uint16_t conn_handle, ble_gatts_hvx_params_t const *p_hvx_params) {
+    SoftDeviceSim *this = &softDeviceSim;
+    if (!this->mConnected || conn_handle != SOFTDEVICE_SIM_CONN_HANDLE) {
+        return BLE_ERROR_INVALID_CONN_HANDLE;
+    }
+
+    SoftDeviceSimCharacteristic *pCharacteristic = SoftDeviceSim_FindHandle(this, p_hvx_params->handle);
+    if (pCharacteristic == NULL || p_hvx_params->handle != pCharacteristic->mHandles.value_handle ||
+        p_hvx_params->type != BLE_GATT_HVX_NOTIFICATION) {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    if (!pCharacteristic->mIsNotifying) {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    if (*p_hvx_params->p_len > this->mAttMtu - 3) {
+        return NRF_ERROR_DATA_SIZE;
+    }
+    if (this->mQueueCount >= this->mHvnQueueSize) {
+        return NRF_ERROR_RESOURCES;
+    }
+
+    SoftDeviceSimNotification *pNotification = &this->mQueue[(this->mQueueHead + this->mQueueCount) % SOFTDEVICE_SIM_MAX_HVN_QUEUE_SIZE];
+    pNotification->mHandle = p_hvx_params->handle;
+    pNotification->mLength = *p_hvx_params->p_len;
+    memcpy(pNotification->mData, p_hvx_params->p_data, pNotification->mLength);
+    memcpy(pCharacteristic->mValue, p_hvx_params->p_data, pNotification->mLength);
+    pCharacteristic->mLength = pNotification->mLength;
+    this->mQueueCount++;
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_ble_gatts_sys_attr_set(uint16_t conn_handle, uint8_t const *p_sys_attr_data, uint16_t len, uint32_t flags) {
+    (void)p_sys_attr_data;
+    (void)len;
+    (void)flags;
+    return (softDeviceSim.mConnected && conn_handle == SOFTDEVICE_SIM_CONN_HANDLE) ? NRF_SUCCESS : BLE_ERROR_INVALID_CONN_HANDLE;
+}
+
+/**@brief The simulated central never starts an MTU exchange, so there is nothing to reply to. */
+uint32_t sd_ble_gatts_exchange_mtu_reply(uint16_t conn_handle, uint16_t server_rx_mtu) {
+    (void)conn_handle;
+    (void)server_rx_mtu;
+    return NRF_ERROR_INVALID_STATE;
+}
+
+uint32_t sd_ble_gattc_exchange_mtu_request(uint16_t conn_handle, uint16_t client_rx_mtu) {
+    SoftDeviceSim *this = &softDeviceSim;
+    if (!this->mConnected || conn_handle != SOFTDEVICE_SIM_CONN_HANDLE) {
+        return BLE_ERROR_INVALID_CONN_HANDLE;
+    }
+    if (client_rx_mtu < BLE_GATT_ATT_MTU_DEFAULT || client_rx_mtu > this->mMaxAttMtu) {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    if (this->mIsMtuExchanged || this->mPendingMtu != 0) {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    this->mPendingMtu = client_rx_mtu;
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_ble_gap_device_name_set(ble_gap_conn_sec_mode_t const *p_write_perm, uint8_t const *p_dev_name, uint16_t len) {
+    (void)p_write_perm;
+    (void)p_dev_name;
+    (void)len;
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_ble_gap_ppcp_set(ble_gap_conn_params_t const *p_conn_params) {
+    (void)p_conn_params;
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_ble_gap_conn_param_update(uint16_t conn_handle, ble_gap_conn_params_t const *p_conn_params) {
+    SoftDeviceSim *this = &softDeviceSim;
+    if (!this->mConnected || conn_handle != SOFTDEVICE_SIM_CONN_HANDLE) {
+        return BLE_ERROR_INVALID_CONN_HANDLE;
+    }
+
+    this->mIsParamsPending = true;
+    this->mPendingParams = *p_conn_params;
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_ble_gap_phy_update(uint16_t conn_handle, ble_gap_phys_t const *p_gap_phys) {
+    SoftDeviceSim *this = &softDeviceSim;
+    if (!this->mConnected || conn_handle != SOFTDEVICE_SIM_CONN_HANDLE) {
+        return BLE_ERROR_INVALID_CONN_HANDLE;
+    }
+
+    this->mPendingPhys = (p_gap_phys->tx_phys == BLE_GAP_PHY_AUTO) ? (BLE_GAP_PHY_1MBPS | BLE_GAP_PHY_2MBPS) : p_gap_phys->tx_phys;
+    return NRF_SUCCESS;
+}
+
+/**@brief Without parameters, the SoftDevice asks for the largest data length the configuration allows. */
+uint32_t sd_ble_gap_data_length_update(uint16_t conn_handle, ble_gap_data_length_params_t const *p_dl_params,
+                                       ble_gap_data_length_limitation_t *p_dl_limitation) {
+    SoftDeviceSim *this = &softDeviceSim;
+    (void)p_dl_limitation;
+    if (!this->mConnected || conn_handle != SOFTDEVICE_SIM_CONN_HANDLE) {
+        return BLE_ERROR_INVALID_CONN_HANDLE;
+    }
+
+    uint16_t dataLength = (p_dl_params != NULL) ? p_dl_params->max_tx_octets : NRF_SDH_BLE_GAP_DATA_LENGTH;
+    if (dataLength < BLE_GAP_DATA_LENGTH_DEFAULT || dataLength > BLE_GAP_DATA_LENGTH_MAX) {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    this->mPendingDataLength = dataLength;
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_ble_gap_sec_params_reply(uint16_t conn_handle, uint8_t sec_status, void const *p_sec_params, void const *p_sec_keyset) {
+    (void)sec_status;
+    (void)p_sec_params;
+    (void)p_sec_keyset;
+    return (softDeviceSim.mConnected && conn_handle == SOFTDEVICE_SIM_CONN_HANDLE) ? NRF_SUCCESS : BLE_ERROR_INVALID_CONN_HANDLE;
+}
+
+/**@brief The link goes down at the next connection event, as the SoftDevice reports it from its interrupt. */
+uint32_t sd_ble_gap_disconnect(uint16_t conn_handle, uint8_t hci_status_code) {
+    SoftDeviceSim *this = &softDeviceSim;
+    (void)hci_status_code;
+    if (!this->mConnected || conn_handle != SOFTDEVICE_SIM_CONN_HANDLE) {
+        return BLE_ERROR_INVALID_CONN_HANDLE;
+    }
+    if (this->mIsDisconnectPending) {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    this->mIsDisconnectPending = true;
+    return NRF_SUCCESS;
+}
+
+static uint32_t SoftDeviceSim_Reject(SoftDeviceSim *this, uint32_t errCode) {
+    this->mRejectedCount++;
+    return errCode;
+}
+
+/**@brief Largest advertising data the set accepts, 0 if the parameters are invalid. */
+static uint16_t SoftDeviceSim_GetMaxDataLength(ble_gap_adv_params_t const *pParams) {
+    if (pParams->properties.type != BLE_GAP_ADV_TYPE_EXTENDED_NONCONNECTABLE_NONSCANNABLE_UNDIRECTED &&
+        pParams->properties.type != BLE_GAP_ADV_TYPE_EXTENDED_CONNECTABLE_NONSCANNABLE_UNDIRECTED) {
+        return BLE_GAP_ADV_SET_DATA_SIZE_MAX;
+    }
+    // Extended advertising indications are only sent on 1 Mbps or Coded on the primary channels.
+    if (pParams->primary_phy == BLE_GAP_PHY_2MBPS ||
+        (pParams->secondary_phy != BLE_GAP_PHY_AUTO && pParams->secondary_phy != BLE_GAP_PHY_1MBPS &&
+         pParams->secondary_phy != BLE_GAP_PHY_2MBPS && pParams->secondary_phy != BLE_GAP_PHY_CODED)) {
+        return 0;
+    }
+    return BLE_GAP_ADV_SET_DATA_SIZE_EXTENDED_MAX_SUPPORTED;
+}
+
+/**@brief Calls the observers in priority order, then the hook. */
+static void SoftDeviceSim_Dispatch(SoftDeviceSim *this, ble_evt_t const *pEvt) {
+    for (uint8_t i = 0; i < m_observer_count; i++) {
+        m_observers[i].mHandler(pEvt, m_observers[i].mpContext);
+    }
+    if (this->mpEventHook) {
+        this->mpEventHook();
+    }
+}
+
+static void SoftDeviceSim_DispatchGap(SoftDeviceSim *this, uint16_t evtId, ble_gap_evt_t const *pGapEvt) {
+    ble_evt_t evt;
+    memset(&evt, 0, sizeof(evt));
+    evt.header.evt_id = evtId;
+    evt.evt.gap_evt = *pGapEvt;
+    evt.evt.gap_evt.conn_handle = SOFTDEVICE_SIM_CONN_HANDLE;
+    SoftDeviceSim_Dispatch(this, &evt);
+}
+
+/**@brief Completes the procedures started since the previous connection event, the central accepting them. */
+static void SoftDeviceSim_RunProcedures(SoftDeviceSim *this) {
+    ble_gap_evt_t gapEvt;
+
+    if (this->mIsDisconnectPending) {
+        SoftDeviceSim_Drop(this, BLE_HCI_LOCAL_HOST_TERMINATED_CONNECTION);
+        return;
+    }
+    if (this->mPendingMtu != 0) {
+        this->mAttMtu = MIN(this->mPendingMtu, this->mCentral.mAttMtu);
+        this->mIsMtuExchanged = true;
+        this->mPendingMtu = 0;
+
+        ble_evt_t evt;
+        memset(&evt, 0, sizeof(evt));
+        evt.header.evt_id = BLE_GATTC_EVT_EXCHANGE_MTU_RSP;
+        evt.evt.gattc_evt.conn_handle = SOFTDEVICE_SIM_CONN_HANDLE;
+        evt.evt.gattc_evt.params.exchange_mtu_rsp.server_rx_mtu = this->mCentral.mAttMtu;
+        SoftDeviceSim_Dispatch(this, &evt);
+    }
+    if (this->mPendingDataLength != 0) {
+        this->mDataLength = MIN(this->mPendingDataLength, this->mCentral.mDataLength);
+        this->mPendingDataLength = 0;
+
+        memset(&gapEvt, 0, sizeof(gapEvt));
+        ble_gap_data_length_params_t *pParams = &gapEvt.params.data_length_update.effective_params;
+        pParams->max_tx_octets = this->mDataLength;
+        pParams->max_rx_octets = this->mDataLength;
+        pParams->max_tx_time_us = (uint16_t)SoftDeviceSim_GetPacketUs(BLE_GAP_PHY_1MBPS, this->mDataLength);
+        pParams->max_rx_time_us = pParams->max_tx_time_us;
+        SoftDeviceSim_DispatchGap(this, BLE_GAP_EVT_DATA_LENGTH_UPDATE, &gapEvt);
+    }
+    if (this->mPendingPhys != 0) {
+        this->mPhy = (this->mPendingPhys & this->mCentral.mPhys & BLE_GAP_PHY_2MBPS) ? BLE_GAP_PHY_2MBPS : BLE_GAP_PHY_1MBPS;
+        this->mPendingPhys = 0;
+
+        memset(&gapEvt, 0, sizeof(gapEvt));
+        gapEvt.params.phy_update.tx_phy = this->mPhy;
+        gapEvt.params.phy_update.rx_phy = this->mPhy;
+        SoftDeviceSim_DispatchGap(this, BLE_GAP_EVT_PHY_UPDATE, &gapEvt);
+    }
+    if (this->mIsParamsPending) {
+        // The central keeps its interval if it is in the range asked for, otherwise takes the nearest bound.
+        this->mInterval = MIN(MAX(this->mInterval, this->mPendingParams.min_conn_interval), this->mPendingParams.max_conn_interval);
+        this->mIsParamsPending = false;
+
+        memset(&gapEvt, 0, sizeof(gapEvt));
+        gapEvt.params.conn_param_update.conn_params = this->mPendingParams;
+        gapEvt.params.conn_param_update.conn_params.min_conn_interval = this->mInterval;
+        gapEvt.params.conn_param_update.conn_params.max_conn_interval = this->mInterval;
+        SoftDeviceSim_DispatchGap(this, BLE_GAP_EVT_CONN_PARAM_UPDATE, &gapEvt);
+    }
+}
+
+/**@brief Ends the link: queued notifications are lost and the CCCDs cleared, as there is no bonding. */
+static void SoftDeviceSim_Drop(SoftDeviceSim *this, uint8_t reason) {
+    this->mConnected = false;
+    this->mIsMtuExchanged = false;
+    this->mPendingMtu = 0;
+    this->mPendingDataLength = 0;
+    this->mPendingPhys = 0;
+    this->mIsParamsPending = false;
+    this->mIsDisconnectPending = false;
+    this->mQueueCount = 0;
+    for (uint8_t i = 0; i < this->mCharacteristicCount; i++) {
+        this->mCharacteristics[i].mIsNotifying = false;
+    }
+
+    ble_gap_evt_t gapEvt;
+    memset(&gapEvt, 0, sizeof(gapEvt));
+    gapEvt.params.disconnected.reason = reason;
+    SoftDeviceSim_DispatchGap(this, BLE_GAP_EVT_DISCONNECTED, &gapEvt);
+}
+
+/**@brief Characteristic owning a value or CCCD handle. */
+static SoftDeviceSimCharacteristic* SoftDeviceSim_FindHandle(SoftDeviceSim *this, uint16_t handle) {
+    for (uint8_t i = 0; i < this->mCharacteristicCount; i++) {
+        SoftDeviceSimCharacteristic *pCharacteristic = &this->mCharacteristics[i];
+        if (handle == pCharacteristic->mHandles.value_handle || (handle != 0 && handle == pCharacteristic->mHandles.cccd_handle)) {
+            return pCharacteristic;
+        }
+    }
+    return NULL;
+}
+
+/**@brief Air time of a notification: its L2CAP fragments, each acknowledged by an empty packet from the central. */
+static uint32_t SoftDeviceSim_GetNotificationUs(SoftDeviceSim *this, uint16_t length) {
+    uint32_t remaining = (uint32_t)length + SOFTDEVICE_SIM_L2CAP_ATT_HEADER_SIZE;
+    uint32_t us = 0;
+    while (remaining > 0) {
+        uint16_t fragment = (uint16_t)MIN(remaining, this->mDataLength);
+        us += SoftDeviceSim_GetPacketUs(this->mPhy, fragment) + SOFTDEVICE_SIM_IFS_US +
+              SoftDeviceSim_GetPacketUs(this->mPhy, 0) + SOFTDEVICE_SIM_IFS_US;
+        remaining -= fragment;
+    }
+    return us;
+}
+
+/**@brief Air time of a data channel packet: preamble, access address, header, payload and CRC. */
+static uint32_t SoftDeviceSim_GetPacketUs(uint8_t phy, uint16_t payloadSize) {
+    if (phy == BLE_GAP_PHY_2MBPS) {
+        return (2 + 4 + 2 + payloadSize + 3) * 4;
+    }
+    return (1 + 4 + 2 + payloadSize + 3) * 8;
+}
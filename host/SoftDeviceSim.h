@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ble.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**@brief Host model of the SoftDevice advertising API.
+ *
+ * @details Like the SoftDevice, it keeps using the buffer it was given until another one is configured.
+ *          It also keeps a private copy of the frame taken when the buffer was handed over. Every advertising
+ *          event compares the two, so any write the application makes to a buffer the SoftDevice owns shows up
+ *          as a torn frame. The test driver calls SoftDeviceSim_AdvertisingEvent once per advertising interval,
+ *          SoftDeviceSim_ScanRequest to act as an active scanner and SoftDeviceSim_Connect to act as a central.
+ *          A driver timing the events calls SoftDeviceSim_RadioNotification the configured distance before
+ *          each of them.
+ *
+ *          Once connected, the link runs one connection event per SoftDeviceSim_ConnectionEvent call. The event
+ *          completes the procedures the firmware started (MTU exchange, data length and PHY update, connection
+ *          parameters), within what the central set with SoftDeviceSim_SetCentral supports, then sends queued
+ *          notifications for as long as the event lasts, timing each packet on the PHY in use. Every SoftDevice
+ *          event is dispatched to the NRF_SDH_BLE_OBSERVER handlers, then to the hook, where the driver runs the
+ *          tasks they woke up so that notifications queued in response are sent in the same connection event.
+ */
+
+typedef struct {
+    uint32_t mConfigureCount;    /**< Number of accepted sd_ble_gap_adv_set_configure calls. */
+    uint32_t mRejectedCount;     /**< Number of rejected sd_ble_gap_adv_set_configure calls. */
+    uint32_t mAdvEventCount;     /**< Number of frames sent. */
+    uint32_t mScanRequestCount;  /**< Number of scan requests answered. */
+    uint32_t mTornFrameCount;    /**< Number of frames that differed from the data handed over. */
+    uint32_t mConnEventCount;    /**< Number of connection events run. */
+    uint32_t mNotificationCount; /**< Number of notifications received by the central. */
+} SOFTDEVICE_SIM_STATS;
+
+typedef struct {
+    uint16_t mInterval;          /**< Connection interval in 1.25 ms units, kept within what the peripheral asks for. */
+    uint16_t mAttMtu;            /**< Largest ATT MTU accepted, 23 for none. */
+    uint16_t mDataLength;        /**< Largest link layer payload accepted, 27 without data length extension. */
+    uint8_t mPhys;               /**< PHYs supported, BLE_GAP_PHY_1MBPS with or without BLE_GAP_PHY_2MBPS. */
+} SOFTDEVICE_SIM_CENTRAL;
+
+/**@brief Called for every notification the central receives. */
+typedef void(SOFTDEVICE_SIM_NOTIFICATION_HANDLER)(uint16_t handle, uint8_t const *pData, uint16_t length);
+
+/**@brief Called after every event dispatched to the observers. */
+typedef void(SOFTDEVICE_SIM_EVENT_HOOK)(void);
+
+void SoftDeviceSim_Init(void);
+bool SoftDeviceSim_AdvertisingEvent(void);
+uint16_t SoftDeviceSim_ScanRequest(uint8_t *pBuffer);
+bool SoftDeviceSim_Connect(void);
+void SoftDeviceSim_SetCentral(SOFTDEVICE_SIM_CENTRAL const *pCentral);
+void SoftDeviceSim_SetNotificationHandler(SOFTDEVICE_SIM_NOTIFICATION_HANDLER *pHandler);
+void SoftDeviceSim_SetEventHook(SOFTDEVICE_SIM_EVENT_HOOK *pHook);
+bool SoftDeviceSim_FindCharacteristic(uint8_t uuidType, uint16_t uuid, ble_gatts_char_handles_t *pHandles);
+bool SoftDeviceSim_Write(uint16_t handle, uint8_t const *pData, uint16_t length);
+uint32_t SoftDeviceSim_ConnectionEvent(void);
+bool SoftDeviceSim_Disconnect(uint8_t reason);
+uint32_t SoftDeviceSim_GetRadioNotificationUs(void);
+bool SoftDeviceSim_RadioNotification(void);
+uint16_t SoftDeviceSim_GetFrame(uint8_t *pBuffer);
+uint32_t SoftDeviceSim_GetInterval(void);
+void SoftDeviceSim_FailNextConfigure(uint32_t errCode);
+void SoftDeviceSim_GetStats(SOFTDEVICE_SIM_STATS *pStats);
@@ -0,0 +1,409 @@
+#include "TimerManagerSim.h"
+#include <stdio.h>
+#include <string.h>
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+struct Timer
+{
+    TIMER_CALLBACK *mpCallback;
+    void *mpContext;
+    bool mInUse;
+    bool mAutoRelease;
+    bool mRepeated;
+    bool mPeriodic;
+    bool mArmed;
+    TIMER_MISSED_POLICY mPolicy;
+    uint32_t mPeriodTicks;
+    uint32_t mTimeoutTicks;
+    uint64_t mDeadline;   // Virtual time the callback is due, on the periodic grid for periodic timers.
+    uint64_t mExpiry;     // Virtual time the timer fires, never earlier than the minimum timeout.
+    uint64_t mSequence;   // Order in which timers were armed, breaks ties between equal expiries.
+    uint32_t mCount;
+    uint32_t mMissedCount;
+    uint32_t mMaxLatenessTicks;
+    uint64_t mTotalLatenessTicks;
+};
+
+#if TIMER_MANAGER_PROFILER_ENABLED
+typedef struct
+{
+    TIMER_CALLBACK *mpCallback;
+    uint32_t mInvocationCount;
+    uint32_t mMaxLatenessTicks;
+} TimerProfile;
+#endif
+
+typedef struct
+{
+    struct Timer mTimers[TIMER_POOL_SIZE];
+    uint8_t mUsedCount;
+    uint8_t mPeakCount;
+    uint64_t mNow;
+    uint64_t mNextSequence;
+    TIMER_SIM_TRACE_HANDLER *mpTraceHandler;
+#if TIMER_MANAGER_PROFILER_ENABLED
+    TimerProfile mProfiles[TIMER_MANAGER_PROFILE_COUNT];
+#endif
+} TimerManagerSim;
+
+#define TIMER_COUNTER_BITS 24  /**< Width of the RTC counter behind app_timer. */
+#define TIMER_COUNTER_MASK ((1UL << TIMER_COUNTER_BITS) - 1)
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static TIMER_HANDLE TimerManagerSim_Allocate(TimerManagerSim *this, TIMER_CALLBACK *pCallback, app_timer_mode_t mode, bool autoRelease);
+static void TimerManagerSim_Free(TimerManagerSim *this, struct Timer *pTimer);
+static void TimerManagerSim_Arm(TimerManagerSim *this, struct Timer *pTimer, uint64_t expiry);
+static void TimerManagerSim_Disarm(TimerManagerSim *this, struct Timer *pTimer);
+static struct Timer* TimerManagerSim_NextTimer(TimerManagerSim *this);
+static void TimerManagerSim_Dispatch(TimerManagerSim *this, struct Timer *pTimer);
+static void TimerManagerSim_PeriodicDispatch(TimerManagerSim *this, struct Timer *pTimer);
+static void TimerManagerSim_Trace(TimerManagerSim *this, TIMER_SIM_EVENT event, struct Timer *pTimer);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static TimerManagerSim timerManagerSim;
+
+/**@brief Resets the pool and the virtual clock to 0. The trace handler is kept. */
+void TimerManager_Init(void) {
+    TIMER_SIM_TRACE_HANDLER *pTraceHandler = timerManagerSim.mpTraceHandler;
+    memset(&timerManagerSim, 0, sizeof(timerManagerSim));
+    timerManagerSim.mpTraceHandler = pTraceHandler;
+}
+
+TIMER_HANDLE TimerManager_Acquire(TIMER_CALLBACK *pCallback, app_timer_mode_t mode) {
+    return TimerManagerSim_Allocate(&timerManagerSim, pCallback, mode, false);
+}
+
+void TimerManager_Release(TIMER_HANDLE hTimer) {
+    if (hTimer == NULL || !hTimer->mInUse) {
+        printf("%s(%d) Timer not acquired (ID: %p)\n", __func__, __LINE__, (void*)hTimer);
+        return;
+    }
+
+    TimerManagerSim_Disarm(&timerManagerSim, hTimer);
+    TimerManagerSim_Free(&timerManagerSim, hTimer);
+}
+
+void TimerManager_Start(TIMER_HANDLE hTimer, uint32_t timeoutTicks, void *pContext) {
+    if (hTimer == NULL || !hTimer->mInUse) {
+        printf("%s(%d) Timer not acquired (ID: %p)\n", __func__, __LINE__, (void*)hTimer);
+        return;
+    }
+    if (timeoutTicks < APP_TIMER_MIN_TIMEOUT_TICKS) {
+        // app_timer_start rejects this with NRF_ERROR_INVALID_PARAM.
+        printf("%s(%d) Error starting timer (ID: %p): timeout %d below minimum\n", __func__, __LINE__, (void*)hTimer, timeoutTicks);
+        return;
+    }
+
+    hTimer->mpContext = pContext;
+    hTimer->mTimeoutTicks = timeoutTicks;
+    hTimer->mDeadline = timerManagerSim.mNow + timeoutTicks;
+    TimerManagerSim_Arm(&timerManagerSim, hTimer, hTimer->mDeadline);
+}
+
+void TimerManager_Stop(TIMER_HANDLE hTimer) {
+    if (hTimer == NULL || !hTimer->mInUse) {
+        printf("%s(%d) Timer not acquired (ID: %p)\n", __func__, __LINE__, (void*)hTimer);
+        return;
+    }
+
+    TimerManagerSim_Disarm(&timerManagerSim, hTimer);
+}
+
+bool TimerManager_StartOneShot(TIMER_CALLBACK *pCallback, uint32_t timeoutTicks, void *pContext) {
+    TIMER_HANDLE hTimer = TimerManagerSim_Allocate(&timerManagerSim, pCallback, APP_TIMER_MODE_SINGLE_SHOT, true);
+    if (hTimer == NULL) {
+        return false;
+    }
+
+    TimerManager_Start(hTimer, timeoutTicks, pContext);
+    return true;
+}
+
+TIMER_HANDLE TimerManager_StartPeriodic(TIMER_CALLBACK *pCallback, uint32_t periodTicks, TIMER_MISSED_POLICY policy, void *pContext) {
+    TIMER_HANDLE hTimer = TimerManagerSim_Allocate(&timerManagerSim, pCallback, APP_TIMER_MODE_SINGLE_SHOT, false);
+    if (hTimer == NULL) {
+        return NULL;
+    }
+
+    hTimer->mPeriodic = true;
+    hTimer->mPolicy = policy;
+    hTimer->mPeriodTicks = periodTicks;
+    TimerManager_Start(hTimer, periodTicks, pContext);
+    return hTimer;
+}
+
+void TimerManager_SetPeriod(TIMER_HANDLE hTimer, uint32_t periodTicks) {
+    if (hTimer == NULL || !hTimer->mPeriodic) {
+        printf("%s(%d) Not a periodic timer (ID: %p)\n", __func__, __LINE__, (void*)hTimer);
+        return;
+    }
+
+    TimerManager_Stop(hTimer);
+    hTimer->mPeriodTicks = periodTicks;
+    TimerManager_Start(hTimer, periodTicks, hTimer->mpContext);
+}
+
+void TimerManager_GetPeriodicStats(TIMER_HANDLE hTimer, TIMER_PERIODIC_STATS *pStats) {
+    memset(pStats, 0, sizeof(*pStats));
+    if (hTimer == NULL || !hTimer->mPeriodic) {
+        printf("%s(%d) Not a periodic timer (ID: %p)\n", __func__, __LINE__, (void*)hTimer);
+        return;
+    }
+
+    pStats->mCount = hTimer->mCount;
+    pStats->mMissedCount = hTimer->mMissedCount;
+    pStats->mMaxLatenessTicks = hTimer->mMaxLatenessTicks;
+    pStats->mMeanLatenessTicks = (hTimer->mCount > 0) ? (uint32_t)(hTimer->mTotalLatenessTicks / hTimer->mCount) : 0;
+}
+
+/**@brief Virtual time truncated to the width of the RTC counter, so that wrap handling is exercised too. */
+uint32_t TimerManager_GetTicks(void) {
+    return (uint32_t)(timerManagerSim.mNow & TIMER_COUNTER_MASK);
+}
+
+uint32_t TimerManager_GetTicksSince(uint32_t ticks) {
+    return (TimerManager_GetTicks() - ticks) & TIMER_COUNTER_MASK;
+}
+
+uint8_t TimerManager_GetUsage(void) {
+    return timerManagerSim.mUsedCount;
+}
+
+uint8_t TimerManager_GetPeakUsage(void) {
+    return timerManagerSim.mPeakCount;
+}
+
+#if TIMER_MANAGER_PROFILER_ENABLED
+/**@brief Callbacks take no virtual time, so only the counts and the lateness are reported. */
+bool TimerManager_GetProfile(TIMER_CALLBACK *pCallback, TIMER_PROFILE *pProfile) {
+    memset(pProfile, 0, sizeof(*pProfile));
+    for (size_t i = 0; i < TIMER_MANAGER_PROFILE_COUNT; i++) {
+        TimerProfile *pEntry = &timerManagerSim.mProfiles[i];
+        if (pEntry->mpCallback != NULL && pEntry->mpCallback == pCallback) {
+            pProfile->mInvocationCount = pEntry->mInvocationCount;
+            pProfile->mMaxLatenessTicks = pEntry->mMaxLatenessTicks;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TimerManager_DumpProfiles(void) {
+    for (size_t i = 0; i < TIMER_MANAGER_PROFILE_COUNT; i++) {
+        TimerProfile *pEntry = &timerManagerSim.mProfiles[i];
+        if (pEntry->mpCallback == NULL) {
+            break;
+        }
+        printf("%s(%d) %p: count=%d late=%dticks\n", __func__, __LINE__, (void*)pEntry->mpCallback,
+               pEntry->mInvocationCount, pEntry->mMaxLatenessTicks);
+    }
+}
+#endif
+
+void TimerManagerSim_SetTraceHandler(TIMER_SIM_TRACE_HANDLER *pHandler) {
+    timerManagerSim.mpTraceHandler = pHandler;
+}
+
+/**@brief Virtual time in RTC ticks since TimerManager_Init. Unlike TimerManager_GetTicks it does not wrap. */
+uint64_t TimerManagerSim_GetTime(void) {
+    return timerManagerSim.mNow;
+}
+
+bool TimerManagerSim_GetNextEventTime(uint64_t *pTimeTicks) {
+    struct Timer *pTimer = TimerManagerSim_NextTimer(&timerManagerSim);
+    if (pTimer == NULL) {
+        return false;
+    }
+
+    *pTimeTicks = pTimer->mExpiry;
+    return true;
+}
+
+/**@brief Moves the clock to the earliest armed timer and runs its callback.
+ *
+ * @retval true  A timer fired.
+ * @retval false No timer was armed, the clock did not move.
+ */
+bool TimerManagerSim_AdvanceToNextEvent(void) {
+    struct Timer *pTimer = TimerManagerSim_NextTimer(&timerManagerSim);
+    if (pTimer == NULL) {
+        return false;
+    }
+
+    // A stalled clock can be past the expiry already, the timer then fires late.
+    if (pTimer->mExpiry > timerManagerSim.mNow) {
+        timerManagerSim.mNow = pTimer->mExpiry;
+    }
+    TimerManagerSim_Dispatch(&timerManagerSim, pTimer);
+    return true;
+}
+
+/**@brief Fires every timer due up to timeTicks in order, then moves the clock to timeTicks.
+ *
+ * @return Number of timers fired.
+ */
+uint32_t TimerManagerSim_AdvanceTo(uint64_t timeTicks) {
+    uint32_t count = 0;
+    uint64_t next;
+
+    while (TimerManagerSim_GetNextEventTime(&next) && next <= timeTicks) {
+        TimerManagerSim_AdvanceToNextEvent();
+        count++;
+    }
+    if (timeTicks > timerManagerSim.mNow) {
+        timerManagerSim.mNow = timeTicks;
+    }
+    return count;
+}
+
+/**@brief Moves the clock without firing timers, as if the CPU were busy. Timers that became due fire late. */
+void TimerManagerSim_Stall(uint32_t ticks) {
+    timerManagerSim.mNow += ticks;
+}
+
+static TIMER_HANDLE TimerManagerSim_Allocate(TimerManagerSim *this, TIMER_CALLBACK *pCallback, app_timer_mode_t mode, bool autoRelease) {
+    struct Timer *pTimer = NULL;
+
+    for (size_t i = 0; i < TIMER_POOL_SIZE; i++) {
+        if (!this->mTimers[i].mInUse) {
+            pTimer = &this->mTimers[i];
+            break;
+        }
+    }
+
+    if (pTimer == NULL) {
+        printf("%s(%d) Failed to acquire timer: Maximum count (%d) reached\n", __func__, __LINE__, TIMER_POOL_SIZE);
+        return NULL;
+    }
+
+    memset(pTimer, 0, sizeof(*pTimer));
+    pTimer->mInUse = true;
+    pTimer->mpCallback = pCallback;
+    pTimer->mAutoRelease = autoRelease;
+    pTimer->mRepeated = (mode == APP_TIMER_MODE_REPEATED);
+    this->mUsedCount++;
+    if (this->mUsedCount > this->mPeakCount) {
+        this->mPeakCount = this->mUsedCount;
+    }
+    return pTimer;
+}
+
+static void TimerManagerSim_Free(TimerManagerSim *this, struct Timer *pTimer) {
+    if (pTimer->mInUse) {
+        pTimer->mInUse = false;
+        pTimer->mpCallback = NULL;
+        this->mUsedCount--;
+    }
+}
+
+static void TimerManagerSim_Arm(TimerManagerSim *this, struct Timer *pTimer, uint64_t expiry) {
+    // app_timer2 restarts a running timer, the previous expiry is dropped.
+    pTimer->mArmed = true;
+    pTimer->mExpiry = expiry;
+    pTimer->mSequence = this->mNextSequence++;
+    TimerManagerSim_Trace(this, TIMER_SIM_EVENT_START, pTimer);
+}
+
+static void TimerManagerSim_Disarm(TimerManagerSim *this, struct Timer *pTimer) {
+    if (pTimer->mArmed) {
+        pTimer->mArmed = false;
+        TimerManagerSim_Trace(this, TIMER_SIM_EVENT_STOP, pTimer);
+    }
+}
+
+/**@brief Earliest armed timer, the one armed first on equal expiries. The pool is small enough for a scan. */
+static struct Timer* TimerManagerSim_NextTimer(TimerManagerSim *this) {
+    struct Timer *pNext = NULL;
+
+    for (size_t i = 0; i < TIMER_POOL_SIZE; i++) {
+        struct Timer *pTimer = &this->mTimers[i];
+        if (!pTimer->mInUse || !pTimer->mArmed) {
+            continue;
+        }
+        if (pNext == NULL || pTimer->mExpiry < pNext->mExpiry ||
+            (pTimer->mExpiry == pNext->mExpiry && pTimer->mSequence < pNext->mSequence)) {
+            pNext = pTimer;
+        }
+    }
+    return pNext;
+}
+
+static void TimerManagerSim_Dispatch(TimerManagerSim *this, struct Timer *pTimer) {
+    uint64_t lateness = this->mNow - pTimer->mDeadline;
+
+    TimerManagerSim_Trace(this, TIMER_SIM_EVENT_EXPIRE, pTimer);
+    pTimer->mArmed = false;
+    if (pTimer->mPeriodic) {
+        TimerManagerSim_PeriodicDispatch(this, pTimer);
+    } else if (pTimer->mRepeated) {
+        pTimer->mDeadline = pTimer->mExpiry + pTimer->mTimeoutTicks;
+        TimerManagerSim_Arm(this, pTimer, pTimer->mDeadline);
+    }
+
+    TIMER_CALLBACK *pCallback = pTimer->mpCallback;
+    void *pUserContext = pTimer->mpContext;
+
+    if (pTimer->mAutoRelease) {
+        TimerManagerSim_Free(this, pTimer);
+    }
+
+#if TIMER_MANAGER_PROFILER_ENABLED
+    for (size_t i = 0; pCallback != NULL && i < TIMER_MANAGER_PROFILE_COUNT; i++) {
+        TimerProfile *pEntry = &this->mProfiles[i];
+        if (pEntry->mpCallback == NULL) {
+            pEntry->mpCallback = pCallback;
+        }
+        if (pEntry->mpCallback == pCallback) {
+            pEntry->mInvocationCount++;
+            if (lateness > pEntry->mMaxLatenessTicks) {
+                pEntry->mMaxLatenessTicks = (uint32_t)lateness;
+            }
+            break;
+        }
+    }
+#else
+    (void)lateness;
+#endif
+    if (pCallback) pCallback(pUserContext);
+}
+
+/**@brief Same deadline and missed-period handling as TimerManager_PeriodicDispatch, on 64-bit time. */
+static void TimerManagerSim_PeriodicDispatch(TimerManagerSim *this, struct Timer *pTimer) {
+    uint64_t lateness = this->mNow - pTimer->mDeadline;
+
+    uint64_t missed = lateness / pTimer->mPeriodTicks;
+    if (missed > 0) {
+        if (pTimer->mPolicy == TIMER_MISSED_POLICY_SKIP) {
+            pTimer->mMissedCount += (uint32_t)missed;
+            pTimer->mDeadline += missed * pTimer->mPeriodTicks;
+            lateness -= missed * pTimer->mPeriodTicks;
+        } else {
+            pTimer->mMissedCount++;
+        }
+    }
+
+    pTimer->mCount++;
+    pTimer->mTotalLatenessTicks += lateness;
+    if (lateness > pTimer->mMaxLatenessTicks) {
+        pTimer->mMaxLatenessTicks = (uint32_t)lateness;
+    }
+
+    pTimer->mDeadline += pTimer->mPeriodTicks;
+    uint64_t expiry = this->mNow + APP_TIMER_MIN_TIMEOUT_TICKS;
+    if (pTimer->mDeadline > expiry) {
+        expiry = pTimer->mDeadline;
+    }
+    TimerManagerSim_Arm(this, pTimer, expiry);
+}
+
+static void TimerManagerSim_Trace(TimerManagerSim *this, TIMER_SIM_EVENT event, struct Timer *pTimer) {
+    if (this->mpTraceHandler) {
+        this->mpTraceHandler(this->mNow, event, (uint8_t)(pTimer - this->mTimers), pTimer->mpCallback, pTimer->mExpiry);
+    }
+}
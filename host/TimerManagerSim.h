@@ -0,0 +1,39 @@
+#pragma once
+
+#include "TimerManager.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**@brief Host backend of TimerManager.h on a virtual clock.
+ *
+ * @details Build the firmware modules with this directory first on the include path, followed by
+ *          pca10056/s140/config, and link TimerManagerSim.c instead of TimerManager.c. Time only moves when
+ *          the test driver advances it, so a week of sampling runs as fast as the callbacks execute. Timers
+ *          expiring on the same tick fire in the order they were started, which makes every run produce the
+ *          same trace.
+ *
+ *          A driver loop looks like:
+ *          @code
+ *          while (TimerManagerSim_GetTime() < end) {
+ *              TimerManagerSim_AdvanceToNextEvent();
+ *              while (TaskScheduler_RunNext()) {}
+ *          }
+ *          @endcode
+ */
+
+typedef enum {
+    TIMER_SIM_EVENT_START,   /**< A timer was armed. */
+    TIMER_SIM_EVENT_STOP,    /**< An armed timer was stopped or released. */
+    TIMER_SIM_EVENT_EXPIRE,  /**< A timer expired, its callback runs right after the trace. */
+} TIMER_SIM_EVENT;
+
+/**@brief Trace hook. timeTicks is the virtual time in RTC ticks, expiryTicks the time the timer is due. */
+typedef void(TIMER_SIM_TRACE_HANDLER)(uint64_t timeTicks, TIMER_SIM_EVENT event, uint8_t timerIndex,
+                                      TIMER_CALLBACK *pCallback, uint64_t expiryTicks);
+
+void TimerManagerSim_SetTraceHandler(TIMER_SIM_TRACE_HANDLER *pHandler);
+uint64_t TimerManagerSim_GetTime(void);
+bool TimerManagerSim_GetNextEventTime(uint64_t *pTimeTicks);
+bool TimerManagerSim_AdvanceToNextEvent(void);
+uint32_t TimerManagerSim_AdvanceTo(uint64_t timeTicks);
+void TimerManagerSim_Stall(uint32_t ticks);
@@ -0,0 +1,263 @@
+#include "TimerWheel.h"
+#include "TimerManagerSim.h"
+#include "app_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Compares TimerWheel with the way app_timer2 keeps its timers, a list sorted by expiry time (nrf_sortlist) with
+ * the RTC compare set to the head, at 10, 100 and 1000 periodic timers. Both run the same schedule: periods
+ * between 10 ms and 10 s, and on a quarter of the expiries a random timer is restarted, as a timeout would be.
+ * The list model runs on its own clock, the wheel on the TimerManagerSim virtual clock.
+ *
+ * It reports the host time per start, stop and expiry, the list entries visited per operation and the RTC
+ * wake-ups per second of virtual time. The host times include the virtual clock for the wheel; the visits and
+ * wake-ups do not depend on the host.
+ *
+ *   cc -O2 -Ihost -Ipca10056/s140/config -I. host/TimerWheelBench.c TimerWheel.c host/TimerManagerSim.c \
+ *      -o timer_wheel_bench
+ *   ./timer_wheel_bench
+ */
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define BENCH_SEED              1
+#define BENCH_MAX_TIMERS        1000
+#define BENCH_RUN_S             600
+#define BENCH_MIN_PERIOD_MS     10
+#define BENCH_MAX_PERIOD_MS     10000
+#define BENCH_RESTART_ONE_IN    4
+
+typedef struct ListTimer {
+    struct ListTimer *mpNext;
+    uint64_t mExpires;
+    uint32_t mPeriodTicks;
+    bool mIsActive;
+} ListTimer;
+
+typedef struct
+{
+    ListTimer *mpHead;
+    uint64_t mNow;
+    uint64_t mVisitCount;
+} ListModel;
+
+typedef struct
+{
+    char const *mpName;
+    uint64_t mStartNs;
+    uint64_t mStopNs;
+    uint64_t mRunNs;
+    uint64_t mExpiryCount;
+    uint64_t mRestartCount;
+    uint64_t mWakeupCount;
+    bool mHasVisits;              // List entries are counted, the wheel has none to walk.
+    uint64_t mStartVisits;
+    uint64_t mStopVisits;
+} BenchResult;
+
+typedef struct
+{
+    uint32_t mTimerCount;
+    uint32_t mPeriods[BENCH_MAX_TIMERS];      // Wheel ticks.
+    TIMER_WHEEL_TIMER mWheelTimers[BENCH_MAX_TIMERS];
+    ListTimer mListTimers[BENCH_MAX_TIMERS];
+    ListModel mList;
+    BenchResult *mpResult;
+} TimerWheelBench;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static void TimerWheelBench_RunWheel(TimerWheelBench *this, BenchResult *pResult);
+static void TimerWheelBench_RunList(TimerWheelBench *this, BenchResult *pResult);
+static void TimerWheelBench_OnWheelExpiry(void *pContext);
+static void TimerWheelBench_OnWheelTrace(uint64_t timeTicks, TIMER_SIM_EVENT event, uint8_t timerIndex,
+                                         TIMER_CALLBACK *pCallback, uint64_t expiryTicks);
+static void ListModel_Start(ListModel *this, ListTimer *pTimer, uint32_t delayTicks, uint32_t periodTicks);
+static void ListModel_Stop(ListModel *this, ListTimer *pTimer);
+static void TimerWheelBench_Print(TimerWheelBench *this, BenchResult const *pResult);
+static uint64_t TimerWheelBench_GetNs(void);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static TimerWheelBench timerWheelBench;
+
+static uint32_t const m_timer_counts[] = { 10, 100, 1000 };
+
+int main(void) {
+    TimerWheelBench *this = &timerWheelBench;
+
+    printf("timers  model         start     stop   expiry  visits/start  visits/stop  wake-ups/s\n");
+    for (size_t i = 0; i < sizeof(m_timer_counts) / sizeof(m_timer_counts[0]); i++) {
+        BenchResult wheel = { "wheel" };
+        BenchResult list = { "sorted list" };
+
+        this->mTimerCount = m_timer_counts[i];
+        srand(BENCH_SEED);
+        for (uint32_t t = 0; t < this->mTimerCount; t++) {
+            uint32_t periodMs = BENCH_MIN_PERIOD_MS + (uint32_t)rand() % (BENCH_MAX_PERIOD_MS - BENCH_MIN_PERIOD_MS);
+            this->mPeriods[t] = TIMER_WHEEL_TICKS(periodMs);
+        }
+        TimerWheelBench_RunList(this, &list);
+        TimerWheelBench_RunWheel(this, &wheel);
+        TimerWheelBench_Print(this, &list);
+        TimerWheelBench_Print(this, &wheel);
+    }
+    return 0;
+}
+
+static void TimerWheelBench_RunWheel(TimerWheelBench *this, BenchResult *pResult) {
+    this->mpResult = pResult;
+    memset(this->mWheelTimers, 0, sizeof(this->mWheelTimers));
+    TimerManager_Init();
+    TimerWheel_Init();
+    TimerManagerSim_SetTraceHandler(TimerWheelBench_OnWheelTrace);
+    srand(BENCH_SEED);
+
+    uint64_t startNs = TimerWheelBench_GetNs();
+    for (uint32_t t = 0; t < this->mTimerCount; t++) {
+        TimerWheel_Start(&this->mWheelTimers[t], this->mPeriods[t], this->mPeriods[t], TimerWheelBench_OnWheelExpiry, this);
+    }
+    pResult->mStartNs = TimerWheelBench_GetNs() - startNs;
+
+    uint64_t endTicks = TimerManagerSim_GetTime() + (uint64_t)BENCH_RUN_S * TIMER_TICKS_PER_SECOND;
+    uint64_t runNs = TimerWheelBench_GetNs();
+    while (TimerManagerSim_GetTime() < endTicks && TimerManagerSim_AdvanceToNextEvent()) {}
+    pResult->mRunNs = TimerWheelBench_GetNs() - runNs;
+
+    uint64_t stopNs = TimerWheelBench_GetNs();
+    for (uint32_t t = 0; t < this->mTimerCount; t++) {
+        TimerWheel_Stop(&this->mWheelTimers[t]);
+    }
+    pResult->mStopNs = TimerWheelBench_GetNs() - stopNs;
+    TimerManagerSim_SetTraceHandler(NULL);
+}
+
+/**@brief Same schedule as the wheel on a list sorted by expiry, processed the way the app_timer2 RTC interrupt
+ *        does: every timer due at the head is removed, its callback run and, if periodic, put back. */
+static void TimerWheelBench_RunList(TimerWheelBench *this, BenchResult *pResult) {
+    ListModel *pList = &this->mList;
+    memset(pList, 0, sizeof(*pList));
+    memset(this->mListTimers, 0, sizeof(this->mListTimers));
+    srand(BENCH_SEED);
+
+    uint64_t startNs = TimerWheelBench_GetNs();
+    for (uint32_t t = 0; t < this->mTimerCount; t++) {
+        uint32_t periodTicks = this->mPeriods[t] * TIMER_WHEEL_RTC_TICKS_PER_TICK;
+        ListModel_Start(pList, &this->mListTimers[t], periodTicks, periodTicks);
+    }
+    pResult->mStartNs = TimerWheelBench_GetNs() - startNs;
+    pResult->mHasVisits = true;
+    pResult->mStartVisits = pList->mVisitCount;
+
+    uint64_t endTicks = (uint64_t)BENCH_RUN_S * TIMER_TICKS_PER_SECOND;
+    uint64_t lastWakeup = UINT64_MAX;
+    uint64_t runNs = TimerWheelBench_GetNs();
+    while (pList->mpHead != NULL && pList->mpHead->mExpires < endTicks) {
+        ListTimer *pTimer = pList->mpHead;
+        pList->mNow = pTimer->mExpires;
+        if (pList->mNow != lastWakeup) {
+            lastWakeup = pList->mNow;
+            pResult->mWakeupCount++;
+        }
+
+        pList->mpHead = pTimer->mpNext;
+        pTimer->mIsActive = false;
+        if (pTimer->mPeriodTicks > 0) {
+            ListModel_Start(pList, pTimer, pTimer->mPeriodTicks, pTimer->mPeriodTicks);
+        }
+        pResult->mExpiryCount++;
+        if (rand() % BENCH_RESTART_ONE_IN == 0) {
+            uint32_t t = (uint32_t)rand() % this->mTimerCount;
+            uint32_t periodTicks = this->mPeriods[t] * TIMER_WHEEL_RTC_TICKS_PER_TICK;
+            ListModel_Start(pList, &this->mListTimers[t], periodTicks, periodTicks);
+            pResult->mRestartCount++;
+        }
+    }
+    pResult->mRunNs = TimerWheelBench_GetNs() - runNs;
+
+    uint64_t visits = pList->mVisitCount;
+    uint64_t stopNs = TimerWheelBench_GetNs();
+    for (uint32_t t = 0; t < this->mTimerCount; t++) {
+        ListModel_Stop(pList, &this->mListTimers[t]);
+    }
+    pResult->mStopNs = TimerWheelBench_GetNs() - stopNs;
+    pResult->mStopVisits = pList->mVisitCount - visits;
+}
+
+static void TimerWheelBench_OnWheelExpiry(void *pContext) {
+    TimerWheelBench *this = (TimerWheelBench*)pContext;
+
+    this->mpResult->mExpiryCount++;
+    if (rand() % BENCH_RESTART_ONE_IN == 0) {
+        uint32_t t = (uint32_t)rand() % this->mTimerCount;
+        TimerWheel_Start(&this->mWheelTimers[t], this->mPeriods[t], this->mPeriods[t], TimerWheelBench_OnWheelExpiry, this);
+        this->mpResult->mRestartCount++;
+    }
+}
+
+/**@brief Counts the expiries of the single app_timer under the wheel, one RTC wake-up each. */
+static void TimerWheelBench_OnWheelTrace(uint64_t timeTicks, TIMER_SIM_EVENT event, uint8_t timerIndex,
+                                         TIMER_CALLBACK *pCallback, uint64_t expiryTicks) {
+    (void)timeTicks;
+    (void)timerIndex;
+    (void)pCallback;
+    (void)expiryTicks;
+    if (event == TIMER_SIM_EVENT_EXPIRE) {
+        timerWheelBench.mpResult->mWakeupCount++;
+    }
+}
+
+/**@brief Inserts after the timers due at the same time or earlier, as nrf_sortlist_add does. */
+static void ListModel_Start(ListModel *this, ListTimer *pTimer, uint32_t delayTicks, uint32_t periodTicks) {
+    if (pTimer->mIsActive) {
+        ListModel_Stop(this, pTimer);
+    }
+    pTimer->mExpires = this->mNow + delayTicks;
+    pTimer->mPeriodTicks = periodTicks;
+
+    ListTimer **ppNext = &this->mpHead;
+    while (*ppNext != NULL && (*ppNext)->mExpires <= pTimer->mExpires) {
+        ppNext = &(*ppNext)->mpNext;
+        this->mVisitCount++;
+    }
+    pTimer->mpNext = *ppNext;
+    *ppNext = pTimer;
+    pTimer->mIsActive = true;
+}
+
+/**@brief Unlinks the timer, searching it from the head as nrf_sortlist_remove does. */
+static void ListModel_Stop(ListModel *this, ListTimer *pTimer) {
+    for (ListTimer **ppNext = &this->mpHead; *ppNext != NULL; ppNext = &(*ppNext)->mpNext) {
+        this->mVisitCount++;
+        if (*ppNext == pTimer) {
+            *ppNext = pTimer->mpNext;
+            pTimer->mIsActive = false;
+            return;
+        }
+    }
+}
+
+static void TimerWheelBench_Print(TimerWheelBench *this, BenchResult const *pResult) {
+    uint64_t operationCount = pResult->mExpiryCount + pResult->mRestartCount;
+    printf("%6u  %-11s %6lluns %6lluns %6lluns", this->mTimerCount, pResult->mpName,
+           (unsigned long long)(pResult->mStartNs / this->mTimerCount),
+           (unsigned long long)(pResult->mStopNs / this->mTimerCount),
+           (unsigned long long)((operationCount > 0) ? pResult->mRunNs / operationCount : 0));
+    if (pResult->mHasVisits) {
+        printf(" %13.1f %12.1f", (double)pResult->mStartVisits / this->mTimerCount, (double)pResult->mStopVisits / this->mTimerCount);
+    } else {
+        printf(" %13s %12s", "-", "-");
+    }
+    printf(" %11.1f\n", (double)pResult->mWakeupCount / BENCH_RUN_S);
+}
+
+static uint64_t TimerWheelBench_GetNs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
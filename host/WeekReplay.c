@@ -0,0 +1,247 @@
+#include "Advertising.h"
+#include "SHT31.h"
+#include "SampleHistory.h"
+#include "TaskScheduler.h"
+#include "TimerWheel.h"
+#include "TWI.h"
+#include "SoftDeviceSim.h"
+#include "TimerManagerSim.h"
+#include "app_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Replays a week of the firmware on the virtual clock: the sampling timer, the SHT31 driver on a fake TWI bus
+ * and sensor, the history and the advertising updates, with advertising events timed like the link layer does.
+ * Every loop advances to the next event, a timer, the end of a TWI transfer or an advertising event, so the
+ * week runs in seconds. With the same seed every run writes the same trace: the module logs, and every frame
+ * that goes on air for the first time with its time in ms. A summary per day and the result go to stderr, the
+ * exit code is not 0 if a frame was torn or rejected, or a sampling deadline was missed.
+ *
+ *   cc -Ihost -Ipca10056/s140/config -I. host/WeekReplay.c SHT31.c Advertising.c SampleHistory.c SampleCodec.c \
+ *      BeaconCrypto.c TaskScheduler.c TimerWheel.c host/SoftDeviceSim.c host/TimerManagerSim.c host/Aes128.c \
+ *      -o week_replay
+ *   ./week_replay [seed] [days] > week.trace
+ */
+
+/*============================================================================*/
+// define
+/*============================================================================*/
+#define REPLAY_CONN_CFG_TAG         1
+#define REPLAY_SEED                 1
+#define REPLAY_DAYS                 7
+#define REPLAY_SECONDS_PER_DAY      86400UL
+#define REPLAY_ADV_DELAY_MAX_TICKS  APP_TIMER_TICKS(10)
+#define REPLAY_TWI_BIT_US           3       /**< 400 kHz, rounded up. */
+#define REPLAY_MAX_FRAME            255
+
+/* Sensor model, in 0.01 units: a daily swing of the temperature, the humidity falling as it rises, and a random
+ * walk on both. */
+#define REPLAY_TEMPERATURE_MEAN     2200
+#define REPLAY_TEMPERATURE_SWING    300
+#define REPLAY_HUMIDITY_MEAN        5000
+#define REPLAY_NOISE_STEP           3
+#define REPLAY_NOISE_MAX            40
+
+typedef struct
+{
+    nrf_drv_twi_evt_handler_t mTwiHandler;
+    void *mpTwiContext;
+    bool mIsTwiBusy;
+    uint64_t mTwiDoneTicks;
+    uint64_t mNextEventTicks;
+    int32_t mTemperatureNoise;
+    int32_t mHumidityNoise;
+    uint32_t mSampleCount;
+    uint32_t mSamplesPerDay;
+    uint8_t mFrame[REPLAY_MAX_FRAME];
+    uint16_t mFrameLength;
+    uint32_t mNewFrameCount;        // Frames that differed from the one sent before.
+} WeekReplay;
+
+/*============================================================================*/
+// Local function
+/*============================================================================*/
+static bool WeekReplay_Run(WeekReplay *this, uint32_t days);
+static void WeekReplay_OnDeadline(void *pContext);
+static void WeekReplay_OnReadings(int16_t temperature, int16_t humidity);
+static void WeekReplay_GetSensorValue(WeekReplay *this, int16_t *pTemperature, int16_t *pHumidity);
+static void WeekReplay_StartTransfer(WeekReplay *this, uint32_t length);
+static void WeekReplay_AdvertisingEvent(WeekReplay *this);
+static void WeekReplay_PrintDay(WeekReplay *this);
+
+/*============================================================================*/
+// Local variable
+/*============================================================================*/
+static WeekReplay weekReplay;
+
+int main(int argc, char **argv) {
+    unsigned int seed = (argc > 1) ? (unsigned int)strtoul(argv[1], NULL, 0) : REPLAY_SEED;
+    uint32_t days = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : REPLAY_DAYS;
+
+    srand(seed);
+    return WeekReplay_Run(&weekReplay, days) ? 0 : 1;
+}
+
+static bool WeekReplay_Run(WeekReplay *this, uint32_t days) {
+    memset(this, 0, sizeof(*this));
+    this->mSamplesPerDay = (uint32_t)(REPLAY_SECONDS_PER_DAY * 1000 / SAMPLE_INTERVAL_MS);
+
+    // The firmware initialization order of main.c.
+    SoftDeviceSim_Init();
+    TaskScheduler_Init();
+    TimerManager_Init();
+    TimerWheel_Init();
+    SHT31_Init();
+    SampleHistory_Init();
+    Advertising_Init();
+    Advertising_Start(REPLAY_CONN_CFG_TAG);
+    TIMER_HANDLE hTimer = TimerManager_StartPeriodic(WeekReplay_OnDeadline, APP_TIMER_TICKS(SAMPLE_INTERVAL_MS), TIMER_MISSED_POLICY_SKIP, this);
+
+    uint64_t intervalTicks = TimerManager_UsToTicks((uint64_t)Advertising_GetInterval() * 625);
+    this->mNextEventTicks = (uint64_t)rand() % intervalTicks;
+    while (this->mSampleCount < days * this->mSamplesPerDay) {
+        uint64_t nextTicks = this->mNextEventTicks;
+        uint64_t timerTicks;
+        if (TimerManagerSim_GetNextEventTime(&timerTicks) && timerTicks < nextTicks) {
+            nextTicks = timerTicks;
+        }
+        if (this->mIsTwiBusy && this->mTwiDoneTicks < nextTicks) {
+            nextTicks = this->mTwiDoneTicks;
+        }
+
+        TimerManagerSim_AdvanceTo(nextTicks);
+        if (this->mIsTwiBusy && this->mTwiDoneTicks <= nextTicks) {
+            nrf_drv_twi_evt_t event = { .type = NRF_DRV_TWI_EVT_DONE };
+            this->mIsTwiBusy = false;
+            this->mTwiHandler(&event, this->mpTwiContext);
+        }
+        while (TaskScheduler_RunNext()) {}
+        if (this->mNextEventTicks <= nextTicks) {
+            WeekReplay_AdvertisingEvent(this);
+            this->mNextEventTicks += intervalTicks + (uint64_t)rand() % REPLAY_ADV_DELAY_MAX_TICKS;
+        }
+    }
+
+    TIMER_PERIODIC_STATS timerStats;
+    SOFTDEVICE_SIM_STATS simStats;
+    ADVERTISING_STATS advStats;
+    TimerManager_GetPeriodicStats(hTimer, &timerStats);
+    SoftDeviceSim_GetStats(&simStats);
+    Advertising_GetStats(&advStats);
+    bool isPassed = (simStats.mTornFrameCount == 0) && (simStats.mRejectedCount == 0) && (timerStats.mMissedCount == 0);
+    fprintf(stderr, "%u days: samples=%u updates=%u skipped=%u frames=%u new=%u torn=%u rejected=%u missed=%u lateness max=%uus %s\n",
+            days, this->mSampleCount, advStats.mUpdateCount, advStats.mSkippedCount, simStats.mAdvEventCount,
+            this->mNewFrameCount, simStats.mTornFrameCount, simStats.mRejectedCount, timerStats.mMissedCount,
+            TimerManager_TicksToUs(timerStats.mMaxLatenessTicks), isPassed ? "ok" : "FAILED");
+    return isPassed;
+}
+
+/**@brief Sampling deadline, what the application task does on APP_EVT_SAMPLE. */
+static void WeekReplay_OnDeadline(void *pContext) {
+    (void)pContext;
+    SHT31_GetValue(WeekReplay_OnReadings);
+}
+
+/**@brief What onSensorDataReceived does with one sample per publish. */
+static void WeekReplay_OnReadings(int16_t temperature, int16_t humidity) {
+    WeekReplay *this = &weekReplay;
+    SampleHistory_Add(temperature, humidity);
+    Advertising_SetReadings(temperature, humidity);
+    if (++this->mSampleCount % this->mSamplesPerDay == 0) {
+        WeekReplay_PrintDay(this);
+    }
+}
+
+/**@brief Reading of the fake sensor at the current virtual time. */
+static void WeekReplay_GetSensorValue(WeekReplay *this, int16_t *pTemperature, int16_t *pHumidity) {
+    // Triangle wave over the day, lowest at midnight.
+    uint32_t secondOfDay = (uint32_t)((TimerManagerSim_GetTime() / TIMER_TICKS_PER_SECOND) % REPLAY_SECONDS_PER_DAY);
+    uint32_t distance = (secondOfDay < REPLAY_SECONDS_PER_DAY / 2) ? secondOfDay : REPLAY_SECONDS_PER_DAY - secondOfDay;
+    int32_t swing = (int32_t)((2 * (uint64_t)distance * 2 * REPLAY_TEMPERATURE_SWING) / REPLAY_SECONDS_PER_DAY) - REPLAY_TEMPERATURE_SWING;
+
+    this->mTemperatureNoise += rand() % (2 * REPLAY_NOISE_STEP + 1) - REPLAY_NOISE_STEP;
+    this->mHumidityNoise += rand() % (2 * REPLAY_NOISE_STEP + 1) - REPLAY_NOISE_STEP;
+    this->mTemperatureNoise = MAX(MIN(this->mTemperatureNoise, REPLAY_NOISE_MAX), -REPLAY_NOISE_MAX);
+    this->mHumidityNoise = MAX(MIN(this->mHumidityNoise, REPLAY_NOISE_MAX), -REPLAY_NOISE_MAX);
+    *pTemperature = (int16_t)(REPLAY_TEMPERATURE_MEAN + swing + this->mTemperatureNoise);
+    *pHumidity = (int16_t)(REPLAY_HUMIDITY_MEAN - 2 * swing + this->mHumidityNoise);
+}
+
+/**@brief Ends the transfer of the address and length bytes, 9 bits each on the bus, after the time they take. */
+static void WeekReplay_StartTransfer(WeekReplay *this, uint32_t length) {
+    uint32_t ticks = TimerManager_UsToTicks((length + 1) * 9 * REPLAY_TWI_BIT_US);
+    this->mIsTwiBusy = true;
+    this->mTwiDoneTicks = TimerManagerSim_GetTime() + MAX(ticks, 1);
+}
+
+/**@brief Sends a frame, and traces it if it differs from the one sent before. */
+static void WeekReplay_AdvertisingEvent(WeekReplay *this) {
+    uint8_t frame[REPLAY_MAX_FRAME];
+    if (!SoftDeviceSim_AdvertisingEvent()) {
+        return;
+    }
+
+    uint16_t length = SoftDeviceSim_GetFrame(frame);
+    if (length == this->mFrameLength && memcmp(frame, this->mFrame, length) == 0) {
+        return;
+    }
+
+    memcpy(this->mFrame, frame, length);
+    this->mFrameLength = length;
+    this->mNewFrameCount++;
+    uint64_t timeMs = TimerManagerSim_GetTime() * 1000 / TIMER_TICKS_PER_SECOND;
+    printf("%llu frame ", (unsigned long long)timeMs);
+    for (uint16_t i = 0; i < length; i++) {
+        printf("%02x", frame[i]);
+    }
+    printf("\n");
+}
+
+static void WeekReplay_PrintDay(WeekReplay *this) {
+    SOFTDEVICE_SIM_STATS simStats;
+    ADVERTISING_STATS advStats;
+    SoftDeviceSim_GetStats(&simStats);
+    Advertising_GetStats(&advStats);
+    fprintf(stderr, "day %u: samples=%u updates=%u skipped=%u frames=%u new=%u\n", this->mSampleCount / this->mSamplesPerDay,
+            this->mSampleCount, advStats.mUpdateCount, advStats.mSkippedCount, simStats.mAdvEventCount, this->mNewFrameCount);
+}
+
+/*============================================================================*/
+// Fake TWI bus with the sensor behind it
+/*============================================================================*/
+void TWI_Init(nrf_drv_twi_evt_handler_t eventHandler, void *pContext) {
+    weekReplay.mTwiHandler = eventHandler;
+    weekReplay.mpTwiContext = pContext;
+}
+
+void TWI_Tx(uint8_t address, uint8_t const *pData, uint32_t length, bool xfer_pending) {
+    (void)address;
+    (void)pData;
+    (void)xfer_pending;
+    WeekReplay_StartTransfer(&weekReplay, length);
+}
+
+/**@brief Reads the measurement: temperature and humidity as SHT31 raw values. The driver does not check the
+ *        CRC bytes, they are left at 0. */
+void TWI_Rx(uint8_t address, uint8_t const *pData, uint32_t length) {
+    (void)address;
+    WeekReplay *this = &weekReplay;
+    uint8_t *pRxData = (uint8_t*)pData;
+    int16_t temperature;
+    int16_t humidity;
+    WeekReplay_GetSensorValue(this, &temperature, &humidity);
+
+    // Inverse of the SHT31 conversion, rounded so that it gives the readings back.
+    uint16_t rawTemperature = (uint16_t)((((int32_t)temperature + 4500) * 65534 + 17500 / 2) / 17500);
+    uint16_t rawHumidity = (uint16_t)(((int32_t)humidity * 65534 + 10000 / 2) / 10000);
+    if (length >= 6) {
+        pRxData[0] = (uint8_t)(rawTemperature >> 8);
+        pRxData[1] = (uint8_t)rawTemperature;
+        pRxData[2] = 0;
+        pRxData[3] = (uint8_t)(rawHumidity >> 8);
+        pRxData[4] = (uint8_t)rawHumidity;
+        pRxData[5] = 0;
+    }
+    WeekReplay_StartTransfer(this, length);
+}
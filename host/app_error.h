@@ -0,0 +1,28 @@
+#pragma once
+
+/* Host stand-in for the SDK app_error.h. A failed check ends the simulation. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef uint32_t ret_code_t;
+
+#define NRF_SUCCESS                 0
+#define NRF_ERROR_INTERNAL          3
+#define NRF_ERROR_NO_MEM            4
+#define NRF_ERROR_INVALID_STATE     8
+#define NRF_ERROR_INVALID_LENGTH    9
+#define NRF_ERROR_INVALID_PARAM     7
+#define NRF_ERROR_DATA_SIZE         12
+#define NRF_ERROR_BUSY              17
+#define NRF_ERROR_RESOURCES         19
+
+#define APP_ERROR_CHECK(ERR_CODE)                                                           \
+    do {                                                                                    \
+        ret_code_t local_err_code = (ERR_CODE);                                             \
+        if (local_err_code != NRF_SUCCESS) {                                                \
+            printf("%s:%d error %d\n", __FILE__, __LINE__, (int)local_err_code);            \
+            abort();                                                                        \
+        }                                                                                   \
+    } while (0)
@@ -0,0 +1,20 @@
+#pragma once
+
+/* Host stand-in for the SDK app_timer.h. Only what TimerManager.h and its users need. */
+
+#include "app_util.h"
+#include "sdk_config.h"
+#include <stdint.h>
+
+/* Same definitions as the SDK: the RTC runs at APP_TIMER_CLOCK_FREQ / (APP_TIMER_CONFIG_RTC_FREQUENCY + 1). */
+#define APP_TIMER_CLOCK_FREQ 32768
+#define APP_TIMER_MIN_TIMEOUT_TICKS 5
+#define APP_TIMER_TICKS(MS)                                \
+            ((uint32_t)ROUNDED_DIV(                        \
+            (MS) * (uint64_t)APP_TIMER_CLOCK_FREQ,         \
+            1000 * (APP_TIMER_CONFIG_RTC_FREQUENCY + 1)))
+
+typedef enum {
+    APP_TIMER_MODE_SINGLE_SHOT,
+    APP_TIMER_MODE_REPEATED,
+} app_timer_mode_t;
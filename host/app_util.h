@@ -0,0 +1,50 @@
+#pragma once
+
+/* Host stand-in for the SDK app_util.h. */
+
+#include "nordic_common.h"
+#include <stdint.h>
+
+#define STATIC_ASSERT(expr, ...) _Static_assert(expr, #expr)
+
+#define UNIT_0_625_MS 625
+#define UNIT_1_25_MS 1250
+#define UNIT_10_MS 10000
+#define ROUNDED_DIV(A, B) (((A) + ((B) / 2)) / (B))
+#define MSEC_TO_UNITS(TIME, RESOLUTION) (((TIME) * 1000) / (RESOLUTION))
+
+static inline uint8_t uint16_encode(uint16_t value, uint8_t *p_encoded_data) {
+    p_encoded_data[0] = (uint8_t)value;
+    p_encoded_data[1] = (uint8_t)(value >> 8);
+    return sizeof(uint16_t);
+}
+
+static inline uint8_t uint32_encode(uint32_t value, uint8_t *p_encoded_data) {
+    p_encoded_data[0] = (uint8_t)value;
+    p_encoded_data[1] = (uint8_t)(value >> 8);
+    p_encoded_data[2] = (uint8_t)(value >> 16);
+    p_encoded_data[3] = (uint8_t)(value >> 24);
+    return sizeof(uint32_t);
+}
+
+static inline uint32_t uint32_decode(const uint8_t *p_encoded_data) {
+    return (uint32_t)p_encoded_data[0] | ((uint32_t)p_encoded_data[1] << 8) |
+           ((uint32_t)p_encoded_data[2] << 16) | ((uint32_t)p_encoded_data[3] << 24);
+}
+
+static inline uint16_t uint16_decode(const uint8_t *p_encoded_data) {
+    return (uint16_t)(p_encoded_data[0] | (p_encoded_data[1] << 8));
+}
+
+static inline uint8_t uint32_big_encode(uint32_t value, uint8_t *p_encoded_data) {
+    p_encoded_data[0] = (uint8_t)(value >> 24);
+    p_encoded_data[1] = (uint8_t)(value >> 16);
+    p_encoded_data[2] = (uint8_t)(value >> 8);
+    p_encoded_data[3] = (uint8_t)value;
+    return sizeof(uint32_t);
+}
+
+static inline uint32_t uint32_big_decode(const uint8_t *p_encoded_data) {
+    return ((uint32_t)p_encoded_data[0] << 24) | ((uint32_t)p_encoded_data[1] << 16) |
+           ((uint32_t)p_encoded_data[2] << 8) | (uint32_t)p_encoded_data[3];
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+/* Host stand-in for the SDK app_util_platform.h. The simulation is single threaded. */
+
+#define CRITICAL_REGION_ENTER() {
+#define CRITICAL_REGION_EXIT() }
+
+#define APP_IRQ_PRIORITY_HIGH 2
+#define APP_IRQ_PRIORITY_LOW 6
@@ -0,0 +1,163 @@
+#pragma once
+
+/* Host stand-in for the SoftDevice ble.h and the GATT headers it pulls in. Implemented by SoftDeviceSim.c. */
+
+#include "ble_gap.h"
+#include <stdint.h>
+
+#define BLE_ERROR_INVALID_CONN_HANDLE 0x3002
+#define BLE_ERROR_GATTS_SYS_ATTR_MISSING 0x3401
+
+#define BLE_UUID_TYPE_BLE 0x01
+#define BLE_UUID_TYPE_VENDOR_BEGIN 0x02
+
+#define BLE_GATT_ATT_MTU_DEFAULT 23
+#define BLE_GATT_HVX_NOTIFICATION 0x01
+#define BLE_GATTS_SRVC_TYPE_PRIMARY 0x01
+
+#define BLE_GATTC_EVT_EXCHANGE_MTU_RSP 0x3A
+#define BLE_GATTC_EVT_TIMEOUT 0x3B
+#define BLE_GATTS_EVT_WRITE 0x50
+#define BLE_GATTS_EVT_SYS_ATTR_MISSING 0x52
+#define BLE_GATTS_EVT_EXCHANGE_MTU_REQUEST 0x55
+#define BLE_GATTS_EVT_TIMEOUT 0x56
+#define BLE_GATTS_EVT_HVN_TX_COMPLETE 0x57
+
+#define BLE_CONN_CFG_GAP 0x20
+#define BLE_CONN_CFG_GATTC 0x21
+#define BLE_CONN_CFG_GATTS 0x22
+#define BLE_CONN_CFG_GATT 0x23
+#define BLE_COMMON_OPT_CONN_EVT_EXT 0x02
+
+typedef struct {
+    uint16_t uuid;
+    uint8_t type;
+} ble_uuid_t;
+
+typedef struct {
+    uint8_t uuid128[16];
+} ble_uuid128_t;
+
+#define BLE_UUID_BLE_ASSIGN(instance, value) do { (instance).type = BLE_UUID_TYPE_BLE; (instance).uuid = (value); } while (0)
+
+typedef struct {
+    uint16_t value_handle;
+    uint16_t user_desc_handle;
+    uint16_t cccd_handle;
+    uint16_t sccd_handle;
+} ble_gatts_char_handles_t;
+
+typedef struct {
+    uint16_t len;
+    uint16_t offset;
+    uint8_t *p_value;
+} ble_gatts_value_t;
+
+typedef struct {
+    uint16_t handle;
+    uint8_t type;
+    uint16_t offset;
+    uint16_t *p_len;
+    uint8_t const *p_data;
+} ble_gatts_hvx_params_t;
+
+typedef struct {
+    uint16_t handle;
+    ble_uuid_t uuid;
+    uint8_t op;
+    uint8_t auth_required;
+    uint16_t offset;
+    uint16_t len;
+    uint8_t data[1];  /**< Variable length, the event buffer holds len bytes. */
+} ble_gatts_evt_write_t;
+
+typedef struct {
+    uint16_t client_rx_mtu;
+} ble_gatts_evt_exchange_mtu_request_t;
+
+typedef struct {
+    uint8_t count;
+} ble_gatts_evt_hvn_tx_complete_t;
+
+typedef struct {
+    uint16_t conn_handle;
+    union {
+        ble_gatts_evt_write_t write;
+        ble_gatts_evt_exchange_mtu_request_t exchange_mtu_request;
+        ble_gatts_evt_hvn_tx_complete_t hvn_tx_complete;
+    } params;
+} ble_gatts_evt_t;
+
+typedef struct {
+    uint16_t server_rx_mtu;
+} ble_gattc_evt_exchange_mtu_rsp_t;
+
+typedef struct {
+    uint16_t conn_handle;
+    uint16_t gatt_status;
+    union {
+        ble_gattc_evt_exchange_mtu_rsp_t exchange_mtu_rsp;
+    } params;
+} ble_gattc_evt_t;
+
+typedef struct {
+    uint16_t evt_id;
+    uint16_t evt_len;
+} ble_evt_hdr_t;
+
+typedef struct {
+    ble_evt_hdr_t header;
+    union {
+        ble_gap_evt_t gap_evt;
+        ble_gattc_evt_t gattc_evt;
+        ble_gatts_evt_t gatts_evt;
+    } evt;
+} ble_evt_t;
+
+typedef struct {
+    uint8_t conn_count;
+    uint16_t event_length;
+} ble_gap_conn_cfg_t;
+
+typedef struct {
+    uint16_t att_mtu;
+} ble_gatt_conn_cfg_t;
+
+typedef struct {
+    uint8_t hvn_tx_queue_size;
+} ble_gatts_conn_cfg_t;
+
+typedef struct {
+    uint8_t conn_cfg_tag;
+    union {
+        ble_gap_conn_cfg_t gap_conn_cfg;
+        ble_gatt_conn_cfg_t gatt_conn_cfg;
+        ble_gatts_conn_cfg_t gatts_conn_cfg;
+    } params;
+} ble_conn_cfg_t;
+
+typedef union {
+    ble_conn_cfg_t conn_cfg;
+} ble_cfg_t;
+
+typedef struct {
+    uint8_t enable : 1;
+} ble_common_opt_conn_evt_ext_t;
+
+typedef struct {
+    ble_common_opt_conn_evt_ext_t conn_evt_ext;
+} ble_common_opt_t;
+
+typedef union {
+    ble_common_opt_t common_opt;
+} ble_opt_t;
+
+uint32_t sd_ble_cfg_set(uint32_t cfg_id, ble_cfg_t const *p_cfg, uint32_t app_ram_base);
+uint32_t sd_ble_opt_set(uint32_t opt_id, ble_opt_t const *p_opt);
+uint32_t sd_ble_uuid_vs_add(ble_uuid128_t const *p_vs_uuid, uint8_t *p_uuid_type);
+uint32_t sd_ble_gatts_service_add(uint8_t type, ble_uuid_t const *p_uuid, uint16_t *p_handle);
+uint32_t sd_ble_gatts_value_set(uint16_t conn_handle, uint16_t handle, ble_gatts_value_t *p_value);
+uint32_t sd_ble_gatts_hvx(uint16_t conn_handle, ble_gatts_hvx_params_t const *p_hvx_params);
+uint32_t sd_ble_gatts_sys_attr_set(uint16_t conn_handle, uint8_t const *p_sys_attr_data, uint16_t len, uint32_t flags);
+uint32_t sd_ble_gatts_exchange_mtu_reply(uint16_t conn_handle, uint16_t server_rx_mtu);
+uint32_t sd_ble_gattc_exchange_mtu_request(uint16_t conn_handle, uint16_t client_rx_mtu);
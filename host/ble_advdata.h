@@ -0,0 +1,26 @@
+#pragma once
+
+/* Host stand-in for the SDK ble_advdata.h. The encoder in SoftDeviceSim.c supports flags and service data only. */
+
+#include "app_error.h"
+#include "ble_gap.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint16_t size;
+    uint8_t *p_data;
+} uint8_array_t;
+
+typedef struct {
+    uint16_t service_uuid;
+    uint8_array_t data;
+} ble_advdata_service_data_t;
+
+typedef struct {
+    uint8_t flags;
+    ble_advdata_service_data_t *p_service_data_array;
+    uint8_t service_data_count;
+} ble_advdata_t;
+
+ret_code_t ble_advdata_encode(ble_advdata_t const *p_advdata, uint8_t *p_encoded_data, uint16_t *p_len);
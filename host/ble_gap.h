@@ -0,0 +1,174 @@
+#pragma once
+
+/* Host stand-in for the SoftDevice ble_gap.h. Implemented by SoftDeviceSim.c. */
+
+#include <stdint.h>
+
+#define BLE_CONN_HANDLE_INVALID 0xFFFF
+
+#define BLE_GAP_ADV_SET_HANDLE_NOT_SET 0xFF
+#define BLE_GAP_ADV_SET_DATA_SIZE_MAX 31
+#define BLE_GAP_ADV_SET_DATA_SIZE_EXTENDED_MAX_SUPPORTED 255
+#define BLE_GAP_ADV_SET_DATA_SIZE_EXTENDED_CONNECTABLE_MAX_SUPPORTED 238
+
+#define BLE_GAP_ADV_TYPE_CONNECTABLE_SCANNABLE_UNDIRECTED 0x01
+#define BLE_GAP_ADV_TYPE_NONCONNECTABLE_SCANNABLE_UNDIRECTED 0x04
+#define BLE_GAP_ADV_TYPE_NONCONNECTABLE_NONSCANNABLE_UNDIRECTED 0x05
+#define BLE_GAP_ADV_TYPE_EXTENDED_CONNECTABLE_NONSCANNABLE_UNDIRECTED 0x06
+#define BLE_GAP_ADV_TYPE_EXTENDED_NONCONNECTABLE_NONSCANNABLE_UNDIRECTED 0x0A
+#define BLE_GAP_ADV_FP_ANY 0x00
+
+#define BLE_GAP_PHY_AUTO 0x00
+#define BLE_GAP_PHY_1MBPS 0x01
+#define BLE_GAP_PHY_2MBPS 0x02
+#define BLE_GAP_PHY_CODED 0x04
+
+#define BLE_GAP_TX_POWER_ROLE_ADV 1
+#define BLE_GAP_TX_POWER_ROLE_CONN 2
+
+#define BLE_GAP_AD_TYPE_FLAGS 0x01
+#define BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE 0x06
+#define BLE_GAP_AD_TYPE_SERVICE_DATA 0x16
+
+#define BLE_GAP_EVT_CONNECTED 0x10
+#define BLE_GAP_EVT_DISCONNECTED 0x11
+#define BLE_GAP_EVT_CONN_PARAM_UPDATE 0x12
+#define BLE_GAP_EVT_SEC_PARAMS_REQUEST 0x13
+#define BLE_GAP_EVT_PHY_UPDATE_REQUEST 0x21
+#define BLE_GAP_EVT_PHY_UPDATE 0x22
+#define BLE_GAP_EVT_DATA_LENGTH_UPDATE_REQUEST 0x23
+#define BLE_GAP_EVT_DATA_LENGTH_UPDATE 0x24
+
+#define BLE_GAP_SEC_STATUS_PAIRING_NOT_SUPP 0x85
+#define BLE_GAP_DATA_LENGTH_AUTO 0
+#define BLE_GAP_DATA_LENGTH_DEFAULT 27
+#define BLE_GAP_DATA_LENGTH_MAX 251
+
+typedef struct {
+    uint8_t addr_type;
+    uint8_t addr[6];
+} ble_gap_addr_t;
+
+typedef uint8_t ble_gap_ch_mask_t[5];
+
+typedef struct {
+    uint8_t type;
+    uint8_t anonymous;
+    uint8_t include_tx_power;
+} ble_gap_adv_properties_t;
+
+typedef struct {
+    ble_gap_adv_properties_t properties;
+    ble_gap_addr_t const *p_peer_addr;
+    uint32_t interval;
+    uint16_t duration;
+    uint8_t max_adv_evts;
+    ble_gap_ch_mask_t channel_mask;
+    uint8_t filter_policy;
+    uint8_t primary_phy;
+    uint8_t secondary_phy;
+    uint8_t set_id;
+    uint8_t scan_req_notification;
+} ble_gap_adv_params_t;
+
+typedef struct {
+    uint8_t *p_data;
+    uint16_t len;
+} ble_data_t;
+
+typedef struct {
+    ble_data_t adv_data;
+    ble_data_t scan_rsp_data;
+} ble_gap_adv_data_t;
+
+uint32_t sd_ble_gap_adv_set_configure(uint8_t *p_adv_handle, ble_gap_adv_data_t const *p_adv_data, ble_gap_adv_params_t const *p_adv_params);
+uint32_t sd_ble_gap_adv_start(uint8_t adv_handle, uint8_t conn_cfg_tag);
+uint32_t sd_ble_gap_adv_stop(uint8_t adv_handle);
+uint32_t sd_ble_gap_tx_power_set(uint8_t role, uint16_t handle, int8_t tx_power);
+
+typedef struct {
+    uint16_t min_conn_interval;
+    uint16_t max_conn_interval;
+    uint16_t slave_latency;
+    uint16_t conn_sup_timeout;
+} ble_gap_conn_params_t;
+
+typedef struct {
+    uint8_t sm : 4;
+    uint8_t lv : 4;
+} ble_gap_conn_sec_mode_t;
+
+#define BLE_GAP_CONN_SEC_MODE_SET_OPEN(ptr) do { (ptr)->sm = 1; (ptr)->lv = 1; } while (0)
+
+typedef struct {
+    uint8_t tx_phys;
+    uint8_t rx_phys;
+} ble_gap_phys_t;
+
+typedef struct {
+    uint16_t max_tx_octets;
+    uint16_t max_rx_octets;
+    uint16_t max_tx_time_us;
+    uint16_t max_rx_time_us;
+} ble_gap_data_length_params_t;
+
+typedef struct {
+    uint16_t tx_payload_limited_octets;
+    uint16_t rx_payload_limited_octets;
+    uint16_t tx_rx_time_limited_us;
+} ble_gap_data_length_limitation_t;
+
+typedef struct {
+    ble_gap_addr_t peer_addr;
+    uint8_t role;
+    ble_gap_conn_params_t conn_params;
+    uint8_t adv_handle;
+} ble_gap_evt_connected_t;
+
+typedef struct {
+    uint8_t reason;
+} ble_gap_evt_disconnected_t;
+
+typedef struct {
+    ble_gap_conn_params_t conn_params;
+} ble_gap_evt_conn_param_update_t;
+
+typedef struct {
+    ble_gap_phys_t peer_preferred_phys;
+} ble_gap_evt_phy_update_request_t;
+
+typedef struct {
+    uint8_t status;
+    uint8_t tx_phy;
+    uint8_t rx_phy;
+} ble_gap_evt_phy_update_t;
+
+typedef struct {
+    ble_gap_data_length_params_t peer_params;
+} ble_gap_evt_data_length_update_request_t;
+
+typedef struct {
+    ble_gap_data_length_params_t effective_params;
+} ble_gap_evt_data_length_update_t;
+
+typedef struct {
+    uint16_t conn_handle;
+    union {
+        ble_gap_evt_connected_t connected;
+        ble_gap_evt_disconnected_t disconnected;
+        ble_gap_evt_conn_param_update_t conn_param_update;
+        ble_gap_evt_phy_update_request_t phy_update_request;
+        ble_gap_evt_phy_update_t phy_update;
+        ble_gap_evt_data_length_update_request_t data_length_update_request;
+        ble_gap_evt_data_length_update_t data_length_update;
+    } params;
+} ble_gap_evt_t;
+
+uint32_t sd_ble_gap_device_name_set(ble_gap_conn_sec_mode_t const *p_write_perm, uint8_t const *p_dev_name, uint16_t len);
+uint32_t sd_ble_gap_ppcp_set(ble_gap_conn_params_t const *p_conn_params);
+uint32_t sd_ble_gap_conn_param_update(uint16_t conn_handle, ble_gap_conn_params_t const *p_conn_params);
+uint32_t sd_ble_gap_phy_update(uint16_t conn_handle, ble_gap_phys_t const *p_gap_phys);
+uint32_t sd_ble_gap_data_length_update(uint16_t conn_handle, ble_gap_data_length_params_t const *p_dl_params,
+                                       ble_gap_data_length_limitation_t *p_dl_limitation);
+uint32_t sd_ble_gap_sec_params_reply(uint16_t conn_handle, uint8_t sec_status, void const *p_sec_params, void const *p_sec_keyset);
+uint32_t sd_ble_gap_disconnect(uint16_t conn_handle, uint8_t hci_status_code);
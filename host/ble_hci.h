@@ -0,0 +1,7 @@
+#pragma once
+
+/* Host stand-in for the SoftDevice ble_hci.h. */
+
+#define BLE_HCI_CONNECTION_TIMEOUT 0x08
+#define BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION 0x13
+#define BLE_HCI_LOCAL_HOST_TERMINATED_CONNECTION 0x16
@@ -0,0 +1,45 @@
+#pragma once
+
+/* Host stand-in for the SDK ble_srv_common.h. characteristic_add is implemented by SoftDeviceSim.c. */
+
+#include "ble.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BLE_CCCD_VALUE_LEN 2
+
+typedef enum {
+    SEC_NO_ACCESS,
+    SEC_OPEN,
+    SEC_JUST_WORKS,
+    SEC_MITM,
+} security_req_t;
+
+typedef struct {
+    uint8_t broadcast : 1;
+    uint8_t read : 1;
+    uint8_t write_wo_resp : 1;
+    uint8_t write : 1;
+    uint8_t notify : 1;
+    uint8_t indicate : 1;
+    uint8_t auth_signed_wr : 1;
+} ble_gatt_char_props_t;
+
+typedef struct {
+    uint16_t uuid;
+    uint8_t uuid_type;
+    uint16_t max_len;
+    uint16_t init_len;
+    uint8_t *p_init_value;
+    bool is_var_len;
+    ble_gatt_char_props_t char_props;
+    bool is_defered_read;
+    bool is_defered_write;
+    security_req_t read_access;
+    security_req_t write_access;
+    security_req_t cccd_write_access;
+    bool is_value_user;
+} ble_add_char_params_t;
+
+uint32_t characteristic_add(uint16_t service_handle, ble_add_char_params_t *p_char_props, ble_gatts_char_handles_t *p_char_handle);
+bool ble_srv_is_notification_enabled(uint8_t const *p_encoded_data);
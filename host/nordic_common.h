@@ -0,0 +1,10 @@
+#pragma once
+
+/* Host stand-in for the SDK nordic_common.h. */
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+
+/* Host stand-in for the device header. The cycle counter reads as 0, so runtime figures are not simulated, unless
+ * HOST_CYCLE_COUNTER is set: it then counts host nanoseconds, for benches timing firmware code. */
+
+#include <stdint.h>
+#if HOST_CYCLE_COUNTER
+#include <time.h>
+#endif
+
+typedef struct {
+    uint32_t CTRL;
+    uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    uint32_t DEMCR;
+} CoreDebug_Type;
+
+static DWT_Type simDwt;
+static CoreDebug_Type simCoreDebug;
+
+#if HOST_CYCLE_COUNTER
+static inline DWT_Type *SimDwt_Get(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    simDwt.CYCCNT = (uint32_t)((uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec);
+    return &simDwt;
+}
+#define DWT (SimDwt_Get())
+#else
+#define DWT (&simDwt)
+#endif
+#define CoreDebug (&simCoreDebug)
+#define DWT_CTRL_CYCCNTENA_Msk 0
+#define CoreDebug_DEMCR_TRCENA_Msk 0
+#define SystemCoreClock 64000000UL
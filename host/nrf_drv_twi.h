@@ -0,0 +1,17 @@
+#pragma once
+
+/* Host stand-in for the SDK nrf_drv_twi.h. The test driver provides the TWI.h functions and raises the events. */
+
+#include <stdint.h>
+
+typedef enum {
+    NRF_DRV_TWI_EVT_DONE,
+    NRF_DRV_TWI_EVT_ADDRESS_NACK,
+    NRF_DRV_TWI_EVT_DATA_NACK,
+} nrf_drv_twi_evt_type_t;
+
+typedef struct {
+    nrf_drv_twi_evt_type_t type;
+} nrf_drv_twi_evt_t;
+
+typedef void (*nrf_drv_twi_evt_handler_t)(nrf_drv_twi_evt_t const *p_event, void *p_context);
@@ -0,0 +1,11 @@
+#pragma once
+
+/* Host stand-in for the SDK nrf_nvic.h. Only the interrupts SoftDeviceSim.c raises are modelled. */
+
+#include "nrf_soc.h"
+#include <stdint.h>
+
+uint32_t sd_nvic_ClearPendingIRQ(IRQn_Type IRQn);
+uint32_t sd_nvic_SetPriority(IRQn_Type IRQn, uint32_t priority);
+uint32_t sd_nvic_EnableIRQ(IRQn_Type IRQn);
+uint32_t sd_nvic_DisableIRQ(IRQn_Type IRQn);
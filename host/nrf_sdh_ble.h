@@ -0,0 +1,20 @@
+#pragma once
+
+/* Host stand-in for the SDK nrf_sdh_ble.h. Observers register with SoftDeviceSim before main runs, which
+ * dispatches every event to them in priority order like the SoftDevice handler does. */
+
+#include "app_error.h"
+#include "ble.h"
+#include "sdk_config.h"
+
+typedef void (*nrf_sdh_ble_evt_handler_t)(ble_evt_t const *p_ble_evt, void *p_context);
+
+void SoftDeviceSim_AddObserver(uint8_t priority, nrf_sdh_ble_evt_handler_t handler, void *pContext);
+
+#define NRF_SDH_BLE_OBSERVER(_name, _prio, _handler, _context)                  \
+    static void _name##_register(void) __attribute__((constructor));            \
+    static void _name##_register(void) {                                        \
+        SoftDeviceSim_AddObserver(_prio, _handler, _context);                   \
+    }
+
+ret_code_t nrf_sdh_ble_default_cfg_set(uint8_t conn_cfg_tag, uint32_t *p_ram_start);
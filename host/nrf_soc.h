@@ -0,0 +1,47 @@
+#pragma once
+
+/* Host stand-in for the SDK nrf_soc.h. Firmware modules get printf through it. The ECB is implemented by
+ * Aes128.c, the random number generator and the radio notification by SoftDeviceSim.c. */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define SOC_ECB_KEY_LENGTH 16
+#define SOC_ECB_CLEARTEXT_LENGTH 16
+#define SOC_ECB_CIPHERTEXT_LENGTH 16
+
+typedef struct {
+    uint8_t key[SOC_ECB_KEY_LENGTH];
+    uint8_t cleartext[SOC_ECB_CLEARTEXT_LENGTH];
+    uint8_t ciphertext[SOC_ECB_CIPHERTEXT_LENGTH];
+} nrf_ecb_hal_data_t;
+
+uint32_t sd_ecb_block_encrypt(nrf_ecb_hal_data_t *p_ecb_data);
+uint32_t sd_rand_application_bytes_available_get(uint8_t *p_bytes_available);
+uint32_t sd_rand_application_vector_get(uint8_t *p_buff, uint8_t length);
+
+enum {
+    NRF_RADIO_NOTIFICATION_TYPE_NONE,
+    NRF_RADIO_NOTIFICATION_TYPE_INT_ON_ACTIVE,
+    NRF_RADIO_NOTIFICATION_TYPE_INT_ON_INACTIVE,
+    NRF_RADIO_NOTIFICATION_TYPE_INT_ON_BOTH,
+};
+
+enum {
+    NRF_RADIO_NOTIFICATION_DISTANCE_NONE,
+    NRF_RADIO_NOTIFICATION_DISTANCE_800US,
+    NRF_RADIO_NOTIFICATION_DISTANCE_1740US,
+    NRF_RADIO_NOTIFICATION_DISTANCE_2680US,
+    NRF_RADIO_NOTIFICATION_DISTANCE_3620US,
+    NRF_RADIO_NOTIFICATION_DISTANCE_4560US,
+    NRF_RADIO_NOTIFICATION_DISTANCE_5500US,
+};
+
+typedef int IRQn_Type;
+
+#define SWI1_EGU1_IRQn 21
+#define RADIO_NOTIFICATION_IRQn SWI1_EGU1_IRQn
+#define RADIO_NOTIFICATION_IRQHandler SWI1_EGU1_IRQHandler
+
+void RADIO_NOTIFICATION_IRQHandler(void);
+uint32_t sd_radio_notification_cfg_set(uint8_t type, uint8_t distance);
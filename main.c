@@ -64,89 +64,251 @@
 #include "nrf_delay.h"
 
 #include "SHT31.h"
+#include "Advertising.h"
+#include "AdvPolicy.h"
+#include "SampleHistory.h"
 #include "TimerManager.h"
+#include "TimerWheel.h"
+#include "TaskScheduler.h"
+#include "CycleCounter.h"
+#if ENV_SENSING_ENABLED
+#include "Connection.h"
+#include "EnvSensing.h"
+#endif
+#if HISTORY_TRANSFER_ENABLED
+#include "HistoryTransfer.h"
+#endif
+#if RADIO_SYNC_ENABLED
+#include "RadioSync.h"
+#endif
+#if ADVERTISING_ROTATION_ENABLED
+#include "FrameRotation.h"
+#endif
+#if RADIO_PROFILE_ENABLED
+#include "RadioProfile.h"
+#endif
+#if DEFERRED_EXECUTION_ENABLED
+#include "app_scheduler.h"
+#endif
 
 /******************************************************************************
  * Local function declarations
  ******************************************************************************/
 static void onSensorDataReceived(int16_t temperature, int16_t humidity);
+static void advertising_start(void);
 
 /*============================================================================*/
 // define
 /*============================================================================*/
 #define APP_BLE_CONN_CFG_TAG            1                                  /**< A tag identifying the SoftDevice BLE configuration. */
-#define NON_CONNECTABLE_ADV_INTERVAL    MSEC_TO_UNITS(100, UNIT_0_625_MS)  /**< The advertising interval for non-connectable advertisement (100 ms). This value can vary between 100ms to 10.24s). */
-#define TIMER_FUNCTION_MS APP_TIMER_TICKS(1000)
-#define DATA_SCHEMA_VERSION             0x01                               /**< Reserved area. */
-#define DEVICE_IDENTIFIER               0x11, 0x22, 0x33, 0x44             /**< Temporary value. */
-#define DATA_TYPE_TEMPERATURE           0x10                               /**< temperature (unit:0.01) */
-#define DATA_TYPE_HUMIDITY              0x11                               /**< humidity    (unit:0.01) */
-#define OPEN_SENSOR_SERVICE_UUID        0xFCBE                             /**< Assigned number by Musen connect. */
+#define TIMER_FUNCTION_MS APP_TIMER_TICKS(SAMPLE_INTERVAL_MS)
+#define APP_TASK_PRIORITY               2                                  /**< Priority of the application task, below the sensor drivers. */
+#define APP_EVT_SAMPLE                  (1UL << 0)                         /**< Application task event: sampling deadline reached. */
+#define APP_EVT_CONNECTED               (1UL << 1)                         /**< Application task event: a central connected. */
+#define APP_EVT_DISCONNECTED            (1UL << 2)                         /**< Application task event: the central disconnected. */
 #define DEAD_BEEF                       0xDEADBEEF                         /**< Value used as error code on stack dump, can be used to identify stack location on stack unwind. */
+#define SAMPLES_PER_PUBLISH             (PUBLISH_INTERVAL_MS / SAMPLE_INTERVAL_MS)  /**< Samples averaged into each published one. */
+STATIC_ASSERT(SAMPLE_INTERVAL_MS >= 20);                         // A measurement takes 16 ms.
+STATIC_ASSERT(PUBLISH_INTERVAL_MS >= SAMPLE_INTERVAL_MS);
+STATIC_ASSERT(PUBLISH_INTERVAL_MS % SAMPLE_INTERVAL_MS == 0);   // Every published sample is the mean of the same number of samples.
+STATIC_ASSERT(PUBLISH_INTERVAL_MS <= UINT16_MAX);               // Sent on 2 bytes in the device metadata.
+#if ENV_SENSING_ENABLED
+#define TIMER_CONNECTED_MS              APP_TIMER_TICKS(ENV_SENSING_SAMPLE_INTERVAL_MS)
+#define SAMPLES_PER_PUBLISH_CONNECTED   (PUBLISH_INTERVAL_MS / ENV_SENSING_SAMPLE_INTERVAL_MS)  /**< Samples streamed while connected for each one published. */
+STATIC_ASSERT(ENV_SENSING_SAMPLE_INTERVAL_MS >= 20);             // A measurement takes 16 ms.
+STATIC_ASSERT(PUBLISH_INTERVAL_MS % ENV_SENSING_SAMPLE_INTERVAL_MS == 0);  // The history keeps its interval while connected.
+#endif
+#if DEFERRED_EXECUTION_ENABLED
+#define SCHED_MAX_EVENT_DATA_SIZE       APP_TIMER_SCHED_EVENT_DATA_SIZE    /**< Maximum size of scheduler events. */
+#define SCHED_QUEUE_SIZE                DEFERRED_QUEUE_SIZE                /**< Maximum number of events in the scheduler queue. */
+#endif
 
 /*============================================================================*/
 // Local variable
 /*============================================================================*/
-static ble_gap_adv_params_t m_adv_params;                                  /**< Parameters to be passed to the stack when starting advertising. */
-static uint8_t              m_adv_handle = BLE_GAP_ADV_SET_HANDLE_NOT_SET; /**< Advertising handle used to identify an advertising set. */
-static uint8_t              m_enc_advdata[BLE_GAP_ADV_SET_DATA_SIZE_MAX];  /**< Buffer for storing an encoded advertising set. */
+static TASK_ID              m_app_task;                                    /**< Task running the application logic. */
+static TIMER_HANDLE         m_main_timer;                                  /**< Timer driving the periodic sensor reading on a fixed deadline grid. */
+static int32_t              m_temperature_sum;                             /**< Sum of the samples taken since the last one published. */
+static int32_t              m_humidity_sum;
+static uint32_t             m_sample_count;                                /**< Samples taken since the last one published. */
+#if ENV_SENSING_ENABLED
+static bool                 m_is_connected;                                /**< A central is connected, the sensor runs at ENV_SENSING_SAMPLE_INTERVAL_MS. */
+#endif
+#if ADVERTISING_ROTATION_ENABLED
+static uint64_t             m_uptime_ticks;                                /**< RTC ticks since the reset, up to m_uptime_mark. */
+static uint32_t             m_uptime_mark;
+#endif
+
+/**@brief Mean of count samples, rounded to the nearest unit. */
+static int16_t sample_mean(int32_t sum, uint32_t count)
+{
+    int32_t half = (int32_t)(count / 2);
+    return (int16_t)(((sum < 0) ? (sum - half) : (sum + half)) / (int32_t)count);
+}
 
-static uint8_t m_beacon_info[] =                    /**< Information advertised by the Beacon. */
+/**@brief Drops the samples taken since the last one published, when the sampling interval changes. */
+static void sample_mean_reset(void)
 {
-    DATA_SCHEMA_VERSION, 
-    DEVICE_IDENTIFIER, 
-    DATA_TYPE_TEMPERATURE,
-    /** The following 2 bytes are temperature data **/
-    0x00,
-    0x00,
-    DATA_TYPE_HUMIDITY,
-    /** The following 2 bytes are humidity data **/
-    0x00,
-    0x00,
-};
-
-/**@brief Struct that contains pointers to the encoded advertising data. */
-static ble_gap_adv_data_t m_adv_data =
+    m_temperature_sum = 0;
+    m_humidity_sum = 0;
+    m_sample_count = 0;
+}
+
+#if ADVERTISING_ROTATION_ENABLED
+/**@brief Hands the device health over to the health frame, once per published sample.
+ *
+ * @details The RTC wraps after 1024 s, the uptime is kept by adding the ticks elapsed since the last call,
+ *          which is at most PUBLISH_INTERVAL_MS ago.
+ */
+static void health_update(void)
 {
-    .adv_data =
-    {
-        .p_data = m_enc_advdata,
-        .len    = BLE_GAP_ADV_SET_DATA_SIZE_MAX
-    },
-    .scan_rsp_data =
-    {
-        .p_data = NULL,
-        .len    = 0
+    uint32_t elapsed = TimerManager_GetTicksSince(m_uptime_mark);
+    m_uptime_mark += elapsed;
+    m_uptime_ticks += elapsed;
 
-    }
-};
+    int32_t dieTemperature = 0;
+    ret_code_t err_code = sd_temp_get(&dieTemperature);
+    APP_ERROR_CHECK(err_code);
 
-static void onSensorDataReceived(int16_t temperature, int16_t humidity) {
-    printf("%s(%d) temperature:%d\n", __func__, __LINE__, temperature);
-    printf("%s(%d) humidity:%d\n", __func__, __LINE__, humidity);
+    TIMER_PERIODIC_STATS stats;
+    TimerManager_GetPeriodicStats(m_main_timer, &stats);
 
-    ble_advdata_t advdata;
+    ADVERTISING_HEALTH health;
+    health.mUptimeS = (uint32_t)(m_uptime_ticks / TIMER_TICKS_PER_SECOND);
+    health.mDieTemperature = (int16_t)dieTemperature;
+    health.mMissedCount = stats.mMissedCount;
+    Advertising_SetHealth(&health);
+}
+#endif
 
-    m_beacon_info[6] = (uint8_t)((temperature >> 8) & 0x00FF);
-    m_beacon_info[7] = (uint8_t)((temperature >> 0) & 0x00FF);
+#if RADIO_PROFILE_ENABLED
+/**@brief Applies the channels and the transmit power of a profile to the advertising, and counts the next
+ *        advertising events for it. Can be called at any time.
+ */
+static void radio_profile_set(RADIO_PROFILE profile)
+{
+    RADIO_PROFILE_CONFIG const *pConfig = RadioProfile_GetConfig(profile);
+    Advertising_SetRadio(pConfig->mChannels, pConfig->mTxPower);
+    RadioProfile_Set(profile);
+    NRF_LOG_INFO("[radio]profile=%s channels=%d power=%ddBm charge=%dnC/event", pConfig->mpName, pConfig->mChannels,
+                 pConfig->mTxPower, RadioProfile_GetEventChargeNc(profile));
+}
+#endif
 
-    m_beacon_info[9] = (uint8_t)((humidity >> 8) & 0x00FF);
-    m_beacon_info[10] = (uint8_t)((humidity >> 0) & 0x00FF);
+#if RADIO_SYNC_ENABLED
+/**@brief Runs on the radio notification of every advertising event. */
+static void advertising_event_handler(void)
+{
+#if RADIO_PROFILE_ENABLED
+    RadioProfile_OnAdvertisingEvent();
+#endif
+#if ADVERTISING_ROTATION_ENABLED
+    Advertising_OnAdvertisingEvent();
+#endif
+}
+#endif
 
-    ble_advdata_service_data_t service_data;
-    service_data.service_uuid = OPEN_SENSOR_SERVICE_UUID;
-    service_data.data.p_data = &m_beacon_info[0];
-    service_data.data.size = sizeof(m_beacon_info);
+static void onSensorDataReceived(int16_t temperature, int16_t humidity) {
+    temperature += SENSOR_TEMPERATURE_OFFSET;
+    humidity += SENSOR_HUMIDITY_OFFSET;
+    uint32_t samplesPerPublish = SAMPLES_PER_PUBLISH;
+#if ENV_SENSING_ENABLED
+    EnvSensing_SetReadings(temperature, humidity);
+    if (m_is_connected) {
+        samplesPerPublish = SAMPLES_PER_PUBLISH_CONNECTED;
+    }
+#endif
+    // Every sample is taken into the mean, the history and the advertised frame get one per PUBLISH_INTERVAL_MS.
+    m_temperature_sum += temperature;
+    m_humidity_sum += humidity;
+    if (++m_sample_count < samplesPerPublish) {
+        return;
+    }
+    temperature = sample_mean(m_temperature_sum, m_sample_count);
+    humidity = sample_mean(m_humidity_sum, m_sample_count);
+    sample_mean_reset();
 
-    // Build and set advertising data.
-    memset(&advdata, 0, sizeof(advdata));
-    advdata.p_service_data_array = &service_data;
-    advdata.service_data_count   = 1;
+    printf("%s(%d) temperature:%d\n", __func__, __LINE__, temperature);
+    printf("%s(%d) humidity:%d\n", __func__, __LINE__, humidity);
 
-    ret_code_t err_code = ble_advdata_encode(&advdata, m_adv_data.adv_data.p_data, &m_adv_data.adv_data.len);
-    APP_ERROR_CHECK(err_code);
-    NRF_LOG_INFO("[adv]len=%d", m_adv_data.adv_data.len);
-    NRF_LOG_HEXDUMP_INFO(m_adv_data.adv_data.p_data, m_adv_data.adv_data.len);
+    SampleHistory_Add(temperature, humidity);
+#if RADIO_SYNC_ENABLED
+    RadioSync_OnSampleDone(Advertising_SetReadings(temperature, humidity));
+#else
+    Advertising_SetReadings(temperature, humidity);
+#endif
+#if ADVERTISING_ROTATION_ENABLED
+    health_update();
+#endif
+#if ADV_POLICY_ENABLED
+    if (AdvPolicy_Update(temperature, humidity)) {
+        uint32_t intervalMs = AdvPolicy_GetIntervalMs(AdvPolicy_GetClass());
+        Advertising_SetInterval(MSEC_TO_UNITS(intervalMs, UNIT_0_625_MS));
+#if RADIO_SYNC_ENABLED
+        RadioSync_SetInterval(Advertising_GetInterval());
+#endif
+        NRF_LOG_INFO("[adv]interval=%dms", intervalMs);
+    }
+#endif
+
+    ADVERTISING_STATS advStats;
+    Advertising_GetStats(&advStats);
+    NRF_LOG_INFO("[adv]updates=%d skipped=%d failures=%d max=%dcycles mean=%dcycles", advStats.mUpdateCount, advStats.mSkippedCount, advStats.mFailureCount, advStats.mMaxCycles, advStats.mMeanCycles);
+#if ADV_POLICY_ENABLED
+    ADV_POLICY_STATS policyStats;
+    AdvPolicy_GetStats(&policyStats);
+    NRF_LOG_INFO("[adv]rate=%d restarts=%d estimate=%duAh/day", policyStats.mChangeRate, advStats.mRestartCount, AdvPolicy_EstimateMicroAhPerDay());
+#endif
+#if BEACON_CRYPTO_ENABLED
+    NRF_LOG_INFO("[adv]seal max=%dus mean=%dus", CycleCounter_ToUs(advStats.mMaxSealCycles), CycleCounter_ToUs(advStats.mMeanSealCycles));
+#endif
+    NRF_LOG_INFO("[isr]twi max=%dus", CycleCounter_ToUs(SHT31_GetMaxIsrCycles()));
+#if RADIO_SYNC_ENABLED
+    RADIO_SYNC_STATS syncStats;
+    RadioSync_GetStats(&syncStats);
+    NRF_LOG_INFO("[sync]aligned=%d deadline=%d measure=%dus", syncStats.mAlignedCount, syncStats.mDeadlineCount, syncStats.mMeasureUs);
+    NRF_LOG_INFO("[sync]sample-to-air max=%dus mean=%dus", syncStats.mMaxLatencyUs, syncStats.mMeanLatencyUs);
+#endif
+#if ADVERTISING_ROTATION_ENABLED
+    FRAME_ROTATION_STATS rotationStats;
+    FrameRotation_GetStats(&rotationStats);
+    NRF_LOG_INFO("[adv]frames readings=%d statistics=%d health=%d deferred=%d", rotationStats.mFrameCount[FRAME_ROTATION_READINGS],
+                 rotationStats.mFrameCount[FRAME_ROTATION_STATISTICS], rotationStats.mFrameCount[FRAME_ROTATION_HEALTH], rotationStats.mDeferredCount);
+#endif
+#if RADIO_PROFILE_ENABLED
+    RADIO_PROFILE_STATS profileStats;
+    RadioProfile_GetStats(&profileStats);
+    NRF_LOG_INFO("[radio]profile=%s changes=%d events dense=%d standard=%d sparse=%d", RadioProfile_GetConfig(profileStats.mProfile)->mpName,
+                 profileStats.mChangeCount, profileStats.mEventCount[RADIO_PROFILE_DENSE], profileStats.mEventCount[RADIO_PROFILE_STANDARD], profileStats.mEventCount[RADIO_PROFILE_SPARSE]);
+    NRF_LOG_INFO("[radio]spent dense=%duAh standard=%duAh sparse=%duAh", RadioProfile_EstimateMicroAh(RADIO_PROFILE_DENSE),
+                 RadioProfile_EstimateMicroAh(RADIO_PROFILE_STANDARD), RadioProfile_EstimateMicroAh(RADIO_PROFILE_SPARSE));
+    NRF_LOG_INFO("[radio]at %dms dense=%duAh/day standard=%duAh/day sparse=%duAh/day", Advertising_GetInterval() * 625 / 1000,
+                 RadioProfile_EstimateMicroAhPerDay(RADIO_PROFILE_DENSE, Advertising_GetInterval()), RadioProfile_EstimateMicroAhPerDay(RADIO_PROFILE_STANDARD, Advertising_GetInterval()),
+                 RadioProfile_EstimateMicroAhPerDay(RADIO_PROFILE_SPARSE, Advertising_GetInterval()));
+#endif
+#if ENV_SENSING_ENABLED
+    CONNECTION_STATS connStats;
+    ENV_SENSING_STATS essStats;
+    Connection_GetStats(&connStats);
+    EnvSensing_GetStats(&essStats);
+    NRF_LOG_INFO("[ble]connections=%d interval=%dus notified=%d dropped=%d", connStats.mConnectCount, connStats.mIntervalUs, essStats.mNotifiedCount, essStats.mDroppedCount);
+#endif
+#if HISTORY_TRANSFER_ENABLED
+    HISTORY_TRANSFER_STATS transferStats;
+    HistoryTransfer_GetStats(&transferStats);
+    NRF_LOG_INFO("[ble]mtu=%d length=%d phy=%d transfers=%d aborted=%d", connStats.mAttMtu, connStats.mDataLength, connStats.mTxPhy, transferStats.mTransferCount, transferStats.mAbortedCount);
+    NRF_LOG_INFO("[ble]last transfer samples=%d bytes=%d time=%dms throughput=%dbps", transferStats.mSampleCount, transferStats.mByteCount, transferStats.mDurationMs, transferStats.mThroughputBps);
+#endif
+
+    TIMER_PERIODIC_STATS stats;
+    TimerManager_GetPeriodicStats(m_main_timer, &stats);
+    NRF_LOG_INFO("[timer]count=%d missed=%d late max=%d mean=%d", stats.mCount, stats.mMissedCount, stats.mMaxLatenessTicks, stats.mMeanLatenessTicks);
+#if TASK_SCHEDULER_STATS_LOG_ENABLED
+    TaskScheduler_DumpStats();
+#endif
+#if TIMER_MANAGER_PROFILER_ENABLED
+    TimerManager_DumpProfiles();
+#endif
 }
 
 /**@brief Callback function for asserts in the SoftDevice.
@@ -165,31 +327,56 @@ void assert_nrf_callback(uint16_t line_num, const uint8_t * p_file_name)
     app_error_handler(DEAD_BEEF, line_num, p_file_name);
 }
 
-/**@brief Function for initializing the Advertising functionality.
- *
- * @details Encodes the required advertising data and passes it to the stack.
- *          Also builds a structure to be passed to the stack when starting advertising.
- */
-static void advertising_init(void)
+static void advertising_update(void)
 {
-    ret_code_t      err_code;
-
-    // Initialize advertising parameters (used when starting advertising).
-    memset(&m_adv_params, 0, sizeof(m_adv_params));
-
-    m_adv_params.properties.type = BLE_GAP_ADV_TYPE_NONCONNECTABLE_NONSCANNABLE_UNDIRECTED;
-    m_adv_params.p_peer_addr     = NULL;    // Undirected advertisement.
-    m_adv_params.filter_policy   = BLE_GAP_ADV_FP_ANY;
-    m_adv_params.interval        = NON_CONNECTABLE_ADV_INTERVAL;
-    m_adv_params.duration        = 0;       // Never time out.
+    SHT31_GetValue(onSensorDataReceived);
+}
 
-    err_code = sd_ble_gap_adv_set_configure(&m_adv_handle, &m_adv_data, &m_adv_params);
-    APP_ERROR_CHECK(err_code);
+/**@brief Function for handling the sampling timer. Only wakes up the application task.
+ */
+static void sampling_timer_handler(void *pContext)
+{
+    UNUSED_PARAMETER(pContext);
+    TaskScheduler_Post(m_app_task, APP_EVT_SAMPLE);
 }
 
-static void advertising_update(void)
+/**@brief Function for handling the application task events.
+ */
+static void app_task(void *pContext, uint32_t events)
 {
-    SHT31_GetValue(onSensorDataReceived);
+    UNUSED_PARAMETER(pContext);
+
+#if ENV_SENSING_ENABLED
+    if (events & APP_EVT_CONNECTED)
+    {
+        m_is_connected = true;
+        sample_mean_reset();
+        TimerManager_SetPeriod(m_main_timer, TIMER_CONNECTED_MS);
+#if RADIO_SYNC_ENABLED
+        RadioSync_SetMode(RADIO_SYNC_MODE_OFF);
+#endif
+        ret_code_t err_code = bsp_indication_set(BSP_INDICATE_CONNECTED);
+        APP_ERROR_CHECK(err_code);
+    }
+    if (events & APP_EVT_DISCONNECTED)
+    {
+        m_is_connected = false;
+        sample_mean_reset();
+        TimerManager_SetPeriod(m_main_timer, TIMER_FUNCTION_MS);
+#if RADIO_SYNC_ENABLED
+        RadioSync_SetMode(RADIO_SYNC_MODE_ALIGNED);
+#endif
+        advertising_start();
+    }
+#endif
+    if (events & APP_EVT_SAMPLE)
+    {
+#if RADIO_SYNC_ENABLED
+        RadioSync_RequestSample();
+#else
+        advertising_update();
+#endif
+    }
 }
 
 /**@brief Function for starting advertising.
@@ -198,13 +385,21 @@ static void advertising_start(void)
 {
     ret_code_t err_code;
 
-    err_code = sd_ble_gap_adv_start(m_adv_handle, APP_BLE_CONN_CFG_TAG);
-    APP_ERROR_CHECK(err_code);
+    Advertising_Start(APP_BLE_CONN_CFG_TAG);
 
     err_code = bsp_indication_set(BSP_INDICATE_ADVERTISING);
     APP_ERROR_CHECK(err_code);
 }
 
+#if ENV_SENSING_ENABLED
+/**@brief Function for handling the connection events. Runs in the SoftDevice interrupt, only wakes up the application task.
+ */
+static void connection_handler(CONNECTION_EVT event)
+{
+    TaskScheduler_Post(m_app_task, (event == CONNECTION_EVT_CONNECTED) ? APP_EVT_CONNECTED : APP_EVT_DISCONNECTED);
+}
+#endif
+
 
 /**@brief Function for initializing the BLE stack.
  *
@@ -222,6 +417,9 @@ static void ble_stack_init(void)
     uint32_t ram_start = 0;
     err_code = nrf_sdh_ble_default_cfg_set(APP_BLE_CONN_CFG_TAG, &ram_start);
     APP_ERROR_CHECK(err_code);
+#if ENV_SENSING_ENABLED
+    Connection_ConfigureStack(APP_BLE_CONN_CFG_TAG, ram_start);
+#endif
 
     // Enable BLE stack.
     err_code = nrf_sdh_ble_enable(&ram_start);
@@ -247,12 +445,29 @@ static void power_management_init(void)
 }
 
 
+/**@brief Function for initializing the event scheduler.
+ */
+static void scheduler_init(void)
+{
+#if DEFERRED_EXECUTION_ENABLED
+    APP_SCHED_INIT(SCHED_MAX_EVENT_DATA_SIZE, SCHED_QUEUE_SIZE);
+#endif
+}
+
 /**@brief Function for handling the idle state (main loop).
  *
- * @details If there is no pending log operation, then sleep until next the next event occurs.
+ * @details Executes the events deferred from interrupt context first, then one runnable task.
+ *          If no task is runnable and there is no pending log operation, then sleep until next the next event occurs.
  */
 static void idle_state_handle(void)
 {
+#if DEFERRED_EXECUTION_ENABLED
+    app_sched_execute();
+#endif
+    if (TaskScheduler_RunNext())
+    {
+        return;
+    }
     if (NRF_LOG_PROCESS() == false)
     {
         nrf_pwr_mgmt_run();
@@ -266,15 +481,45 @@ int main(void)
 {
     // Initialize.
     log_init();
+    CycleCounter_Init();
+    scheduler_init();
+    TaskScheduler_Init();
     TimerManager_Init();
+    TimerWheel_Init();
     power_management_init();
     ble_stack_init();
-    advertising_init();
+#if ENV_SENSING_ENABLED
+    Connection_Init(connection_handler);
+    EnvSensing_Init();
+#endif
+#if HISTORY_TRANSFER_ENABLED
+    HistoryTransfer_Init();
+#endif
+    SampleHistory_Init();
+    Advertising_Init();
+#if ADV_POLICY_ENABLED
+    AdvPolicy_Init();
+#endif
+#if ADVERTISING_BENCHMARK_ENABLED
+    Advertising_Benchmark(100);
+#endif
+#if RADIO_PROFILE_ENABLED
+    RadioProfile_Init();
+    radio_profile_set(RADIO_PROFILE_DEFAULT);
+#endif
+#if RADIO_SYNC_ENABLED
+    RadioSync_Init(advertising_update, Advertising_GetInterval());
+    RadioSync_SetEventHandler(advertising_event_handler);
+#endif
+#if ADVERTISING_ROTATION_ENABLED
+    m_uptime_mark = TimerManager_GetTicks();
+#endif
     SHT31_Init();
 
-    TimerManager_Register(&TIMER_ID_MAIN, advertising_update, APP_TIMER_MODE_REPEATED);
+    m_app_task = TaskScheduler_Create(app_task, NULL, APP_TASK_PRIORITY);
+
     advertising_start();
-    TimerManager_Start(&TIMER_ID_MAIN, TIMER_FUNCTION_MS, NULL);
+    m_main_timer = TimerManager_StartPeriodic(sampling_timer_handler, TIMER_FUNCTION_MS, TIMER_MISSED_POLICY_SKIP, NULL);
 
     // Enter main loop.
     while (true)
@@ -0,0 +1,393 @@
+#ifndef APP_CONFIG_H
+#define APP_CONFIG_H
+// <<< Use Configuration Wizard in Context Menu >>>\n
+
+// <h> Application
+
+//==========================================================
+// <e> DEFERRED_EXECUTION_ENABLED - Run timer handlers from the main loop
+// <i> app_timer interrupts only enqueue events to app_scheduler.
+// <i> The work is executed by app_sched_execute() before the CPU goes to sleep.
+// <i> The timer callbacks and the TWI handler only post task events, the sensor and advertising work runs
+// <i> in tasks in either mode, so this only moves the TimerManager dispatch out of the RTC1 interrupt.
+// <i> The longest TWI handler is logged as [isr], the timer callbacks by TIMER_MANAGER_PROFILER_ENABLED.
+// <i> The SoftDevice interrupts have a higher priority than any of these and are not delayed by either
+// <i> mode; the delay of SoftDevice events to the application is not measured. Off until it is, on target.
+//==========================================================
+#ifndef DEFERRED_EXECUTION_ENABLED
+#define DEFERRED_EXECUTION_ENABLED 0
+#endif
+// <o> DEFERRED_QUEUE_SIZE - Maximum number of events queued in the scheduler.
+#ifndef DEFERRED_QUEUE_SIZE
+#define DEFERRED_QUEUE_SIZE 8
+#endif
+
+// </e>
+
+// <e> TIMER_MANAGER_PROFILER_ENABLED - Measure runtime and lateness of every timer callback
+// <i> Enabled in Debug builds by default and compiled out in Release builds.
+//==========================================================
+#ifndef TIMER_MANAGER_PROFILER_ENABLED
+#ifdef DEBUG
+#define TIMER_MANAGER_PROFILER_ENABLED 1
+#else
+#define TIMER_MANAGER_PROFILER_ENABLED 0
+#endif
+#endif
+// <o> TIMER_MANAGER_PROFILE_COUNT - Maximum number of distinct callbacks profiled.
+#ifndef TIMER_MANAGER_PROFILE_COUNT
+#define TIMER_MANAGER_PROFILE_COUNT 8
+#endif
+
+// </e>
+
+// <q> TASK_SCHEDULER_STATS_LOG_ENABLED  - Print the runs and CPU time of every task with each published sample
+// <i> Enabled in Debug builds by default. TaskScheduler_GetStats keeps the accounting available either way.
+#ifndef TASK_SCHEDULER_STATS_LOG_ENABLED
+#ifdef DEBUG
+#define TASK_SCHEDULER_STATS_LOG_ENABLED 1
+#else
+#define TASK_SCHEDULER_STATS_LOG_ENABLED 0
+#endif
+#endif
+
+// <h> Advertising deadband - Readings closer than this to the ones on air do not update the advertising data
+//==========================================================
+// <o> ADVERTISING_DEADBAND_TEMPERATURE - Temperature deadband in 0.01 degC.
+#ifndef ADVERTISING_DEADBAND_TEMPERATURE
+#define ADVERTISING_DEADBAND_TEMPERATURE 5
+#endif
+// <o> ADVERTISING_DEADBAND_HUMIDITY - Humidity deadband in 0.01 %RH.
+#ifndef ADVERTISING_DEADBAND_HUMIDITY
+#define ADVERTISING_DEADBAND_HUMIDITY 20
+#endif
+// <o> ADVERTISING_MAX_AGE_S - Readings older than this are refreshed even within the deadband <1-1023>.
+#ifndef ADVERTISING_MAX_AGE_S
+#define ADVERTISING_MAX_AGE_S 60
+#endif
+
+// </h>
+
+// <h> Device information
+//==========================================================
+// <o> DEVICE_IDENTIFIER - Identifier of the device in the service data, 32 bits.
+// <i> 0x11223344 is a placeholder shared by every device built with it. Give each device its own value,
+// <i> e.g. -DDEVICE_IDENTIFIER=0x... when building its image. Required by BEACON_CRYPTO_ENABLED.
+#ifndef DEVICE_IDENTIFIER
+#define DEVICE_IDENTIFIER 0x11223344
+#endif
+// <o> FIRMWARE_VERSION_MAJOR - Major firmware version <0-255>.
+#ifndef FIRMWARE_VERSION_MAJOR
+#define FIRMWARE_VERSION_MAJOR 1
+#endif
+// <o> FIRMWARE_VERSION_MINOR - Minor firmware version <0-255>.
+#ifndef FIRMWARE_VERSION_MINOR
+#define FIRMWARE_VERSION_MINOR 0
+#endif
+// <o> FIRMWARE_VERSION_PATCH - Patch firmware version <0-255>.
+#ifndef FIRMWARE_VERSION_PATCH
+#define FIRMWARE_VERSION_PATCH 0
+#endif
+// <o> SENSOR_TEMPERATURE_OFFSET - Added to every temperature reading, in 0.01 degC.
+#ifndef SENSOR_TEMPERATURE_OFFSET
+#define SENSOR_TEMPERATURE_OFFSET 0
+#endif
+// <o> SENSOR_HUMIDITY_OFFSET - Added to every humidity reading, in 0.01 %RH.
+#ifndef SENSOR_HUMIDITY_OFFSET
+#define SENSOR_HUMIDITY_OFFSET 0
+#endif
+
+// </h>
+
+// <h> Rates - Sampling, publishing and advertising run at independent rates
+// <i> The sensor is read every SAMPLE_INTERVAL_MS. Every PUBLISH_INTERVAL_MS the mean of the samples taken
+// <i> since the previous publication goes to the history and the advertised frame. The radio advertises the
+// <i> frame every ADVERTISING_INTERVAL_MS. Inconsistent combinations fail the build.
+//==========================================================
+// <o> SAMPLE_INTERVAL_MS - Interval between two measurements <20-65535>.
+// <i> A measurement takes 16 ms.
+#ifndef SAMPLE_INTERVAL_MS
+#define SAMPLE_INTERVAL_MS 1000
+#endif
+// <o> PUBLISH_INTERVAL_MS - Interval between two published samples, a multiple of SAMPLE_INTERVAL_MS <20-65535>.
+// <i> Also the interval of the history, sent in the device metadata.
+#ifndef PUBLISH_INTERVAL_MS
+#define PUBLISH_INTERVAL_MS 1000
+#endif
+// <o> ADVERTISING_INTERVAL_MS - Interval between two advertising events <100-10240>.
+// <i> Used as is without ADV_POLICY_ENABLED, the policy picks its own intervals otherwise. Every published
+// <i> sample must be on air at least once, in the readings or in the history the frame carries.
+#ifndef ADVERTISING_INTERVAL_MS
+#define ADVERTISING_INTERVAL_MS 100
+#endif
+
+// </h>
+
+// <e> ADVERTISING_HISTORY_ENABLED - Advertise the newest samples instead of the latest readings only
+// <i> The frame carries as many samples as fit the advertising data, so that a gateway missing
+// <i> some frames can still fill the gaps. The history frames have their own data types, so
+// <i> gateways must know them before this is turned on.
+//==========================================================
+#ifndef ADVERTISING_HISTORY_ENABLED
+#define ADVERTISING_HISTORY_ENABLED 0
+#endif
+// <q> ADVERTISING_HISTORY_COMPRESSED  - Encode the samples as differences, to fit up to 16 samples instead of 5 in a legacy frame
+#ifndef ADVERTISING_HISTORY_COMPRESSED
+#define ADVERTISING_HISTORY_COMPRESSED 0
+#endif
+// <o> SAMPLE_HISTORY_SIZE - Number of samples kept in RAM, a power of 2.
+#ifndef SAMPLE_HISTORY_SIZE
+#define SAMPLE_HISTORY_SIZE 32
+#endif
+
+// </e>
+
+// <e> ADVERTISING_EXTENDED_ENABLED - Use BLE 5 extended advertising, for larger frames and the Coded PHY
+// <i> Only scanners supporting BLE 5 extended advertising receive the frames.
+//==========================================================
+#ifndef ADVERTISING_EXTENDED_ENABLED
+#define ADVERTISING_EXTENDED_ENABLED 0
+#endif
+// <o> ADVERTISING_PRIMARY_PHY  - PHY of the advertising indications on the primary channels
+// <1=> 1 Mbps
+// <4=> Coded (S8)
+#ifndef ADVERTISING_PRIMARY_PHY
+#define ADVERTISING_PRIMARY_PHY 1
+#endif
+// <o> ADVERTISING_SECONDARY_PHY  - PHY of the frame carrying the advertising data
+// <1=> 1 Mbps
+// <2=> 2 Mbps
+// <4=> Coded (S8)
+#ifndef ADVERTISING_SECONDARY_PHY
+#define ADVERTISING_SECONDARY_PHY 1
+#endif
+// <o> ADVERTISING_EXTENDED_DATA_SIZE - Size of the advertising data in bytes <31-255>.
+// <i> Every byte costs 8 us of air time on 1 Mbps and 64 us on Coded (S8).
+// <i> Connectable sets, with ENV_SENSING_ENABLED, take at most 238 bytes.
+#ifndef ADVERTISING_EXTENDED_DATA_SIZE
+#define ADVERTISING_EXTENDED_DATA_SIZE 64
+#endif
+
+// </e>
+
+// <e> ADVERTISING_SCANNABLE_ENABLED - Send the device metadata in a scan response instead of every advertisement
+// <i> The advertisement keeps the readings and a 2-byte identifier. The full identifier, the firmware version,
+// <i> the publishing interval and the calibration offsets are sent only to scanners asking for them.
+// <i> Requires legacy advertising.
+//==========================================================
+#ifndef ADVERTISING_SCANNABLE_ENABLED
+#define ADVERTISING_SCANNABLE_ENABLED 0
+#endif
+
+// </e>
+
+// <e> BEACON_CRYPTO_ENABLED - Encrypt the readings and authenticate the frames with AES-CCM
+// <i> The frame carries a 4-byte counter and a 4-byte MIC. The device key is derived from
+// <i> BEACON_CRYPTO_MASTER_KEY and DEVICE_IDENTIFIER, which must not be left at the placeholder.
+//==========================================================
+#ifndef BEACON_CRYPTO_ENABLED
+#define BEACON_CRYPTO_ENABLED 0
+#endif
+// BEACON_CRYPTO_MASTER_KEY - Fleet master key, 16 bytes, with no default: a key written here would be in the
+// sources of every build. Pass it when building, e.g. -DBEACON_CRYPTO_MASTER_KEY=0x.., 0x.., ... (16 bytes).
+
+// </e>
+
+// <e> ENV_SENSING_ENABLED - Accept connections and stream the readings in the Environmental Sensing Service
+// <i> Advertising becomes connectable, stops while a central is connected and resumes on disconnection.
+// <i> While connected the sensor is sampled every ENV_SENSING_SAMPLE_INTERVAL_MS and every sample is
+// <i> notified; the history and the advertised frame keep one sample every PUBLISH_INTERVAL_MS.
+// <i> Build it with the "Release GATT" or "Debug GATT" configuration of the SES project, which enables
+// <i> HISTORY_TRANSFER_ENABLED too and moves the application RAM up for the SoftDevice.
+//==========================================================
+#ifndef ENV_SENSING_ENABLED
+#define ENV_SENSING_ENABLED 0
+#endif
+// <o> ENV_SENSING_SAMPLE_INTERVAL_MS - Interval between two measurements while connected, a divisor of PUBLISH_INTERVAL_MS <20-1000>.
+// <i> A measurement takes 16 ms, so the sensor cannot be read faster than 50 Hz.
+#ifndef ENV_SENSING_SAMPLE_INTERVAL_MS
+#define ENV_SENSING_SAMPLE_INTERVAL_MS 50
+#endif
+// <q> HISTORY_TRANSFER_ENABLED  - Serve the sample history in bulk to a central asking for it
+// <i> Negotiates a 247-byte ATT MTU, 251-byte packets and the 2 Mbps PHY, and sends up to 60 samples per
+// <i> notification. Set SAMPLE_HISTORY_SIZE to the depth to keep, 4096 samples take 16 kB.
+#ifndef HISTORY_TRANSFER_ENABLED
+#define HISTORY_TRANSFER_ENABLED 0
+#endif
+
+// </e>
+
+// <e> ADV_POLICY_ENABLED - Adapt the advertising interval to the change rate of the readings and to the battery level
+// <i> Off by default: the beacon keeps ADVERTISING_INTERVAL_MS. On, the interval moves between the fast and
+// <i> the slow one and advertising restarts at every change, which gateways timing out sensors must allow for.
+//==========================================================
+#ifndef ADV_POLICY_ENABLED
+#define ADV_POLICY_ENABLED 0
+#endif
+// <o> ADV_POLICY_FAST_INTERVAL_MS - Interval while the readings are moving <100-10240>.
+#ifndef ADV_POLICY_FAST_INTERVAL_MS
+#define ADV_POLICY_FAST_INTERVAL_MS 100
+#endif
+// <o> ADV_POLICY_NORMAL_INTERVAL_MS - Interval while the readings drift slowly <100-10240>.
+#ifndef ADV_POLICY_NORMAL_INTERVAL_MS
+#define ADV_POLICY_NORMAL_INTERVAL_MS 1000
+#endif
+// <o> ADV_POLICY_SLOW_INTERVAL_MS - Interval while the readings are stable or the battery is low <100-10240>.
+#ifndef ADV_POLICY_SLOW_INTERVAL_MS
+#define ADV_POLICY_SLOW_INTERVAL_MS 5000
+#endif
+// <o> ADV_POLICY_FAST_THRESHOLD - Percentage of samples leaving the deadband at or above which the fast interval is used, left below half of it <1-100>.
+#ifndef ADV_POLICY_FAST_THRESHOLD
+#define ADV_POLICY_FAST_THRESHOLD 20
+#endif
+// <o> ADV_POLICY_SLOW_THRESHOLD - Percentage of samples leaving the deadband at or below which the slow interval is used, left above twice it <0-100>.
+#ifndef ADV_POLICY_SLOW_THRESHOLD
+#define ADV_POLICY_SLOW_THRESHOLD 2
+#endif
+// <o> ADV_POLICY_HOLD_SAMPLES - Samples a slower class must be called for before it applies.
+#ifndef ADV_POLICY_HOLD_SAMPLES
+#define ADV_POLICY_HOLD_SAMPLES 30
+#endif
+// <o> ADV_POLICY_LOW_BATTERY_PERCENT - Battery level at or below which the fast interval is not used.
+#ifndef ADV_POLICY_LOW_BATTERY_PERCENT
+#define ADV_POLICY_LOW_BATTERY_PERCENT 20
+#endif
+// <o> ADV_POLICY_CRITICAL_BATTERY_PERCENT - Battery level at or below which only the slow interval is used.
+#ifndef ADV_POLICY_CRITICAL_BATTERY_PERCENT
+#define ADV_POLICY_CRITICAL_BATTERY_PERCENT 10
+#endif
+// <o> ADV_POLICY_ADV_EVENT_CHARGE_NC - Charge of one advertising event on three channels, for the energy estimate.
+#ifndef ADV_POLICY_ADV_EVENT_CHARGE_NC
+#define ADV_POLICY_ADV_EVENT_CHARGE_NC 10000
+#endif
+// <o> ADV_POLICY_SLEEP_CURRENT_NA - System ON sleep current, for the energy estimate.
+#ifndef ADV_POLICY_SLEEP_CURRENT_NA
+#define ADV_POLICY_SLEEP_CURRENT_NA 3000
+#endif
+
+// </e>
+
+// <e> RADIO_SYNC_ENABLED - Time the measurements from the advertising events
+// <i> The SoftDevice radio notification tells when the advertising events start, so each measurement
+// <i> completes just ahead of one instead of anywhere within the advertising interval before it.
+//==========================================================
+#ifndef RADIO_SYNC_ENABLED
+#define RADIO_SYNC_ENABLED 0
+#endif
+// <o> RADIO_SYNC_MEASURE_MS - Time from the start of a measurement to its readings, until the longest one is measured.
+#ifndef RADIO_SYNC_MEASURE_MS
+#define RADIO_SYNC_MEASURE_MS 20
+#endif
+// <o> RADIO_SYNC_GUARD_MS - Margin between the readings and the advertising event <1-20>.
+#ifndef RADIO_SYNC_GUARD_MS
+#define RADIO_SYNC_GUARD_MS 2
+#endif
+
+// </e>
+
+// <e> ADVERTISING_ROTATION_ENABLED - Interleave statistics and health frames with the readings
+// <i> Each frame is written once when it is due and handed over for a single advertising event, the readings
+// <i> take the remaining events. Requires RADIO_SYNC_ENABLED, the radio notification marks the events.
+//==========================================================
+#ifndef ADVERTISING_ROTATION_ENABLED
+#define ADVERTISING_ROTATION_ENABLED 0
+#endif
+// <o> ADVERTISING_ROTATION_STATISTICS_EVERY - Advertising events between two statistics frames, 0 for none <0-65535>
+#ifndef ADVERTISING_ROTATION_STATISTICS_EVERY
+#define ADVERTISING_ROTATION_STATISTICS_EVERY 10
+#endif
+// <o> ADVERTISING_ROTATION_HEALTH_EVERY - Advertising events between two health frames, 0 for none <0-65535>
+#ifndef ADVERTISING_ROTATION_HEALTH_EVERY
+#define ADVERTISING_ROTATION_HEALTH_EVERY 60
+#endif
+// <o> ADVERTISING_STATISTICS_WINDOW - Published samples in each window of the statistics frame <1-65535>
+#ifndef ADVERTISING_STATISTICS_WINDOW
+#define ADVERTISING_STATISTICS_WINDOW 60
+#endif
+
+// </e>
+
+// <e> RADIO_PROFILE_ENABLED - Advertising channels and transmit power by deployment
+// <i> With a gateway close to every sensor, fewer channels at a lower power save charge; with gateways far
+// <i> apart, every channel at the highest power reaches them. The charge of the advertising events is
+// <i> estimated for each profile, from the events counted by RADIO_SYNC_ENABLED, which it requires.
+//==========================================================
+#ifndef RADIO_PROFILE_ENABLED
+#define RADIO_PROFILE_ENABLED 0
+#endif
+// <o> RADIO_PROFILE_DEFAULT - Profile applied at startup
+// <0=> Dense
+// <1=> Standard
+// <2=> Sparse
+#ifndef RADIO_PROFILE_DEFAULT
+#define RADIO_PROFILE_DEFAULT 1
+#endif
+// <o> RADIO_PROFILE_DENSE_CHANNELS - Primary channels of the dense profile
+// <1=> 37
+// <2=> 38
+// <4=> 39
+// <3=> 37 and 38
+// <5=> 37 and 39
+// <6=> 38 and 39
+// <7=> 37, 38 and 39
+#ifndef RADIO_PROFILE_DENSE_CHANNELS
+#define RADIO_PROFILE_DENSE_CHANNELS 3
+#endif
+// <o> RADIO_PROFILE_DENSE_TX_POWER - Transmit power of the dense profile
+// <-40=> -40 dBm
+// <-20=> -20 dBm
+// <-16=> -16 dBm
+// <-12=> -12 dBm
+// <-8=> -8 dBm
+// <-4=> -4 dBm
+// <0=> 0 dBm
+#ifndef RADIO_PROFILE_DENSE_TX_POWER
+#define RADIO_PROFILE_DENSE_TX_POWER -8
+#endif
+// <o> RADIO_PROFILE_SPARSE_TX_POWER - Transmit power of the sparse profile
+// <0=> 0 dBm
+// <2=> +2 dBm
+// <3=> +3 dBm
+// <4=> +4 dBm
+// <5=> +5 dBm
+// <6=> +6 dBm
+// <7=> +7 dBm
+// <8=> +8 dBm
+#ifndef RADIO_PROFILE_SPARSE_TX_POWER
+#define RADIO_PROFILE_SPARSE_TX_POWER 8
+#endif
+// <o> RADIO_PROFILE_EVENT_OVERHEAD_NC - Charge of an advertising event besides the transmissions, for the energy estimate.
+#ifndef RADIO_PROFILE_EVENT_OVERHEAD_NC
+#define RADIO_PROFILE_EVENT_OVERHEAD_NC 2300
+#endif
+
+// </e>
+
+// <q> ADVERTISING_BENCHMARK_ENABLED  - Compare full encoding with in-place patching of the advertising data at startup
+
+#ifndef ADVERTISING_BENCHMARK_ENABLED
+#define ADVERTISING_BENCHMARK_ENABLED 0
+#endif
+
+// </h>
+//==========================================================
+
+// <h> SDK overrides
+
+//==========================================================
+#define APP_TIMER_CONFIG_USE_SCHEDULER DEFERRED_EXECUTION_ENABLED
+#if ENV_SENSING_ENABLED
+#define NRF_SDH_BLE_PERIPHERAL_LINK_COUNT 1
+#endif
+#if HISTORY_TRANSFER_ENABLED
+#define NRF_SDH_BLE_GATT_MAX_MTU_SIZE 247
+#define NRF_SDH_BLE_GAP_DATA_LENGTH 251
+#define NRF_SDH_BLE_GAP_EVENT_LENGTH 320
+#define NRF_SDH_BLE_VS_UUID_COUNT 1
+#endif
+
+// </h>
+//==========================================================
+
+// <<< end of configuration section >>>
+#endif //APP_CONFIG_H